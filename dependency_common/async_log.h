@@ -0,0 +1,288 @@
+#ifndef DEPENDENCY_COMMON_ASYNC_LOG
+#define DEPENDENCY_COMMON_ASYNC_LOG
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// <summary>
+/// Structure which represents a single log record. Records are fixed size and
+/// hold no owned memory, so the replay thread only copies them into the ring
+/// buffer, and all of the formatting happens on the logging thread.
+/// </summary>
+struct LogRecord {
+	uint16_t type;                             // Plugin defined Record Type
+	const char *event;                         // Static Name of the Event
+	uint64_t values[4];                        // Plugin defined Values
+};
+
+/// <summary>
+/// Class which writes log records from the replay thread asynchronously. The
+/// replay thread pushes records into a single producer, single consumer ring
+/// buffer without locking or blocking; a background thread drains the ring
+/// buffer, formats the records and writes them to its output stream, which
+/// is the standard output unless set otherwise, in batches, with one flush
+/// per batch. If the ring buffer is full, the record is dropped and counted
+/// rather than stalling the replay, unless the record must not be lost, in
+/// which case the replay thread waits for the logging thread to make room.
+///
+/// A log which is not started formats and writes each record right away, on
+/// the thread which pushes it.
+/// </summary>
+class AsyncLog {
+public:
+	/// <summary>
+	/// Function which appends the text of a record, including its trailing
+	/// newline, to a string.
+	/// </summary>
+	typedef void (*Formatter)(const LogRecord&, std::string&);
+
+	/// <summary>
+	/// Creates a new Async Log, which is not started, and which formats its
+	/// records with the specified function.
+	/// </summary>
+	/// <param name="formatter">
+	/// The function which formats the records.
+	/// </param>
+	AsyncLog(Formatter formatter) {
+		this->formatter = formatter;
+		this->output = &std::cout;
+		this->capacity = 0;
+		this->head = 0;
+		this->tail = 0;
+		this->running = false;
+		this->dropped = 0;
+		this->waits = 0;
+		this->highWater = 0;
+		this->batches = 0;
+		this->written = 0;
+	}
+
+	/// <summary>
+	/// Copying of Async Log instances is forbidden.
+	/// </summary>
+	AsyncLog(const AsyncLog&) = delete;
+
+	/// <summary>
+	/// Stops the logging thread, if it is running.
+	/// </summary>
+	~AsyncLog() {
+		this->stop();
+	}
+
+	/// <summary>
+	/// Returns the number of batches written by the logging thread.
+	/// </summary>
+	/// <returns>
+	/// The number of batches.
+	/// </returns>
+	uint64_t getBatches() const {
+		return this->batches;
+	}
+
+	/// <summary>
+	/// Returns the capacity of the ring buffer, in records, which is zero if
+	/// the log was not started.
+	/// </summary>
+	/// <returns>
+	/// The capacity of the ring buffer.
+	/// </returns>
+	size_t getCapacity() const {
+		return this->capacity;
+	}
+
+	/// <summary>
+	/// Returns the number of records which were dropped since the ring buffer
+	/// was full.
+	/// </summary>
+	/// <returns>
+	/// The number of dropped records.
+	/// </returns>
+	uint64_t getDropped() const {
+		return this->dropped;
+	}
+
+	/// <summary>
+	/// Returns the largest number of records which were queued in the ring
+	/// buffer at once.
+	/// </summary>
+	/// <returns>
+	/// The high water mark of the ring buffer.
+	/// </returns>
+	size_t getHighWater() const {
+		return this->highWater;
+	}
+
+	/// <summary>
+	/// Returns the number of records for which the pushing thread waited for
+	/// room in the ring buffer, instead of dropping them.
+	/// </summary>
+	/// <returns>
+	/// The number of records waited for.
+	/// </returns>
+	uint64_t getWaits() const {
+		return this->waits;
+	}
+
+	/// <summary>
+	/// Returns the number of records which were written.
+	/// </summary>
+	/// <returns>
+	/// The number of written records.
+	/// </returns>
+	uint64_t getWritten() const {
+		return this->written;
+	}
+
+	/// <summary>
+	/// Pushes the specified record into the log. This must only be called
+	/// from a single thread.
+	/// </summary>
+	/// <param name="record">
+	/// The record to be logged.
+	/// </param>
+	/// <param name="wait">
+	/// True if the record must not be dropped, in which case this waits for
+	/// the logging thread to make room if the ring buffer is full.
+	/// </param>
+	/// <returns>
+	/// False if the record was dropped since the ring buffer was full, true
+	/// otherwise.
+	/// </returns>
+	bool push(const LogRecord &record, bool wait = false) {
+		if (!this->running) {
+			this->batch.clear();
+			this->formatter(record, this->batch);
+			*this->output << this->batch << std::flush;
+			++this->written;
+			return true;
+		}
+
+		// Only this thread advances the head, and the tail is only advanced
+		// past slots which were already released by the acquire below.
+		size_t head = this->head.load(std::memory_order_relaxed);
+		size_t queued = head - this->tail.load(std::memory_order_acquire);
+		if (queued >= this->capacity) {
+			if (!wait) {
+				++this->dropped;
+				return false;
+			}
+
+			++this->waits;
+			while (queued >= this->capacity) {
+				std::this_thread::yield();
+				queued = head - this->tail.load(std::memory_order_acquire);
+			}
+		}
+
+		this->records[head & (this->capacity - 1)] = record;
+		this->head.store(head + 1, std::memory_order_release);
+		if (queued + 1 > this->highWater) this->highWater = queued + 1;
+		return true;
+	}
+
+	/// <summary>
+	/// Sets the stream to which the records are written. This must be called
+	/// before the log is started, and the stream must outlive the log.
+	/// </summary>
+	/// <param name="output">
+	/// The output stream.
+	/// </param>
+	void setOutput(std::ostream &output) {
+		this->output = &output;
+	}
+
+	/// <summary>
+	/// Starts the logging thread, with a ring buffer of at least the specified
+	/// number of records. Does nothing if the log is already started or if
+	/// the capacity is zero.
+	/// </summary>
+	/// <param name="capacity">
+	/// The minimum capacity of the ring buffer, in records. It is rounded up
+	/// to a power of two.
+	/// </param>
+	void start(size_t capacity) {
+		if (this->running || capacity == 0) return;
+
+		this->capacity = 1;
+		while (this->capacity < capacity) this->capacity *= 2;
+		this->records.resize(this->capacity);
+
+		this->running = true;
+		this->thread = std::thread(&AsyncLog::drain, this);
+	}
+
+	/// <summary>
+	/// Stops the logging thread, once it has written all of the records which
+	/// were queued. Records pushed afterwards are written synchronously.
+	/// </summary>
+	void stop() {
+		if (!this->running) return;
+
+		this->running = false;
+		this->thread.join();
+	}
+
+	/// <summary>
+	/// Assignment of Async Log instances is forbidden.
+	/// </summary>
+	AsyncLog& operator=(const AsyncLog&) = delete;
+protected:
+	/// <summary>
+	/// Body of the logging thread. Formats every record which is queued into
+	/// a batch and writes the batch, sleeping briefly whenever the ring buffer
+	/// is empty, until the log is stopped and the ring buffer is drained.
+	/// </summary>
+	void drain() {
+		std::string text;
+		for (;;) {
+			// Read the running flag first, so that every record pushed before
+			// the log was stopped is seen by the check of the head below.
+			bool running = this->running;
+			size_t tail = this->tail.load(std::memory_order_relaxed);
+			size_t head = this->head.load(std::memory_order_acquire);
+
+			if (tail == head) {
+				if (!running) return;
+
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				continue;
+			}
+
+			text.clear();
+			for (size_t index = tail; index != head; ++index) {
+				this->formatter(this->records[index & (this->capacity - 1)],
+					text);
+			}
+			this->tail.store(head, std::memory_order_release);
+
+			*this->output << text << std::flush;
+			this->written += head - tail;
+			++this->batches;
+		}
+	}
+
+	Formatter formatter;                       // Formats the Records
+	std::ostream *output;                      // Stream of the Records
+	std::vector<LogRecord> records;            // Ring Buffer of Records
+	size_t capacity;                           // Capacity, a Power of Two
+	std::string batch;                         // Text of Synchronous Record
+
+	alignas(64) std::atomic<size_t> head;      // Next Slot to be Pushed
+	alignas(64) std::atomic<size_t> tail;      // Next Slot to be Drained
+	alignas(64) std::atomic<bool> running;     // Is the Thread Running?
+
+	std::thread thread;                        // Logging Thread
+	uint64_t dropped;                          // # of Records Dropped
+	uint64_t waits;                            // # of Records Waited for
+	size_t highWater;                          // Most Records Queued at Once
+	uint64_t batches;                          // # of Batches Written
+	uint64_t written;                          // # of Records Written
+};
+
+#endif
@@ -0,0 +1,205 @@
+#ifndef DEPENDENCY_COMMON_DESCRIPTOR_TABLE
+#define DEPENDENCY_COMMON_DESCRIPTOR_TABLE
+
+#include <map>
+#include <stddef.h>
+#include <stdint.h>
+#include <unordered_map>
+#include <utility>
+
+#include "panda/plugin.h"
+
+/// <summary>
+/// Class which maps the file descriptors of each process, by ASID, to values
+/// of V, and forgets them as the guest closes the file descriptors. Closing a
+/// single file descriptor erases its entry. Invalidating all of the file
+/// descriptors of a process, as happens when it exits or executes a new
+/// program, only advances the generation of its ASID in O(1): entries of older
+/// generations are stale, and are erased when they are looked up, or by a
+/// sweep once the table has doubled in size since the last sweep, so the
+/// table stays bounded by the number of live file descriptors.
+/// </summary>
+/// <typeparam name="V">
+/// The type of values mapped to the file descriptors.
+/// </typeparam>
+template<typename V>
+class DescriptorTable {
+public:
+	/// <summary>
+	/// Creates a new, empty Descriptor Table.
+	/// </summary>
+	DescriptorTable() {
+		this->staleHits = 0;
+		this->sweptEntries = 0;
+		this->sweepAt = MIN_SWEEP_SIZE;
+	}
+
+	/// <summary>
+	/// Checks if this table has no entries, stale or not.
+	/// </summary>
+	/// <returns>
+	/// True if this table is empty, false otherwise.
+	/// </returns>
+	bool empty() const {
+		return this->entries.empty();
+	}
+
+	/// <summary>
+	/// Erases the entry of the specified file descriptor, if any, as happens
+	/// when it is closed.
+	/// </summary>
+	/// <param name="asid">
+	/// The ASID of the process which owns the file descriptor.
+	/// </param>
+	/// <param name="fd">
+	/// The file descriptor.
+	/// </param>
+	void erase(target_ulong asid, uint32_t fd) {
+		this->entries.erase(std::make_pair(asid, fd));
+	}
+
+	/// <summary>
+	/// Looks up the value of the specified file descriptor. A stale entry is
+	/// erased and counted, and is not returned.
+	/// </summary>
+	/// <param name="asid">
+	/// The ASID of the process which owns the file descriptor.
+	/// </param>
+	/// <param name="fd">
+	/// The file descriptor.
+	/// </param>
+	/// <returns>
+	/// The pointer to the value, or null if the file descriptor has no live
+	/// entry. The pointer is valid until this table is next modified.
+	/// </returns>
+	V* find(target_ulong asid, uint32_t fd) {
+		auto it = this->entries.find(std::make_pair(asid, fd));
+		if (it == this->entries.end()) return nullptr;
+
+		if (it->second.generation != this->getGeneration(asid)) {
+			this->entries.erase(it);
+			++this->staleHits;
+			return nullptr;
+		}
+
+		return &it->second.value;
+	}
+
+	/// <summary>
+	/// Returns the number of stale entries which were looked up, each of which
+	/// would have returned the value of a file descriptor which no longer
+	/// exists.
+	/// </summary>
+	/// <returns>
+	/// The number of stale entries looked up.
+	/// </returns>
+	uint64_t getStaleHits() const {
+		return this->staleHits;
+	}
+
+	/// <summary>
+	/// Returns the number of stale entries which were erased by sweeps.
+	/// </summary>
+	/// <returns>
+	/// The number of stale entries swept.
+	/// </returns>
+	uint64_t getSweptEntries() const {
+		return this->sweptEntries;
+	}
+
+	/// <summary>
+	/// Maps the specified file descriptor to the specified value, replacing
+	/// its previous value, if any.
+	/// </summary>
+	/// <param name="asid">
+	/// The ASID of the process which owns the file descriptor.
+	/// </param>
+	/// <param name="fd">
+	/// The file descriptor.
+	/// </param>
+	/// <param name="value">
+	/// The value.
+	/// </param>
+	void insert(target_ulong asid, uint32_t fd, const V &value) {
+		if (this->entries.size() >= this->sweepAt) this->sweep();
+
+		Entry &entry = this->entries[std::make_pair(asid, fd)];
+		entry.value = value;
+		entry.generation = this->getGeneration(asid);
+	}
+
+	/// <summary>
+	/// Invalidates all of the file descriptors of the specified process, in
+	/// constant time.
+	/// </summary>
+	/// <param name="asid">
+	/// The ASID of the process.
+	/// </param>
+	void invalidate(target_ulong asid) {
+		if (!this->entries.empty()) ++this->generations[asid];
+	}
+
+	/// <summary>
+	/// Returns the number of entries of this table, including stale entries
+	/// which were not erased yet.
+	/// </summary>
+	/// <returns>
+	/// The number of entries.
+	/// </returns>
+	size_t size() const {
+		return this->entries.size();
+	}
+protected:
+	/// <summary>
+	/// Returns the current generation of the specified process.
+	/// </summary>
+	/// <param name="asid">
+	/// The ASID of the process.
+	/// </param>
+	/// <returns>
+	/// The generation, which is zero until the process is first invalidated.
+	/// </returns>
+	uint32_t getGeneration(target_ulong asid) const {
+		if (this->generations.empty()) return 0;
+
+		auto it = this->generations.find(asid);
+		return (it == this->generations.end()) ? 0 : it->second;
+	}
+
+	/// <summary>
+	/// Erases all of the stale entries, and schedules the next sweep for when
+	/// the table has doubled in size.
+	/// </summary>
+	void sweep() {
+		for (auto it = this->entries.begin(); it != this->entries.end(); ) {
+			if (it->second.generation != this->getGeneration(it->first.first)) {
+				it = this->entries.erase(it);
+				++this->sweptEntries;
+			} else {
+				++it;
+			}
+		}
+
+		this->sweepAt = 2 * this->entries.size();
+		if (this->sweepAt < MIN_SWEEP_SIZE) this->sweepAt = MIN_SWEEP_SIZE;
+	}
+
+	/// <summary>
+	/// Structure which represents the value of a file descriptor, and the
+	/// generation of its process when the value was inserted.
+	/// </summary>
+	struct Entry {
+		V value;                               // Value of File Descriptor
+		uint32_t generation;                   // Generation of Process
+	};
+
+	static const size_t MIN_SWEEP_SIZE = 64;   // Smallest size swept at
+
+	std::map<std::pair<target_ulong, uint32_t>, Entry> entries;
+	std::unordered_map<target_ulong, uint32_t> generations;
+	uint64_t staleHits;                        // # of stale entries looked up
+	uint64_t sweptEntries;                     // # of stale entries swept
+	size_t sweepAt;                            // Size at which to sweep
+};
+
+#endif
@@ -0,0 +1,138 @@
+#ifndef DEPENDENCY_COMMON_ERROR_COUNTER
+#define DEPENDENCY_COMMON_ERROR_COUNTER
+
+#include <iostream>
+#include <stddef.h>
+#include <stdint.h>
+
+/// <summary>
+/// Enumeration of the categories of the errors which the plugins run into
+/// while resolving the calls of the guest.
+/// </summary>
+enum class ErrorCategory : uint8_t {
+	UnknownASID,                               // No Process with the ASID
+	OSIFailure,                                // OSI could not Resolve FD
+	UnknownFD,                                 // FD not in any Table
+	UntranslatablePage,                        // Guest Page not Mapped
+	Count                                      // # of Categories
+};
+
+/// <summary>
+/// Class which counts the errors of each category, instead of printing every
+/// one of them. Only the first few errors of each category are sampled to be
+/// printed, and the tally of every category is printed when the replay ends,
+/// so that an error which happens on every call does not flood the replay
+/// thread with unbuffered output.
+/// </summary>
+class ErrorCounter {
+public:
+	/// <summary>
+	/// Creates a new Error Counter, which samples the specified number of
+	/// errors of each category.
+	/// </summary>
+	/// <param name="samples">
+	/// The number of errors of each category to be printed.
+	/// </param>
+	ErrorCounter(uint32_t samples = 4) {
+		this->samples = samples;
+		for (size_t i = 0; i < CATEGORIES; ++i) this->counts[i] = 0;
+	}
+
+	/// <summary>
+	/// Counts an error of the specified category.
+	/// </summary>
+	/// <param name="category">
+	/// The category of the error.
+	/// </param>
+	/// <returns>
+	/// True if the error is sampled, in which case the caller prints its
+	/// message, false if it is only counted.
+	/// </returns>
+	bool count(ErrorCategory category) {
+		return ++this->counts[static_cast<size_t>(category)] <= this->samples;
+	}
+
+	/// <summary>
+	/// Returns the number of errors of the specified category.
+	/// </summary>
+	/// <param name="category">
+	/// The category of the errors.
+	/// </param>
+	/// <returns>
+	/// The number of errors.
+	/// </returns>
+	uint64_t getCount(ErrorCategory category) const {
+		return this->counts[static_cast<size_t>(category)];
+	}
+
+	/// <summary>
+	/// Returns the human readable name of the specified category.
+	/// </summary>
+	/// <param name="category">
+	/// The category.
+	/// </param>
+	/// <returns>
+	/// The static name of the category.
+	/// </returns>
+	static const char* getName(ErrorCategory category) {
+		static const char *NAMES[] = {
+			"unknown ASID", "OSI failure", "unknown fd", "untranslatable page"
+		};
+
+		return NAMES[static_cast<size_t>(category)];
+	}
+
+	/// <summary>
+	/// Returns the number of errors of every category.
+	/// </summary>
+	/// <returns>
+	/// The number of errors.
+	/// </returns>
+	uint64_t getTotal() const {
+		uint64_t total = 0;
+		for (size_t i = 0; i < CATEGORIES; ++i) total += this->counts[i];
+		return total;
+	}
+
+	/// <summary>
+	/// Prints the number of errors of each category which occurred, and how
+	/// many of them were not printed, with one line per category.
+	/// </summary>
+	/// <param name="os">
+	/// The stream to which the tally is printed.
+	/// </param>
+	/// <param name="plugin">
+	/// The name of the plugin, which prefixes every line.
+	/// </param>
+	void print(std::ostream &os, const char *plugin) const {
+		for (size_t i = 0; i < CATEGORIES; ++i) {
+			if (this->counts[i] == 0) continue;
+
+			os << plugin << ": " << this->counts[i] << " " <<
+				getName(static_cast<ErrorCategory>(i)) << " errors";
+			if (this->counts[i] > this->samples) {
+				os << " (" << this->counts[i] - this->samples <<
+					" not printed)";
+			}
+			os << "." << std::endl;
+		}
+	}
+
+	/// <summary>
+	/// Sets the number of errors of each category to be printed.
+	/// </summary>
+	/// <param name="samples">
+	/// The number of errors.
+	/// </param>
+	void setSamples(uint32_t samples) {
+		this->samples = samples;
+	}
+protected:
+	static const size_t CATEGORIES =
+		static_cast<size_t>(ErrorCategory::Count);
+
+	uint32_t samples;                          // Errors Printed per Category
+	uint64_t counts[CATEGORIES];               // { Category -> # of Errors }
+};
+
+#endif
@@ -0,0 +1,417 @@
+#ifndef DEPENDENCY_COMMON_GUEST_MEMORY
+#define DEPENDENCY_COMMON_GUEST_MEMORY
+
+#include <algorithm>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "panda/plugin.h"
+
+/// <summary>
+/// Structure which mirrors the layout of a "struct iovec" in the memory of an
+/// i386 guest, where both the base pointer and the length are 32 bits wide.
+/// </summary>
+struct GuestIOVec {
+	uint32_t base;                             // Virtual Address of Segment
+	uint32_t length;                           // Length of Segment, in bytes
+};
+
+/// <summary>
+/// Structure which mirrors the layout of a "struct msghdr" in the memory of an
+/// i386 guest, where all of the pointers and lengths are 32 bits wide.
+/// </summary>
+struct GuestMsgHdr {
+	uint32_t name;                             // Virtual Address of Address
+	uint32_t nameLength;                       // Length of Address, in bytes
+	uint32_t iov;                              // Virtual Address of iovecs
+	uint32_t iovLength;                        // Number of iovecs
+	uint32_t control;                          // Virtual Address of Ancillary
+	uint32_t controlLength;                    // Length of Ancillary Data
+	int32_t flags;                             // Flags of Received Message
+};
+
+/// <summary>
+/// Structure which represents a decoded IPv4 or IPv6 socket address. IPv4
+/// addresses only use the first four bytes of the address.
+/// </summary>
+struct SocketAddress {
+	uint16_t family;                           // AF_INET or AF_INET6
+	uint16_t port;                             // Port, in host byte order
+	uint8_t address[16];                       // Address, in network order
+
+	/// <summary>
+	/// Compares this address with the specified address, so that addresses
+	/// can be used as keys of ordered containers.
+	/// </summary>
+	/// <param name="rhs">
+	/// The address to be compared with this address.
+	/// </param>
+	/// <returns>
+	/// True if this address orders before <paramref="rhs"/>, false otherwise.
+	/// </returns>
+	bool operator<(const SocketAddress &rhs) const {
+		if (this->family != rhs.family) return this->family < rhs.family;
+		if (this->port != rhs.port) return this->port < rhs.port;
+		return memcmp(this->address, rhs.address, sizeof(this->address)) < 0;
+	}
+};
+
+/// <summary>
+/// Reads up to <paramref="length"/> bytes from the specified virtual memory
+/// address into the specified buffer. The bytes are copied with a single
+/// access to the guest memory if all of them are mapped. Otherwise, they are
+/// copied one page at a time, up to the first page which is not mapped.
+/// </summary>
+/// <param name="cpu">
+/// The CPU State pointer.
+/// </param>
+/// <param name="addr">
+/// The virtual memory address of the first byte.
+/// </param>
+/// <param name="buffer">
+/// The buffer of at least <paramref="length"/> bytes into which the bytes
+/// are read.
+/// </param>
+/// <param name="length">
+/// The number of bytes to be read.
+/// </param>
+/// <returns>
+/// The number of bytes which could be read, from the start of the range.
+/// </returns>
+inline uint32_t readGuestBytes(CPUState *cpu, target_ulong addr,
+		uint8_t *buffer, uint32_t length) {
+	if (length == 0) return 0;
+	if (panda_virtual_memory_rw(cpu, addr, buffer, length, 0) == 0)
+		return length;
+
+	// Some page of the range is not mapped, find out which one
+	uint32_t read = 0;
+	while (read < length) {
+		uint32_t offset = (addr + read) & ~TARGET_PAGE_MASK;
+		uint32_t chunk = std::min<uint32_t>(length - read,
+			TARGET_PAGE_SIZE - offset);
+		if (panda_virtual_memory_rw(cpu, addr + read, buffer + read, chunk,
+				0) != 0) {
+			break;
+		}
+
+		read += chunk;
+	}
+
+	return read;
+}
+
+/// <summary>
+/// Reads <paramref="count"/> values of T from the specified virtual memory
+/// address into the specified array, with a single access to the guest
+/// memory. This function assumes that the values in memory are adjacent to
+/// each other (in an array), and that the layout of T matches the layout of
+/// the values in the guest.
+/// </summary>
+/// <typeparam name="T">
+/// The type of values to be read from the memory address.
+/// </typeparam>
+/// <param name="cpu">
+/// The CPU State pointer.
+/// </param>
+/// <param name="addr">
+/// The virtual memory address to the start of the T values.
+/// </param>
+/// <param name="values">
+/// The array of at least <paramref="count"/> values into which the values
+/// are read, typically on the stack of the caller.
+/// </param>
+/// <param name="count">
+/// The number of values to be read.
+/// </param>
+/// <returns>
+/// True if all of the values could be read, false otherwise.
+/// </returns>
+template<typename T>
+bool readGuestValues(CPUState *cpu, target_ulong addr, T *values,
+		uint32_t count) {
+	uint32_t length = count * sizeof(T);
+	uint8_t *raw = reinterpret_cast<uint8_t*>(values);
+	return readGuestBytes(cpu, addr, raw, length) == length;
+}
+
+/// <summary>
+/// Reads <paramref="count"/> values of T from the specified virtual memory
+/// address into the specified vector, with a single access to the guest
+/// memory. See <see cref="readGuestValues"/>.
+/// </summary>
+/// <typeparam name="T">
+/// The type of values to be read from the memory address.
+/// </typeparam>
+/// <param name="cpu">
+/// The CPU State pointer.
+/// </param>
+/// <param name="addr">
+/// The virtual memory address to the start of the T values.
+/// </param>
+/// <param name="values">
+/// The vector which is resized to <paramref="count"/> values and into which
+/// the values are read. Its storage is reused if it is large enough.
+/// </param>
+/// <param name="count">
+/// The number of values to be read.
+/// </param>
+/// <returns>
+/// True if all of the values could be read, false otherwise.
+/// </returns>
+template<typename T>
+bool readGuestValues(CPUState *cpu, target_ulong addr, std::vector<T> &values,
+		uint32_t count) {
+	values.resize(count);
+	return readGuestValues(cpu, addr, values.data(), count);
+}
+
+/// <summary>
+/// Reads the null terminated string at the specified virtual memory address
+/// into the specified string. The string is copied one page at a time, and
+/// the terminator is searched for with memchr in each page copied, so a string
+/// costs one access to the guest memory per page it spans rather than one per
+/// character. The storage of the string is reused, so reading a string does
+/// not allocate once the string has grown to its largest size.
+/// </summary>
+/// <param name="cpu">
+/// The CPU State pointer.
+/// </param>
+/// <param name="addr">
+/// The virtual memory address of the first character.
+/// </param>
+/// <param name="maxSize">
+/// The maximum number of characters to be read. Longer strings are 
+/// truncated to this number of characters.
+/// </param>
+/// <param name="str">
+/// The string into which the characters are read, without the terminator.
+/// </param>
+/// <returns>
+/// True if the string could be read up to its terminator or up to
+/// <paramref="maxSize"/> characters, false if a page of it is not mapped, in
+/// which case <paramref="str"/> holds the characters read before that page.
+/// </returns>
+inline bool readGuestString(CPUState *cpu, target_ulong addr, size_t maxSize,
+		std::string &str) {
+	str.clear();
+	while (str.size() < maxSize) {
+		// Copy the rest of the page, or the rest of the string if shorter
+		size_t read = str.size();
+		uint32_t offset = (addr + read) & ~TARGET_PAGE_MASK;
+		uint32_t chunk = std::min<size_t>(maxSize - read,
+			TARGET_PAGE_SIZE - offset);
+		str.resize(read + chunk);
+
+		uint8_t *raw = reinterpret_cast<uint8_t*>(&str[read]);
+		if (panda_virtual_memory_rw(cpu, addr + read, raw, chunk, 0) != 0) {
+			str.resize(read);
+			return false;
+		}
+
+		// Stop at the terminator, if it is in this chunk
+		const void *terminator = memchr(raw, '\0', chunk);
+		if (terminator) {
+			str.resize(read + (static_cast<const uint8_t*>(terminator) - raw));
+			return true;
+		}
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Reads the argument block of a socket call, which is an array of 32 bit
+/// arguments in the memory of an i386 guest.
+/// </summary>
+/// <typeparam name="N">
+/// The number of arguments of the socket call.
+/// </typeparam>
+/// <param name="cpu">
+/// The CPU State pointer.
+/// </param>
+/// <param name="args">
+/// The virtual memory address to the start of the arguments.
+/// </param>
+/// <param name="arguments">
+/// The array into which the arguments are read.
+/// </param>
+/// <returns>
+/// True if all of the arguments could be read, false otherwise.
+/// </returns>
+template<size_t N>
+bool readSocketcallArgs(CPUState *cpu, target_ulong args,
+		uint32_t (&arguments)[N]) {
+	return readGuestValues(cpu, args, arguments, N);
+}
+
+/// <summary>
+/// Reads the arguments of a "sendmsg" or "recvmsg" socket call, and the
+/// message header which they point to.
+/// </summary>
+/// <param name="cpu">
+/// The CPU State pointer.
+/// </param>
+/// <param name="args">
+/// The virtual memory address to the start of the arguments.
+/// </param>
+/// <param name="sockfd">
+/// The socket file descriptor of the call.
+/// </param>
+/// <param name="header">
+/// The message header of the call.
+/// </param>
+/// <returns>
+/// True if the arguments and the message header could be read, false
+/// otherwise.
+/// </returns>
+inline bool readGuestMessage(CPUState *cpu, target_ulong args,
+		uint32_t &sockfd, GuestMsgHdr &header) {
+	uint32_t arguments[3];
+	if (!readSocketcallArgs(cpu, args, arguments)) return false;
+
+	sockfd = arguments[0];
+	return readGuestValues(cpu, arguments[1], &header, 1);
+}
+
+/// <summary>
+/// Decodes the specified raw "struct sockaddr", as laid out in the guest.
+/// Only IPv4 and IPv6 addresses are decoded.
+/// </summary>
+/// <param name="raw">
+/// The raw bytes of the address.
+/// </param>
+/// <param name="length">
+/// The number of bytes of the address which are available.
+/// </param>
+/// <param name="address">
+/// The decoded address.
+/// </param>
+/// <returns>
+/// True if the address is a complete IPv4 or IPv6 address, false otherwise.
+/// </returns>
+inline bool decodeSocketAddress(const uint8_t *raw, uint32_t length,
+		SocketAddress &address) {
+	memset(&address, 0, sizeof(address));
+	if (length < sizeof(sa_family_t)) return false;
+
+	// Copy the address out, since the raw bytes need not be aligned
+	sockaddr_storage storage;
+	memset(&storage, 0, sizeof(storage));
+	memcpy(&storage, raw, std::min<size_t>(length, sizeof(storage)));
+
+	if (storage.ss_family == AF_INET && length >= sizeof(sockaddr_in)) {
+		sockaddr_in *sin4 = reinterpret_cast<sockaddr_in*>(&storage);
+
+		address.family = AF_INET;
+		address.port = ntohs(sin4->sin_port);
+		memcpy(address.address, &sin4->sin_addr, sizeof(sin4->sin_addr));
+	} else if (storage.ss_family == AF_INET6 &&
+			length >= sizeof(sockaddr_in6)) {
+		sockaddr_in6 *sin6 = reinterpret_cast<sockaddr_in6*>(&storage);
+
+		address.family = AF_INET6;
+		address.port = ntohs(sin6->sin6_port);
+		memcpy(address.address, &sin6->sin6_addr, sizeof(sin6->sin6_addr));
+	} else {
+		return false;
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Reads and decodes the socket address at the specified virtual memory
+/// address. At most the size of a "struct sockaddr_storage" is read, so IPv6
+/// addresses are never truncated.
+/// </summary>
+/// <param name="cpu">
+/// The CPU State pointer.
+/// </param>
+/// <param name="addr">
+/// The virtual memory address of the socket address, may be zero.
+/// </param>
+/// <param name="length">
+/// The length of the socket address, in bytes, as passed to the call.
+/// </param>
+/// <param name="address">
+/// The decoded socket address.
+/// </param>
+/// <returns>
+/// True if an IPv4 or IPv6 address could be read, false otherwise.
+/// </returns>
+inline bool readSocketAddress(CPUState *cpu, target_ulong addr,
+		uint32_t length, SocketAddress &address) {
+	if (addr == 0) return false;
+
+	uint8_t raw[sizeof(sockaddr_storage)];
+	uint32_t size = std::min<uint32_t>(length, sizeof(raw));
+	if (!readGuestValues(cpu, addr, raw, size)) return false;
+
+	return decodeSocketAddress(raw, size, address);
+}
+
+/// <summary>
+/// Reads the path of the UNIX socket address at the specified virtual memory
+/// address. Paths in the abstract namespace start with a null character, and
+/// are kept whole, since the kernel compares all of their bytes.
+/// </summary>
+/// <param name="cpu">
+/// The CPU State pointer.
+/// </param>
+/// <param name="addr">
+/// The virtual memory address of the socket address, may be zero.
+/// </param>
+/// <param name="length">
+/// The length of the socket address, in bytes, as passed to the call.
+/// </param>
+/// <param name="path">
+/// The path of the socket address.
+/// </param>
+/// <returns>
+/// True if a UNIX socket address with a path could be read, false otherwise.
+/// </returns>
+inline bool readUnixSocketPath(CPUState *cpu, target_ulong addr,
+		uint32_t length, std::string &path) {
+	uint16_t family = 0;
+	uint8_t raw[sizeof(sockaddr_storage)];
+	uint32_t size = std::min<uint32_t>(length, sizeof(raw));
+	if (addr == 0 || size <= sizeof(family)) return false;
+	if (!readGuestValues(cpu, addr, raw, size)) return false;
+
+	memcpy(&family, raw, sizeof(family));
+	if (family != AF_UNIX) return false;
+
+	const char *name = reinterpret_cast<const char*>(raw) + sizeof(family);
+	size_t nameLength = size - sizeof(family);
+	if (name[0] != '\0') nameLength = strnlen(name, nameLength);
+	path.assign(name, nameLength);
+	return true;
+}
+
+/// <summary>
+/// Formats the IP address of the specified socket address.
+/// </summary>
+/// <param name="address">
+/// The socket address.
+/// </param>
+/// <param name="ip">
+/// The buffer into which the IP address is formatted.
+/// </param>
+/// <returns>
+/// True if the IP address could be formatted, false otherwise.
+/// </returns>
+inline bool formatSocketAddress(const SocketAddress &address,
+		char (&ip)[INET6_ADDRSTRLEN]) {
+	return inet_ntop(address.family, address.address, ip,
+		INET6_ADDRSTRLEN) != nullptr;
+}
+
+#endif
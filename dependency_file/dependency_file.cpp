@@ -37,26 +37,14 @@ std::string getFileName(CPUState *cpu, int fd) {
 	return "";
 }
 
-std::string getGuestString(CPUState *cpu, target_ulong addr, size_t maxSize) {
-	// Create an empty string with all zeros
-	std::string str(maxSize, '0');
-
-	for (size_t i = 0; i < maxSize; ++i) {
-		// Fetch the unsigned integer character from PANDA's memory. We do this
-		// by specifiying the CPU state, the address at which we want to read
-		// from (equal to starting address + offset), the pointer to which we
-		// want to write the value, 1 to indicate we are reading one byte at a 
-		// time, and 0 to indicate we are not writing anything to memory.
-		uint8_t uiChar = 0;
-		panda_virtual_memory_rw(cpu, addr + i, &uiChar, 1, 0);
-		
-		// Write the character to the string and check if its the null
-		// terminator character. If so, trim the string and return.
-		str.at(i) = (char)(uiChar);
-		if (str.at(i) == '\0') {
-			str = str.substr(0, i);
-			return str;
-		}
+const std::string& getGuestString(CPUState *cpu, target_ulong addr, 
+		size_t maxSize) {
+	// Read the string into the reusable buffer, a page at a time. If part of
+	// the string is not mapped, the characters before it are returned.
+	std::string &str = dependency_file.stringBuffer;
+	if (!readGuestString(cpu, addr, maxSize, str) && dependency_file.debug) {
+		std::cerr << "dependency_file: unable to read string at address: " <<
+			addr << ", read " << str.size() << " characters." << std::endl;
 	}
 	
 	return str;
@@ -179,7 +167,7 @@ void on_pwrite64_return(CPUState *cpu, target_ulong pc, uint32_t fd,
 
 void on_open_enter(CPUState *cpu, target_ulong pc, uint32_t fileAddr, 
 		int32_t flags, int32_t mode) {
-	std::string fileName = getGuestString(cpu, fileAddr, 256);
+	const std::string &fileName = getGuestString(cpu, fileAddr, 256);
 	logFileCallback("open_enter", fileName);
 	
 	// Since open may only contain the file name and not the full directory,
@@ -20,6 +20,8 @@ extern "C" {
 	#include "taint2/taint2_ext.h"
 }
 
+#include "../dependency_common/guest_memory.h"
+
 /// <summary>
 /// Represents the main structure for the Dependency_File plugin.
 /// </summary>
@@ -31,6 +33,7 @@ struct Dependency_File {
 	bool debug = false;                // Print debug information?
 	target_ulong enableTaintAt =       
 		UINT32_MAX;                    // Instruction # @ which to enable taint
+	std::string stringBuffer;          // Reusable guest string buffer
 };
 
 Dependency_File dependency_file;                // The Plugin Structure
@@ -60,7 +63,9 @@ int taintedBytesQueried = 0;                    // # of tainted sink bytes
 std::string getFileName(CPUState *cpu, int fd);
 
 /// <summary>
-/// Returns a string fetched from the specified memory address.
+/// Returns a string fetched from the specified memory address. The string is
+/// read into a buffer which is reused by every call, so the reference returned
+/// is only valid until the next call.
 /// </summary>
 /// <param name="cpu">
 /// The CPU State pointer.
@@ -76,9 +81,10 @@ std::string getFileName(CPUState *cpu, int fd);
 /// encountered in memory.
 /// </param>
 /// <returns>
-/// The guest's string at the memory location.
+/// The constant reference to the guest's string at the memory location.
 /// </returns>
-std::string getGuestString(CPUState *cpu, target_ulong addr, size_t maxSize);
+const std::string& getGuestString(CPUState *cpu, target_ulong addr, 
+		size_t maxSize);
 
 /// <summary>
 /// Taints the contents of the buffer at the specified virtual address and of 
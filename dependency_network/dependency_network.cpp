@@ -1,7 +1,6 @@
 #include "dependency_network_def.h"
 
 #include <iostream>
-#include <stdexcept>
 #include <linux/net.h>
 
 bool Dependency_Network_Target::operator==(
@@ -14,33 +13,55 @@ bool Dependency_Network_Target::operator!=(
 	return (this->ip != rhs.ip) || (this->port != rhs.port);
 }
 
-template<typename T>
-std::vector<T> getMemoryValues(CPUState *cpu, uint32_t addr, uint32_t size) {
-	std::vector<T> arguments;
-	
-	// An array of raw memory bytes. Since we want to fetch T elements from
-	// memory and we need enough bytes to store a single instance of T, so the 
-	// array's size is equivalent to the size of a single T.
-	uint8_t raw[sizeof(T)];
-	
-	for (auto i = 0; i < size; ++i) {
-		// For each argument, read the bytes from memory and store them into
-		// the raw memory array. Cast the raw memory to T and store in the 
-		// arguments list.
-		panda_virtual_memory_rw(cpu, addr + i * sizeof(T), raw, sizeof(T), 0);
-		T argument = *(reinterpret_cast<T*>(raw));
-		arguments.push_back(argument);
+void formatLogRecord(const LogRecord &record, std::string &text) {
+	switch (static_cast<LogType>(record.type)) {
+	case LogType::Text:
+		text += record.event;
+		break;
+	case LogType::Called:
+		text += "dependency_network: " + std::string(record.event) + 
+			" called at " + std::to_string(record.values[0]) + ".";
+		break;
+	case LogType::SocketCall:
+		text += "dependency_network: " + std::string(record.event) + 
+			" triggered at instruction " + std::to_string(record.values[0]) + 
+			", call type: " + std::to_string((int32_t)record.values[1]);
+		break;
+	case LogType::Tainted:
+		text += "dependency_network: " + std::to_string(record.values[0]) + 
+			" tainted bytes written to " + std::string(record.event) + ".";
+		break;
+	case LogType::Other:
+		text += "dependency_network: saw " + std::string(record.event) + 
+			" of file/socket with fd: " + std::to_string(record.values[0]);
+		break;
+	case LogType::Labeling:
+	case LogType::Querying:
+		text += "dependency_network: " + std::string(record.event) + " " + 
+			std::to_string(record.values[0]) + " bytes starting from " + 
+			"virtual address " + std::to_string(record.values[1]) + ".";
+		break;
+	case LogType::Labeled:
+		text += "dependency_network: " + std::string(record.event) + " " + 
+			std::to_string(record.values[0]) + " out of " + 
+			std::to_string(record.values[1]) + " bytes at virtual address " + 
+			std::to_string(record.values[2]);
+		break;
+	case LogType::Found:
+		text += "dependency_network: " + std::string(record.event) + " " + 
+			std::to_string(record.values[0]) + " tainted bytes out of " + 
+			std::to_string(record.values[1]) + " at virtual address " + 
+			std::to_string(record.values[2]);
+		break;
 	}
 	
-	return arguments;
+	text += '\n';
 }
 
 void labelBufferContents(CPUState *cpu, target_ulong vAddr, uint32_t length) {
 	if (!taint2_enabled()) return;
-	if (dependency_network.debug) {
-		std::cout << "dependency_network: labeling " << length << " bytes " <<
-			"starting from virtual address " << vAddr << "." << std::endl;
-	}
+	if (dependency_network.debug) 
+		logEvent(LogType::Labeling, "labeling", length, vAddr);
 	
 	int bytesTainted = 0; // Number of bytes that were tainted
 	for (auto i = 0; i < length; ++i) {
@@ -48,9 +69,11 @@ void labelBufferContents(CPUState *cpu, target_ulong vAddr, uint32_t length) {
 		// not skip this byte.
 		hwaddr pAddr = panda_virt_to_phys(cpu, vAddr + i);
 		if (pAddr == (hwaddr)(-1)) {
-			std::cerr << "dependency_network: unable to taint at address: " <<
-				vAddr << " (virtual), " << pAddr << " (physical)." << 
-				std::endl;
+			if (dependency_network.errors.count(
+					ErrorCategory::UntranslatablePage)) {
+				std::cerr << "dependency_network: unable to taint at " <<
+					"address: " << vAddr + i << " (virtual)." << std::endl;
+			}
 			continue;
 		}
 		// Else, taint at the physical address specified
@@ -58,11 +81,21 @@ void labelBufferContents(CPUState *cpu, target_ulong vAddr, uint32_t length) {
 		++bytesTainted;
 	}
 	
-	if (dependency_network.debug) {
-		std::cout << "dependency_network: labeled " << bytesTainted << 
-			" out of " << length << " bytes at virtual address " << vAddr << 
-			std::endl;
-	}
+	if (dependency_network.debug) 
+		logEvent(LogType::Labeled, "labeled", bytesTainted, length, vAddr);
+}
+
+void logEvent(LogType type, const char *event, uint64_t first, 
+		uint64_t second, uint64_t third) {
+	LogRecord record;
+	record.type = static_cast<uint16_t>(type);
+	record.event = event;
+	record.values[0] = first;
+	record.values[1] = second;
+	record.values[2] = third;
+	record.values[3] = 0;
+	
+	dependency_network.eventLog.push(record);
 }
 
 int on_before_block_translate(CPUState *cpu, target_ulong pc) {
@@ -82,57 +115,95 @@ int on_before_block_translate(CPUState *cpu, target_ulong pc) {
 	return 0;
 }
 
+void on_close_return(CPUState *cpu, target_ulong pc, uint32_t fd) {
+	if ((int32_t)((CPUArchState*)cpu->env_ptr)->regs[0] < 0) return;
+	targets.erase(panda_current_asid(cpu), fd);
+}
+
+void on_execve_enter(CPUState *cpu, target_ulong pc, uint32_t filename,
+		uint32_t argv, uint32_t envp) {
+	// The ASID is no longer current once the new program is loaded, so it is
+	// remembered by the PID, which the new program keeps.
+	OsiProc *process = get_current_process(cpu);
+	if (!process) return;
+	
+	dependency_network.execs[process->pid] = panda_current_asid(cpu);
+	free_osiproc(process);
+}
+
+void on_execve_return(CPUState *cpu, target_ulong pc, uint32_t filename,
+		uint32_t argv, uint32_t envp) {
+	OsiProc *process = get_current_process(cpu);
+	if (!process) return;
+	
+	auto &execs = dependency_network.execs;
+	auto it = execs.find(process->pid);
+	free_osiproc(process);
+	if (it == execs.end()) return;
+	
+	// The file descriptors of the old program are all forgotten, including
+	// those without the close on exec flag, which the new program keeps.
+	target_ulong asid = it->second;
+	execs.erase(it);
+	if (((CPUArchState*)cpu->env_ptr)->regs[0] == 0) targets.invalidate(asid);
+}
+
+void on_exit_group_enter(CPUState *cpu, target_ulong pc, int32_t error_code) {
+	// The exit system call is not hooked, since it only ends the calling 
+	// thread, and the other threads of the process share its file 
+	// descriptors. The C library ends processes with exit_group.
+	targets.invalidate(panda_current_asid(cpu));
+}
+
 void on_pread64_return(CPUState *cpu, target_ulong pc, uint32_t fd,
 		uint32_t buffer, uint32_t count, uint64_t pos) {
-	Dependency_Network_Target target;
-	try {
-		target = targets.at(std::make_pair(panda_current_asid(cpu), fd));
-	} catch (const std::out_of_range &e) {
-		std::cerr << "dependency_network: pread64_return called, but file"
-			<< "descriptor " << fd << " is unknown." << std::endl;
+	Dependency_Network_Target *found = targets.find(panda_current_asid(cpu), 
+		fd);
+	if (!found) {
+		if (dependency_network.errors.count(ErrorCategory::UnknownFD)) {
+			std::cerr << "dependency_network: pread64_return called, but " <<
+				"file descriptor " << fd << " is unknown." << std::endl;
+		}
 		return;
 	}
+	Dependency_Network_Target target = *found;
 	
 	if (target == dependency_network.source) {
-		std::cout << "dependency_network: ***saw read return of source " << 
-			"target***" << std::endl;
+		logEvent(LogType::Text, 
+			"dependency_network: ***saw read return of source target***");
 		sawReadOfSource = true;
 		
 		labelBufferContents(cpu, buffer, count);
 	} else {
-		if (dependency_network.debug) {
-			std::cout << "dependency_network: saw read of file/socket with " <<
-				"fd: " << fd << std::endl;
-		}
+		if (dependency_network.debug) logEvent(LogType::Other, "read", fd);
 	}
 }
 
 void on_pwrite64_return(CPUState *cpu, target_ulong pc, uint32_t fd,
 		uint32_t buffer, uint32_t count, uint64_t pos) {
-	Dependency_Network_Target target;
-	try {
-		target = targets.at(std::make_pair(panda_current_asid(cpu), fd));
-	} catch (const std::out_of_range &e) {
-		std::cerr << "dependency_network: pwrite64_return called, but file" <<
-			" descriptor " << fd << " is unknown." << std::endl;
+	Dependency_Network_Target *found = targets.find(panda_current_asid(cpu), 
+		fd);
+	if (!found) {
+		if (dependency_network.errors.count(ErrorCategory::UnknownFD)) {
+			std::cerr << "dependency_network: pwrite64_return called, but " <<
+				"file descriptor " << fd << " is unknown." << std::endl;
+		}
 		return;
 	}
+	Dependency_Network_Target target = *found;
 	
 	if (target == dependency_network.sink) {
-		std::cout << "dependency_network: ***saw write return of sink " << 
-			"target***" << std::endl; 
+		logEvent(LogType::Text, 
+			"dependency_network: ***saw write return of sink target***");
 		sawWriteOfSink = true;
 		
 		int numTainted = queryBufferContents(cpu, buffer, count);
-		std::cout << "dependency_file: " << numTainted << " tainted bytes " <<
-			"written to " << target.ip << "." << std::endl;
+		logEvent(LogType::Tainted, dependency_network.sink.ip.c_str(), 
+			numTainted);
 
 		if (numTainted > 0) dependency = true;
 	} else {
-		if (dependency_network.debug) {
-			std::cout << "dependency_network: saw write of file/socket with " 
-				<< "fd: " << fd << std::endl;
-		}
+		if (dependency_network.debug) logEvent(LogType::Other, "write", fd);
 	}
 }
 
@@ -144,9 +215,8 @@ void on_read_return(CPUState *cpu, target_ulong pc, uint32_t fd,
 void on_socketcall_return(CPUState *cpu, target_ulong pc, int32_t call,
 		uint32_t args) {
 	if (dependency_network.debug) {
-		std::cout << "dependency_network: socket_call triggered at " << 
-			"instruction " << rr_get_guest_instr_count() << ", call type: " <<
-			call << std::endl;
+		logEvent(LogType::SocketCall, "socket_call", 
+			rr_get_guest_instr_count(), call);
 	}
 			
 	switch (call) {
@@ -165,45 +235,52 @@ void on_socketcall_return(CPUState *cpu, target_ulong pc, int32_t call,
 }
 
 void on_socketcall_connect_return(CPUState *cpu, uint32_t args) {
-	std::cout << "dependency_network: socket_connect called at " <<
-		rr_get_guest_instr_count() << "." << std::endl;
+	logEvent(LogType::Called, "socket_connect", rr_get_guest_instr_count());
 	
-	// Get the arguments from the args virtual memory
-	auto arguments = getMemoryValues<uint32_t>(cpu, args, 3);
-
-	// Get the sockaddr structure from the arguments. The virtual memory 
-	// address to the sockaddr structure is stored in the second argument of
-	// the args passed to connect(). Use that address to get the pointer to the
-	// sockaddr structure itself.
-	auto sockaddrAddress = arguments[1];
-	sockaddr addr = getMemoryValues<sockaddr>(cpu, sockaddrAddress, 1)[0];
+	// Get the arguments from the args virtual memory, and the sockaddr 
+	// structure whose address and length are the second and third arguments
+	// passed to connect(). The whole address is read, so IPv6 addresses are
+	// not truncated.
+	uint32_t arguments[3];
+	if (!readSocketcallArgs(cpu, args, arguments)) {
+		if (dependency_network.errors.count(
+				ErrorCategory::UntranslatablePage)) {
+			std::cerr << "dependency_network: failed to read connect " <<
+				"arguments." << std::endl;
+		}
+		return;
+	}
 	
-	// Stores the IP address found and the port number
-	char ipAddress[INET6_ADDRSTRLEN] = {0};
-	unsigned short port = 0;
+	// Fetch the sockaddr first, so that an address which could not be read
+	// is not reported as being of an unknown family.
+	uint8_t raw[sizeof(sockaddr_storage)];
+	uint32_t size = std::min<uint32_t>(arguments[2], sizeof(raw));
+	if (arguments[1] == 0 || !readGuestValues(cpu, arguments[1], raw, size)) {
+		if (dependency_network.errors.count(
+				ErrorCategory::UntranslatablePage)) {
+			std::cerr << "dependency_network: failed to fetch sockaddr of " <<
+				"connect." << std::endl;
+		}
+		return;
+	}
 	
-	if (addr.sa_family == AF_INET) {
-		sockaddr_in *sin4 = reinterpret_cast<sockaddr_in*>(&addr);
-		
-		inet_ntop(AF_INET, &sin4->sin_addr, ipAddress, INET6_ADDRSTRLEN);
-		port = sin4->sin_port;
-		
-	} else if (addr.sa_family == AF_INET6) {
-		sockaddr_in6 *sin6 = reinterpret_cast<sockaddr_in6*>(&addr);
-		
-		inet_ntop(AF_INET6, &sin6->sin6_addr, ipAddress, INET6_ADDRSTRLEN);
-		port = sin6->sin6_port;
-	} else {
+	SocketAddress addr;
+	if (!decodeSocketAddress(raw, size, addr)) {
 		std::cerr << "dependency_network: sockaddr fetched but is of an " <<
 			"unknown family." << std::endl;
 		return;
 	}
 	
+	// Stores the IP address found and the port number
+	char ipAddress[INET6_ADDRSTRLEN] = {0};
+	formatSocketAddress(addr, ipAddress);
+	unsigned short port = addr.port;
+	
 	// Convert IP address & port to Dependency_Network_Target. Add the Target
 	// to the targets map.
 	int sockfd = arguments[0];
 	Dependency_Network_Target target = { std::string(ipAddress), port };
-	targets[std::make_pair(panda_current_asid(cpu), sockfd)] = target;
+	targets.insert(panda_current_asid(cpu), sockfd, target);
 	
 	// Print IP address and port
 	if (dependency_network.debug) {
@@ -214,20 +291,20 @@ void on_socketcall_connect_return(CPUState *cpu, uint32_t args) {
 	// If a connection to a source or sink is detected, turn on tainting
 	// to be ready to intercept read/write and send/recv.
 	if (target == dependency_network.source) {
-		std::cout << "***saw connect to source target***" << std::endl;
+		logEvent(LogType::Text, "***saw connect to source target***");
 		dependency_network.enableTaintAt = rr_get_guest_instr_count();
 	} else if (target == dependency_network.sink) {
-		std::cout << "***saw connect to sink target***" << std::endl;
+		logEvent(LogType::Text, "***saw connect to sink target***");
 		dependency_network.enableTaintAt = rr_get_guest_instr_count();
 	}
 }
 
 void on_socketcall_recv_return(CPUState *cpu, uint32_t args) {
-	std::cout << "dependency_network: socket_recv called at " <<
-		rr_get_guest_instr_count() << "." << std::endl;
+	logEvent(LogType::Called, "socket_recv", rr_get_guest_instr_count());
 	
 	// Get the arguments from the args virtual memory
-	auto arguments = getMemoryValues<uint32_t>(cpu, args, 4);
+	uint32_t arguments[4];
+	if (!readSocketcallArgs(cpu, args, arguments)) return;
 	
 	// Retrieve the socket file descriptor, buffer address and buffer length
 	// from the arguments.
@@ -236,19 +313,21 @@ void on_socketcall_recv_return(CPUState *cpu, uint32_t args) {
 	uint32_t length = arguments[2];
 	
 	// Try to get the network target using the socket file descriptor
-	Dependency_Network_Target target;
-	try {
-		target = targets.at(std::make_pair(panda_current_asid(cpu), sockfd));
-	} catch (const std::out_of_range &e) {
-		std::cerr << "dependency_network: socket_recv called, but file" <<
-			" descriptor " << sockfd << " is unknown." << std::endl;
+	Dependency_Network_Target *found = targets.find(panda_current_asid(cpu), 
+		sockfd);
+	if (!found) {
+		if (dependency_network.errors.count(ErrorCategory::UnknownFD)) {
+			std::cerr << "dependency_network: socket_recv called, but file" <<
+				" descriptor " << sockfd << " is unknown." << std::endl;
+		}
 		return;
 	}
+	Dependency_Network_Target target = *found;
 	
 	// If we are receiving information from the source target, taint it
 	if (target == dependency_network.source) {
-		std::cout << "dependency_network: ***saw recv from source target***" 
-			<< std::endl;
+		logEvent(LogType::Text, 
+			"dependency_network: ***saw recv from source target***");
 			
 		sawReadOfSource = true;
 		labelBufferContents(cpu, buffer, length);
@@ -256,11 +335,11 @@ void on_socketcall_recv_return(CPUState *cpu, uint32_t args) {
 }
 
 void on_socketcall_send_return(CPUState *cpu, uint32_t args) {
-	std::cout << "dependency_network: socket_recv called at " <<
-		rr_get_guest_instr_count() << "." << std::endl;
+	logEvent(LogType::Called, "socket_recv", rr_get_guest_instr_count());
 	
 	// Get the arguments from the args virtual memory
-	auto arguments = getMemoryValues<uint32_t>(cpu, args, 4);
+	uint32_t arguments[4];
+	if (!readSocketcallArgs(cpu, args, arguments)) return;
 	
 	// Retrieve the socket file descriptor, buffer address and buffer length
 	// from the arguments.
@@ -269,23 +348,25 @@ void on_socketcall_send_return(CPUState *cpu, uint32_t args) {
 	uint32_t length = arguments[2];
 	
 	// Try to get the network target using the socket file descriptor
-	Dependency_Network_Target target;
-	try {
-		target = targets.at(std::make_pair(panda_current_asid(cpu), sockfd));
-	} catch (const std::out_of_range &e) {
-		std::cerr << "dependency_network: socket_send called, but file" <<
-			" descriptor " << sockfd << " is unknown." << std::endl;
+	Dependency_Network_Target *found = targets.find(panda_current_asid(cpu), 
+		sockfd);
+	if (!found) {
+		if (dependency_network.errors.count(ErrorCategory::UnknownFD)) {
+			std::cerr << "dependency_network: socket_send called, but file" <<
+				" descriptor " << sockfd << " is unknown." << std::endl;
+		}
 		return;
 	}
+	Dependency_Network_Target target = *found;
 	
 	// If we are receiving information from the source target, taint it
 	if (target == dependency_network.sink) {
-		std::cout << "dependency_network: ***saw send to sink target***" << 
-			std::endl;
+		logEvent(LogType::Text, 
+			"dependency_network: ***saw send to sink target***");
 			
 		int numTainted = queryBufferContents(cpu, buffer, length);
-		std::cout << "dependency_network: " << numTainted << " tainted bytes " 
-			<< "written to " << target.ip << "." << std::endl;
+		logEvent(LogType::Tainted, dependency_network.sink.ip.c_str(), 
+			numTainted);
 
 		sawWriteOfSink = true;
 		if (numTainted > 0) dependency = true;
@@ -299,10 +380,8 @@ void on_write_return(CPUState *cpu, target_ulong pc, uint32_t fd,
 
 int queryBufferContents(CPUState *cpu, target_ulong vAddr, uint32_t length) {
 	if (!taint2_enabled()) return -1;
-	if (dependency_network.debug) {
-		std::cout << "dependency_network: querying " << length << " bytes " <<
-			"starting from virtual address " << vAddr << "." << std::endl;
-	}
+	if (dependency_network.debug) 
+		logEvent(LogType::Querying, "querying", length, vAddr);
 	
 	int bytesWithTaint = 0; // Number of bytes which were tainted
 	for (auto i = 0; i < length; ++i) {
@@ -310,9 +389,11 @@ int queryBufferContents(CPUState *cpu, target_ulong vAddr, uint32_t length) {
 		// not skip this byte.
 		hwaddr pAddr = panda_virt_to_phys(cpu, vAddr + i);
 		if (pAddr == (hwaddr)(-1)) {
-			std::cerr << "dependency_network: unable to query at address: " <<
-				vAddr << " (virtual), " << pAddr << " (physical)." << 
-				std::endl;
+			if (dependency_network.errors.count(
+					ErrorCategory::UntranslatablePage)) {
+				std::cerr << "dependency_network: unable to query at " <<
+					"address: " << vAddr + i << " (virtual)." << std::endl;
+			}
 			continue;
 		}
 		// Else, query the taint, increment counter if tainted
@@ -320,11 +401,8 @@ int queryBufferContents(CPUState *cpu, target_ulong vAddr, uint32_t length) {
 		if (cardinality > 0) ++bytesWithTaint;
 	}
 	
-	if (dependency_network.debug) {
-		std::cout << "dependency_network: found " << bytesWithTaint << 
-			" tainted bytes out of " << length << " at virtual address " <<
-			vAddr << std::endl;
-	}
+	if (dependency_network.debug) 
+		logEvent(LogType::Found, "found", bytesWithTaint, length, vAddr);
 	return bytesWithTaint;
 }
 
@@ -350,6 +428,10 @@ bool init_plugin(void *self) {
 	/// "sink_ip"     : The sink IP address, defaults to "0.0.0.0"
 	/// "sink_port"   : The sink port, defaults to "9999"
 	/// "debug"       : Should debug mode be used? Defaults to false
+	/// "logQueue"    : Event log queue size in records, defaults to 4096,
+	///                 or 0 to log synchronously
+	/// "errorSamples": Errors printed per category, defaults to 4, the rest
+	///                 are only counted
 	auto args = panda_get_args("dependency_network");
 	dependency_network.source.ip = panda_parse_string_opt(args, 
 		"source_ip", "0.0.0.0", "source ip address");
@@ -361,6 +443,11 @@ bool init_plugin(void *self) {
 		args, "sink_port", 9999, "sink port number");
 	dependency_network.debug = panda_parse_bool_opt(args, 
 		"debug", "debug mode");
+	uint32_t logQueue = panda_parse_uint32_opt(args, "logQueue", 4096,
+		"event log queue size in records, or 0 to log synchronously");
+	dependency_network.errors.setSamples(panda_parse_uint32_opt(args, 
+		"errorSamples", 4, "errors printed per category, the rest are only "
+		"counted"));
 	std::cout << "dependency_network: source IP: " << 
 		dependency_network.source.ip << std::endl;
 	std::cout << "dependency_network: source port: " << 
@@ -372,12 +459,19 @@ bool init_plugin(void *self) {
 	std::cout << "dependency_network: debug: " << 
 		dependency_network.debug << std::endl;
 	
+	// Start the logging thread, after the synchronous output of the setup
+	dependency_network.eventLog.start(logQueue);
+	
 	// Register SysCalls2 Callback Functions
 	PPP_REG_CB("syscalls2", on_sys_socketcall_return, on_socketcall_return);
 	PPP_REG_CB("syscalls2", on_sys_pread64_return, on_pread64_return);
 	PPP_REG_CB("syscalls2", on_sys_pwrite64_return, on_pwrite64_return);
 	PPP_REG_CB("syscalls2", on_sys_read_return, on_read_return);
 	PPP_REG_CB("syscalls2", on_sys_write_return, on_write_return);
+	PPP_REG_CB("syscalls2", on_sys_close_return, on_close_return);
+	PPP_REG_CB("syscalls2", on_sys_execve_enter, on_execve_enter);
+	PPP_REG_CB("syscalls2", on_sys_execve_return, on_execve_return);
+	PPP_REG_CB("syscalls2", on_sys_exit_group_enter, on_exit_group_enter);
 	
 	// Register the Before Block Execution Functions
 	panda_cb pcb;
@@ -393,10 +487,27 @@ bool init_plugin(void *self) {
 }
 
 void uninit_plugin(void *self) {
+	// Drain the event log, so that its records come before the summary
+	auto &log = dependency_network.eventLog;
+	log.stop();
+	
 	std::cout << "dependency_network: saw read of source? " << 
 		sawReadOfSource << std::endl;
 	std::cout << "dependency_network: saw write of sink? " << 
 		sawWriteOfSink << std::endl;
 	std::cout << "dependency_network: saw dependency? " << 
 		dependency << std::endl;
+	std::cout << "dependency_network: descriptors: " << targets.size() << 
+		" entries, " << targets.getStaleHits() << " stale hits avoided, " << 
+		targets.getSweptEntries() << " stale entries swept" << std::endl;
+	if (log.getCapacity() > 0) {
+		std::cout << "dependency_network: event log: wrote " << 
+			log.getWritten() << " records in " << log.getBatches() << 
+			" batches, dropped " << log.getDropped() << " records, queued " <<
+			"at most " << log.getHighWater() << "/" << log.getCapacity() << 
+			" records" << std::endl;
+	}
+	
+	// Output the tally of the errors, of which only the first were printed
+	dependency_network.errors.print(std::cout, "dependency_network");
 }
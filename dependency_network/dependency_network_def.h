@@ -20,6 +20,11 @@ extern "C" {
 	#include "taint2/taint2_ext.h"
 }
 
+#include "../dependency_common/async_log.h"
+#include "../dependency_common/descriptor_table.h"
+#include "../dependency_common/error_counter.h"
+#include "../dependency_common/guest_memory.h"
+
 struct Dependency_Network_Target {
 	std::string ip;                    // The IP Address as a string
 	unsigned short port;               // The port
@@ -51,6 +56,34 @@ struct Dependency_Network_Target {
 	bool operator!=(const Dependency_Network_Target &rhs);
 };
 
+/// <summary>
+/// Enumeration of the types of the records of the event log. The values of a
+/// record depend on its type.
+/// </summary>
+enum class LogType : uint16_t {
+	Text,                                  // Event is the whole line
+	Called,                                // Instruction
+	SocketCall,                            // Instruction, Call Type
+	Tainted,                               // Tainted Bytes, to IP Event
+	Other,                                 // FD of Other File / Socket
+	Labeling,                              // Length, Address
+	Labeled,                               // Labeled, Length, Address
+	Querying,                              // Length, Address
+	Found                                  // Tainted, Length, Address
+};
+
+/// <summary>
+/// Appends the line of text of the specified record of the event log to the
+/// specified string. This is called from the logging thread.
+/// </summary>
+/// <param name="record">
+/// The record to be formatted.
+/// </param>
+/// <param name="text">
+/// The string to which the text is appended.
+/// </param>
+void formatLogRecord(const LogRecord &record, std::string &text);
+
 struct Dependency_Network {
 	void *plugin_ptr = nullptr;            // The plugin pointer
 	bool debug = false;                    // Is running in debug?
@@ -59,42 +92,22 @@ struct Dependency_Network {
 	
 	Dependency_Network_Target source;      // The source address & port
 	Dependency_Network_Target sink;        // The sink address & port
+	
+	AsyncLog eventLog{formatLogRecord};    // The event log
+	ErrorCounter errors;                   // The errors by category
+	
+	// The ASID of each process, by PID, which is executing a new program
+	std::map<target_ulong, target_ulong> execs;
 };
 
 Dependency_Network dependency_network;     // The Plugin Structure
-std::map<                                  // The map of the unions of ASIDs
-	std::pair<target_ulong, uint32_t>,     // FDs to the network targets.
-	Dependency_Network_Target> targets;
+DescriptorTable<                           // The table of the unions of ASIDs
+	Dependency_Network_Target> targets;    // FDs to the network targets.
 
 bool sawReadOfSource = false;              // Was source target read from?
 bool sawWriteOfSink = false;               // Was sink target written to?
 bool dependency = false;                   // Was dependency seen?
 
-/// <summary>
-/// Returns a vector of size <paramref="size"> containing the values of T read 
-/// from the virtual memory address <paramref="addr">. This method assumes that
-/// the values in memory are adjacent to each other (in an array).
-/// </summary>
-/// <typeparam name="T">
-/// The type of values to be read from the memory address.
-/// </typeparam>
-/// <param name="cpu">
-/// The CPU State pointer.
-/// </param>
-/// <param name="addr">
-/// The virtual memory address to the start of the T values.
-/// </param>
-/// <param name="size">
-/// The number of arguments to be read in. This is equivalent to the number of
-/// elements returned in the vector.
-/// </param>
-/// <returns>
-/// The vector of size <paramref="size"> containing the values fetched from
-/// <paramref="addr">.
-/// </returns>
-template<typename T>
-std::vector<T> getMemoryValues(CPUState *cpu, uint32_t addr, uint32_t size);
-
 /// <summary>
 /// Taints the contents of the buffer at the specified virtual address and of 
 /// the specified length. This function does nothing if taint2 is not currently
@@ -111,6 +124,29 @@ std::vector<T> getMemoryValues(CPUState *cpu, uint32_t addr, uint32_t size);
 /// </param>
 void labelBufferContents(CPUState *cpu, target_ulong vAddr, uint32_t length);
 
+/// <summary>
+/// Pushes a record of the specified type into the event log.
+/// </summary>
+/// <param name="type">
+/// The type of the record.
+/// </param>
+/// <param name="event">
+/// The name of the event, which must be a string literal or otherwise live
+/// until the end of the replay, since it is only formatted later, by the
+/// logging thread.
+/// </param>
+/// <param name="first">
+/// The first value of the record, which depends on its type.
+/// </param>
+/// <param name="second">
+/// The second value of the record, which depends on its type.
+/// </param>
+/// <param name="third">
+/// The third value of the record, which depends on its type.
+/// </param>
+void logEvent(LogType type, const char *event, uint64_t first = 0, 
+		uint64_t second = 0, uint64_t third = 0);
+
 /// <summary>
 /// Callback function which can be called before a PANDA block translation.
 /// This particular function is used to enable the taint2 plugin if the current
@@ -128,6 +164,86 @@ void labelBufferContents(CPUState *cpu, target_ulong vAddr, uint32_t length);
 /// </returns>
 int on_before_block_translate(CPUState *cpu, target_ulong pc);
 
+/// <summary>
+/// Callback function for the syscalls2 "on_sys_close_return_t" event. This
+/// function forgets the network target of the closed file descriptor.
+/// </summary>
+/// <param name="cpu">
+/// The CPU state pointer.
+/// </param>
+/// <param name="pc">
+/// The program counter.
+/// </param>
+/// <param name="fd">
+/// The file descriptor which was closed.
+/// </param>
+void on_close_return(CPUState *cpu, target_ulong pc, uint32_t fd);
+
+/// <summary>
+/// Callback function for the syscalls2 "on_sys_execve_enter_t" event. This
+/// function remembers the ASID of the current process, so that its state can
+/// be forgotten if the new program is loaded, see
+/// <see cref="on_execve_return"/>.
+/// </summary>
+/// <param name="cpu">
+/// The CPU state pointer.
+/// </param>
+/// <param name="pc">
+/// The program counter.
+/// </param>
+/// <param name="filename">
+/// The virtual memory address of the name of the program.
+/// </param>
+/// <param name="argv">
+/// The virtual memory address of the arguments of the program.
+/// </param>
+/// <param name="envp">
+/// The virtual memory address of the environment of the program.
+/// </param>
+void on_execve_enter(CPUState *cpu, target_ulong pc, uint32_t filename,
+		uint32_t argv, uint32_t envp);
+
+/// <summary>
+/// Callback function for the syscalls2 "on_sys_execve_return_t" event. If the
+/// new program was loaded, this function forgets the network targets of all
+/// of the file descriptors of the old process, since the new program gets a
+/// new address space, under a new ASID. A failed execve keeps the old 
+/// program and its file descriptors.
+/// </summary>
+/// <param name="cpu">
+/// The CPU state pointer.
+/// </param>
+/// <param name="pc">
+/// The program counter.
+/// </param>
+/// <param name="filename">
+/// The virtual memory address of the name of the program.
+/// </param>
+/// <param name="argv">
+/// The virtual memory address of the arguments of the program.
+/// </param>
+/// <param name="envp">
+/// The virtual memory address of the environment of the program.
+/// </param>
+void on_execve_return(CPUState *cpu, target_ulong pc, uint32_t filename,
+		uint32_t argv, uint32_t envp);
+
+/// <summary>
+/// Callback function for the syscalls2 "on_sys_exit_group_enter_t" event. 
+/// This function forgets the network targets of all of the file descriptors 
+/// of the current process.
+/// </summary>
+/// <param name="cpu">
+/// The CPU state pointer.
+/// </param>
+/// <param name="pc">
+/// The program counter.
+/// </param>
+/// <param name="error_code">
+/// The exit code of the process.
+/// </param>
+void on_exit_group_enter(CPUState *cpu, target_ulong pc, int32_t error_code);
+
 /// <summary>
 /// Callback function for the syscalls2 "on_sys_pread64_return_t" event. This
 /// function checks if the file descriptor matches with a taint source, and if
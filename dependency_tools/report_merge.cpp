@@ -0,0 +1,452 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+// The configuration, the source name and the sink name of a flow
+typedef std::tuple<std::string, std::string, std::string> EdgeKey;
+
+/// <summary>
+/// Structure which holds the flows from a source to a sink in a single run.
+/// </summary>
+struct RunEdge {
+	uint64_t taintedBytes = 0;                 // # of Bytes Tainted
+	uint64_t flows = 0;                        // # of Flow Records
+	uint64_t first = UINT64_MAX;               // First Instruction Seen
+	uint64_t last = 0;                         // Last Instruction Seen
+};
+
+/// <summary>
+/// Structure which holds the flows from a source to a sink in every run.
+/// </summary>
+struct Edge {
+	uint64_t taintedBytes = 0;                 // # of Bytes Tainted
+	uint64_t flows = 0;                        // # of Flow Records
+	uint64_t first = UINT64_MAX;               // First Instruction Seen
+	uint64_t last = 0;                         // Last Instruction Seen
+	uint64_t runs = 0;                         // # of Runs with the Flow
+	std::vector<uint64_t> runSet;              // { Run -> Has the Flow? }
+};
+
+/// <summary>
+/// Structure which holds the reports to be merged, and the graph merged by
+/// the threads.
+/// </summary>
+struct Merge {
+	std::vector<std::string> reports;          // Report of each Run
+	std::atomic<size_t> nextReport{0};         // Next Report to Read
+
+	std::mutex lock;                           // Guards the Below
+	std::map<EdgeKey, Edge> edges;             // Merged Dependency Graph
+	uint64_t records = 0;                      // # of Records Read
+	uint64_t incomplete = 0;                   // # of Runs with Drops
+	bool failed = false;                       // Did a Report Fail?
+};
+
+/// <summary>
+/// Parses a quoted string which starts at the specified position of the
+/// specified line, escaped as in JSON, or as in CSV if requested.
+/// </summary>
+/// <returns>
+/// True if the string was closed, false otherwise. The position is moved
+/// past the closing quote.
+/// </returns>
+bool parseQuoted(const std::string &line, size_t &i, bool csv,
+		std::string &value) {
+	value.clear();
+	for (++i; i < line.size(); ++i) {
+		char c = line[i];
+		if (c == '"') {
+			// CSV escapes quotes by doubling them
+			if (csv && i + 1 < line.size() && line[i + 1] == '"') {
+				value += '"';
+				++i;
+				continue;
+			}
+
+			++i;
+			return true;
+		}
+
+		if (!csv && c == '\\' && i + 1 < line.size()) {
+			c = line[++i];
+			if (c == 'u' && i + 4 < line.size()) {
+				// Only control characters are escaped this way
+				value += static_cast<char>(strtol(
+					line.substr(i + 1, 4).c_str(), nullptr, 16));
+				i += 4;
+				continue;
+			}
+		}
+		value += c;
+	}
+
+	return false;
+}
+
+/// <summary>
+/// Parses a line of a report in JSON Lines format into its fields, which
+/// are the keys and values of a flat JSON object.
+/// </summary>
+/// <returns>
+/// True if the line was parsed, false otherwise.
+/// </returns>
+bool parseJSON(const std::string &line,
+		std::map<std::string, std::string> &fields) {
+	fields.clear();
+	size_t i = line.find('{');
+	if (i == std::string::npos) return false;
+
+	for (++i; i < line.size(); ) {
+		char c = line[i];
+		if (c == '}') return true;
+		if (c == ',' || c == ' ') {
+			++i;
+			continue;
+		}
+
+		std::string key, value;
+		if (c != '"' || !parseQuoted(line, i, false, key) ||
+				i >= line.size() || line[i] != ':') {
+			return false;
+		}
+
+		++i;
+		if (i < line.size() && line[i] == '"') {
+			if (!parseQuoted(line, i, false, value)) return false;
+		} else {
+			size_t end = line.find_first_of(",}", i);
+			if (end == std::string::npos) return false;
+			value = line.substr(i, end - i);
+			i = end;
+		}
+		fields[key] = value;
+	}
+
+	return false;
+}
+
+/// <summary>
+/// Parses a line of a report in CSV format into its values.
+/// </summary>
+/// <returns>
+/// True if the line was parsed, false otherwise.
+/// </returns>
+bool parseCSV(const std::string &line, std::vector<std::string> &values) {
+	values.clear();
+	size_t i = 0;
+	for (;;) {
+		std::string value;
+		if (i < line.size() && line[i] == '"') {
+			if (!parseQuoted(line, i, true, value)) return false;
+		} else {
+			size_t end = line.find(',', i);
+			if (end == std::string::npos) end = line.size();
+			value = line.substr(i, end - i);
+			i = end;
+		}
+		values.push_back(value);
+
+		if (i >= line.size()) return true;
+		if (line[i] != ',') return false;
+		++i;
+	}
+}
+
+/// <summary>
+/// Reads the specified report, in either format, and adds the flows of its
+/// flow records to the specified edges.
+/// </summary>
+/// <param name="report">
+/// The name of the report file.
+/// </param>
+/// <param name="edges">
+/// The edges of the run, to which the flows of the report are added.
+/// </param>
+/// <param name="records">
+/// The number of records read, which is incremented.
+/// </param>
+/// <param name="dropped">
+/// Set to whether the report dropped records.
+/// </param>
+/// <returns>
+/// True if the report was read, false otherwise.
+/// </returns>
+bool readReport(const std::string &report, std::map<EdgeKey, RunEdge> &edges,
+		uint64_t &records, bool &dropped) {
+	std::ifstream ifs(report);
+	if (!ifs.is_open()) {
+		std::cerr << "report_merge: failed to open \"" << report << "\"." <<
+			std::endl;
+		return false;
+	}
+
+	// A report in CSV format starts with its header, which names the columns
+	std::string line;
+	std::vector<std::string> columns, values;
+	std::map<std::string, std::string> fields;
+	bool first = true, csv = false, summary = false;
+	uint64_t read = 0, malformed = 0;
+	dropped = false;
+	while (std::getline(ifs, line)) {
+		if (line.empty()) continue;
+
+		bool header = first && line[0] != '{';
+		first = false;
+		if (header) {
+			csv = parseCSV(line, columns) && !columns.empty() &&
+				columns[0] == "record";
+			if (!csv) {
+				std::cerr << "report_merge: \"" << report << "\" is not a " <<
+					"report." << std::endl;
+				return false;
+			}
+			continue;
+		}
+
+		if (csv) {
+			fields.clear();
+			if (parseCSV(line, values) && values.size() == columns.size()) {
+				for (size_t i = 0; i < columns.size(); ++i)
+					fields[columns[i]] = values[i];
+			}
+		} else if (!parseJSON(line, fields)) {
+			fields.clear();
+		}
+
+		auto record = fields.find("record");
+		if (record == fields.end()) {
+			++malformed;
+			continue;
+		}
+		++read;
+
+		if (record->second == "flow") {
+			RunEdge &edge = edges[std::make_tuple(fields["configuration"],
+				fields["source"], fields["target"])];
+			uint64_t instruction = strtoull(fields["instruction"].c_str(),
+				nullptr, 10);
+			edge.taintedBytes += strtoull(fields["tainted"].c_str(), nullptr,
+				10);
+			edge.flows++;
+			edge.first = std::min(edge.first, instruction);
+			edge.last = std::max(edge.last, instruction);
+		} else if (record->second == "summary") {
+			summary = true;
+			dropped = strtoull(fields["dropped"].c_str(), nullptr, 10) > 0;
+		}
+	}
+
+	records += read;
+	if (malformed > 0) {
+		std::cerr << "report_merge: \"" << report << "\" has " << malformed <<
+			" malformed lines, which were skipped." << std::endl;
+	}
+	if (!summary) {
+		// The replay did not end, so the report is cut short
+		std::cerr << "report_merge: \"" << report << "\" has no summary, " <<
+			"only the flows before it ended are merged." << std::endl;
+		dropped = true;
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Body of each thread, which reads reports until none are left. The flows
+/// of each report are merged into the graph once it has been read, so that
+/// a thread only holds the flows of a single run at once.
+/// </summary>
+/// <param name="merge">
+/// The merge.
+/// </param>
+void readReports(Merge *merge) {
+	std::map<EdgeKey, RunEdge> edges;
+	size_t words = (merge->reports.size() + 63) / 64;
+
+	for (;;) {
+		size_t run = merge->nextReport++;
+		if (run >= merge->reports.size()) break;
+
+		edges.clear();
+		uint64_t records = 0;
+		bool dropped = false;
+		bool read = readReport(merge->reports[run], edges, records, dropped);
+
+		std::lock_guard<std::mutex> guard(merge->lock);
+		for (auto &runEdge : edges) {
+			Edge &edge = merge->edges[runEdge.first];
+			if (edge.runSet.empty()) edge.runSet.resize(words);
+
+			edge.taintedBytes += runEdge.second.taintedBytes;
+			edge.flows += runEdge.second.flows;
+			edge.first = std::min(edge.first, runEdge.second.first);
+			edge.last = std::max(edge.last, runEdge.second.last);
+			edge.runs++;
+			edge.runSet[run / 64] |= static_cast<uint64_t>(1) << (run % 64);
+		}
+		merge->records += records;
+		if (dropped) merge->incomplete++;
+		if (!read) merge->failed = true;
+	}
+}
+
+/// <summary>
+/// Formats the runs of the specified edge as ranges of run indices, such as
+/// "0-3 7 9-10".
+/// </summary>
+std::string formatRuns(const Edge &edge, size_t runs) {
+	std::string text;
+	size_t run = 0;
+	while (run < runs) {
+		auto has = [&](size_t i) {
+			return (edge.runSet[i / 64] >> (i % 64)) & 1;
+		};
+		if (!has(run)) {
+			++run;
+			continue;
+		}
+
+		size_t end = run;
+		while (end + 1 < runs && has(end + 1)) ++end;
+
+		if (!text.empty()) text += ' ';
+		text += std::to_string(run);
+		if (end > run) text += '-' + std::to_string(end);
+		run = end + 1;
+	}
+
+	return text;
+}
+
+/// <summary>
+/// Quotes the specified value for the CSV output, doubling its quotes.
+/// </summary>
+std::string quote(const std::string &value) {
+	std::string text = "\"";
+	for (char c : value) {
+		if (c == '"') text += '"';
+		text += c;
+	}
+
+	return text + "\"";
+}
+
+/// <summary>
+/// Prints the usage of this tool.
+/// </summary>
+void printUsage() {
+	std::cerr << "usage: report_merge [-l list] [-j threads] [-o output] " <<
+		"report..." << std::endl <<
+		"  -l list     file which names one more report on each line" <<
+		std::endl <<
+		"  -j threads  number of reports read at once, defaults to the " <<
+		"number of cores" << std::endl <<
+		"  -o output   CSV file to write the graph to, defaults to stdout" <<
+		std::endl;
+}
+
+/// <summary>
+/// Merges the streaming reports written by the report option of
+/// dependency_tracker in many runs into a single dependency graph, whose
+/// edges are the flows from sources to sinks keyed by the configuration and
+/// the names of the targets. Each report is read by one of a pool of
+/// threads, and the graph is output in CSV format, with the header line:
+/// "configuration,source,sink,tainted_bytes,flows,runs,first_instruction,
+/// last_instruction,run_list". The run list holds the ranges of the indices
+/// of the runs which had the flow, in the order the reports were given.
+/// </summary>
+int main(int argc, char **argv) {
+	Merge merge;
+	std::string output;
+	unsigned int threads = std::thread::hardware_concurrency();
+
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+
+		if (arg == "-l" && hasValue) {
+			std::ifstream list(argv[++i]);
+			if (!list.is_open()) {
+				std::cerr << "report_merge: failed to read reports from \"" <<
+					argv[i] << "\"." << std::endl;
+				return 1;
+			}
+
+			std::string report;
+			while (std::getline(list, report)) {
+				if (!report.empty()) merge.reports.push_back(report);
+			}
+		} else if (arg == "-j" && hasValue) {
+			threads = atoi(argv[++i]);
+		} else if (arg == "-o" && hasValue) {
+			output = argv[++i];
+		} else if (!arg.empty() && arg[0] != '-') {
+			merge.reports.push_back(arg);
+		} else {
+			printUsage();
+			return 1;
+		}
+	}
+
+	if (merge.reports.empty()) {
+		printUsage();
+		return 1;
+	}
+
+	// Read the reports with a pool of threads, no larger than the number of
+	// reports.
+	auto start = std::chrono::steady_clock::now();
+	threads = std::max(1u, std::min<unsigned int>(threads,
+		merge.reports.size()));
+	std::vector<std::thread> pool;
+	for (unsigned int i = 0; i < threads; ++i)
+		pool.emplace_back(readReports, &merge);
+	for (auto &thread : pool) thread.join();
+	auto elapsed = std::chrono::duration<double>(
+		std::chrono::steady_clock::now() - start).count();
+
+	// Output the graph
+	std::ofstream ofs;
+	if (!output.empty()) {
+		ofs.open(output);
+		if (!ofs.is_open()) {
+			std::cerr << "report_merge: failed to open \"" << output <<
+				"\"." << std::endl;
+			return 1;
+		}
+	}
+	std::ostream &out = output.empty() ? std::cout : ofs;
+
+	out << "configuration,source,sink,tainted_bytes,flows,runs," <<
+		"first_instruction,last_instruction,run_list" << std::endl;
+	for (auto &edge : merge.edges) {
+		out << quote(std::get<0>(edge.first)) << "," <<
+			quote(std::get<1>(edge.first)) << "," <<
+			quote(std::get<2>(edge.first)) << "," <<
+			edge.second.taintedBytes << "," << edge.second.flows << "," <<
+			edge.second.runs << "," << edge.second.first << "," <<
+			edge.second.last << "," <<
+			quote(formatRuns(edge.second, merge.reports.size())) << "\n";
+	}
+	out.flush();
+
+	std::cerr << "report_merge: merged " << merge.edges.size() << " flows " <<
+		"from " << merge.records << " records of " << merge.reports.size() <<
+		" reports with " << threads << " threads in " << elapsed <<
+		" seconds." << std::endl;
+	if (merge.incomplete > 0) {
+		std::cerr << "report_merge: " << merge.incomplete << " reports " <<
+			"dropped records or were cut short." << std::endl;
+	}
+	return (merge.failed || !out.good()) ? 1 : 0;
+}
@@ -0,0 +1,292 @@
+#include <chrono>
+#include <fcntl.h>
+#include <iostream>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// Size of the header and of a directory entry of a stats file, see the
+// StatsFile class of dependency_tracker for the format.
+static const size_t HEADER_SIZE = 64;
+static const size_t ENTRY_SIZE = 64;
+
+// Number of times a snapshot is read again if a table moved meanwhile
+static const int MAX_ATTEMPTS = 16;
+
+/// <summary>
+/// Structure which holds a copy of a table of a stats file.
+/// </summary>
+struct StatsTable {
+	uint32_t type;                             // 1 Sources, 2 Sinks
+	uint32_t columns;                          // # of Columns
+	std::string configuration;                 // Name of the Configuration
+	uint64_t rows;                             // # of Rows
+	std::vector<std::string> targets;          // { Row -> Target Name }
+	std::vector<uint64_t> counters;            // { Row, Column -> Counter }
+};
+
+/// <summary>
+/// Structure which holds a consistent copy of a stats file.
+/// </summary>
+struct StatsSnapshot {
+	uint64_t instruction;                      // Instruction Reached
+	std::vector<StatsTable> tables;            // Tables of the File
+};
+
+/// <summary>
+/// Class which opens a stats file for reading, and copies values out of it
+/// without reading past its end. The values are copied with pread rather
+/// than through a mapping, since the replay truncates the file when it ends,
+/// and reading a mapping past the end of the file raises SIGBUS.
+/// </summary>
+class StatsReader {
+public:
+	/// <summary>
+	/// Opens the specified stats file, as large as it currently is.
+	/// </summary>
+	StatsReader(const std::string &file) {
+		this->size = 0;
+		this->fd = open(file.c_str(), O_RDONLY);
+		if (this->fd < 0) return;
+
+		struct stat status;
+		if (fstat(this->fd, &status) != 0 ||
+				(size_t)status.st_size < HEADER_SIZE) {
+			close(this->fd);
+			this->fd = -1;
+			return;
+		}
+		this->size = status.st_size;
+	}
+
+	/// <summary>
+	/// Closes the stats file.
+	/// </summary>
+	~StatsReader() {
+		if (this->fd >= 0) close(this->fd);
+	}
+
+	/// <summary>
+	/// Copies the specified number of bytes at the specified offset, if they
+	/// are all within the file.
+	/// </summary>
+	bool copy(uint64_t offset, void *value, size_t bytes) const {
+		if (this->fd < 0 || offset > this->size ||
+				bytes > this->size - offset) {
+			return false;
+		}
+
+		uint8_t *buffer = static_cast<uint8_t*>(value);
+		while (bytes > 0) {
+			ssize_t result = pread(this->fd, buffer, bytes, offset);
+			if (result <= 0) return false;
+
+			buffer += result;
+			offset += result;
+			bytes -= result;
+		}
+		return true;
+	}
+
+	/// <summary>
+	/// Reads the 64 bit value at the specified offset, or zero if it is not
+	/// within the file.
+	/// </summary>
+	uint64_t get(uint64_t offset) const {
+		uint64_t value = 0;
+		this->copy(offset, &value, sizeof(value));
+		return value;
+	}
+
+	/// <summary>
+	/// Checks if the file was opened.
+	/// </summary>
+	bool isOpen() const {
+		return this->fd >= 0;
+	}
+protected:
+	int fd;                                    // Descriptor of the File
+	size_t size;                               // Size of the File
+};
+
+/// <summary>
+/// Copies the tables of the stats file, as of one generation of its
+/// directory.
+/// </summary>
+/// <returns>
+/// True if the copy is consistent, false if the file is not a stats file or
+/// if a table moved while it was copied.
+/// </returns>
+bool readSnapshot(const StatsReader &reader, StatsSnapshot &snapshot) {
+	char magic[8];
+	uint32_t version = 0, tables = 0;
+	if (!reader.copy(0, magic, sizeof(magic)) ||
+			memcmp(magic, "FDTSTATS", 8) != 0 ||
+			!reader.copy(8, &version, sizeof(version)) || version != 1 ||
+			!reader.copy(12, &tables, sizeof(tables))) {
+		return false;
+	}
+
+	uint64_t generation = reader.get(32);
+	if (generation & 1) return false;
+
+	snapshot.instruction = reader.get(16);
+	snapshot.tables.clear();
+	for (uint32_t i = 0; i < tables; ++i) {
+		uint64_t entry = HEADER_SIZE + i * ENTRY_SIZE;
+		uint32_t fields[4] = { 0, 0, 0, 0 };
+		if (!reader.copy(entry, fields, sizeof(fields))) return false;
+
+		StatsTable table;
+		table.type = fields[0];
+		table.columns = fields[1];
+		table.configuration.resize(fields[3]);
+		if (!reader.copy(reader.get(entry + 16), &table.configuration[0],
+				fields[3])) {
+			return false;
+		}
+
+		// Copy the columns, which hold the description of the target of
+		// each row first.
+		table.rows = reader.get(entry + 24);
+		uint64_t capacity = reader.get(entry + 32);
+		uint64_t offset = reader.get(entry + 40);
+		if (table.rows > capacity || table.columns < 2) return false;
+
+		table.counters.resize(table.rows * table.columns);
+		for (uint32_t column = 0; column < table.columns; ++column) {
+			if (!reader.copy(offset + column * capacity * sizeof(uint64_t),
+					table.counters.data() + column * table.rows,
+					table.rows * sizeof(uint64_t))) {
+				return false;
+			}
+		}
+
+		for (uint64_t row = 0; row < table.rows; ++row) {
+			std::string name(table.counters[table.rows + row] & UINT32_MAX,
+				'\0');
+			if (!reader.copy(table.counters[row], &name[0], name.size()))
+				return false;
+			table.targets.push_back(name);
+		}
+
+		snapshot.tables.push_back(std::move(table));
+	}
+
+	return reader.get(32) == generation;
+}
+
+/// <summary>
+/// Returns the specified name as a quoted CSV field, with each of its quotes
+/// doubled.
+/// </summary>
+std::string quote(const std::string &name) {
+	std::string field = "\"";
+	for (char c : name) {
+		if (c == '"') field += '"';
+		field += c;
+	}
+
+	return field + "\"";
+}
+
+/// <summary>
+/// Prints the specified snapshot in CSV format.
+/// </summary>
+void printSnapshot(const StatsSnapshot &snapshot) {
+	std::cout << "configuration,type,target,bytes,tainted_bytes,operations," <<
+		"vectored_operations,mapped_bytes,label\n";
+
+	for (auto &table : snapshot.tables) {
+		for (uint64_t row = 0; row < table.rows; ++row) {
+			auto counter = [&](uint32_t column) {
+				return (column < table.columns) ?
+					table.counters[column * table.rows + row] : 0;
+			};
+
+			std::cout << quote(table.configuration) << ",";
+			if (table.type == 1) {
+				// label, labeled, mapped, total, reads, vectored reads
+				std::cout << "source," << quote(table.targets[row]) << "," <<
+					counter(5) << "," << counter(3) << "," << counter(6) <<
+					"," << counter(7) << "," << counter(4) << "," <<
+					counter(2) << "\n";
+			} else {
+				// total, tainted, writes, vectored writes
+				std::cout << "sink," << quote(table.targets[row]) << "," <<
+					counter(2) << "," << counter(3) << "," << counter(4) <<
+					"," << counter(5) << ",,\n";
+			}
+		}
+	}
+
+	std::cout.flush();
+	std::cerr << "stats_dump: replay reached instruction " <<
+		snapshot.instruction << "." << std::endl;
+}
+
+/// <summary>
+/// Prints the usage of this tool.
+/// </summary>
+void printUsage() {
+	std::cerr << "usage: stats_dump [-w seconds] stats" << std::endl <<
+		"  -w seconds  print the counters again every this many seconds" <<
+		std::endl;
+}
+
+/// <summary>
+/// Prints the counters of the sources and sinks of each configuration from
+/// the stats file written by the stats option of dependency_tracker, in CSV
+/// format, while the replay runs or after it ended.
+/// </summary>
+int main(int argc, char **argv) {
+	std::string file;
+	int interval = 0;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "-w" && i + 1 < argc) {
+			interval = atoi(argv[++i]);
+		} else if (!arg.empty() && arg[0] != '-' && file.empty()) {
+			file = arg;
+		} else {
+			printUsage();
+			return 1;
+		}
+	}
+
+	if (file.empty()) {
+		printUsage();
+		return 1;
+	}
+
+	for (;;) {
+		// The file may grow between snapshots, so it is opened again each
+		// time, and read again if a table moved meanwhile.
+		StatsSnapshot snapshot;
+		bool read = false;
+		for (int attempt = 0; !read && attempt < MAX_ATTEMPTS; ++attempt) {
+			StatsReader reader(file);
+			if (!reader.isOpen()) break;
+
+			read = readSnapshot(reader, snapshot);
+		}
+
+		if (!read) {
+			std::cerr << "stats_dump: \"" << file << "\" could not be read." <<
+				std::endl;
+			return 1;
+		}
+
+		printSnapshot(snapshot);
+		if (interval <= 0) return 0;
+
+		std::this_thread::sleep_for(std::chrono::seconds(interval));
+		std::cout << std::endl;
+	}
+}
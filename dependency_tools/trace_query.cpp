@@ -0,0 +1,359 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "trace_reader.h"
+
+/// <summary>
+/// Structure which represents the flow from a source to a sink.
+/// </summary>
+struct Flow {
+	uint64_t taintedBytes;                     // # of Bytes Tainted
+	uint64_t writes;                           // # of Writes with Taint
+};
+
+// The flows of the traces, by configuration, source kind and name, and sink
+// kind and name, so that targets of different kinds with the same name are
+// kept apart
+typedef std::map<std::tuple<uint32_t, uint8_t, std::string, uint8_t,
+	std::string>, Flow> Flows;
+
+/// <summary>
+/// Structure which holds the question asked of the traces, and the answer
+/// accumulated by the threads.
+/// </summary>
+struct Query {
+	std::set<std::pair<uint8_t, std::string>> sinks;   // Sinks, or All
+	std::set<std::pair<uint8_t, std::string>> sources; // Sources, or All
+	int64_t configuration = -1;                        // Configuration, or All
+
+	std::vector<std::string> shards;                   // Trace Shards
+	std::atomic<size_t> nextShard{0};                  // Next Shard to Read
+
+	std::mutex lock;                                   // Guards the Below
+	Flows flows;                                       // Flows of All Shards
+	uint64_t records = 0;                              // # of Records Read
+	bool failed = false;                               // Did a Shard Fail?
+};
+
+/// <summary>
+/// Returns the code of the specified target kind, as in the sources and sinks
+/// files of dependency_tracker.
+/// </summary>
+/// <param name="kind">
+/// The kind of the target.
+/// </param>
+/// <returns>
+/// The static code of the kind.
+/// </returns>
+const char* getKindCode(uint8_t kind) {
+	switch (kind) {
+	case 1: return "f";
+	case 2: return "n";
+	case 3: return "c";
+	}
+
+	return "?";
+}
+
+/// <summary>
+/// Parses the targets from the specified CSV file, in the same format as the
+/// sources and sinks files of dependency_tracker: "f,name", "c,name" or
+/// "n,ip,port" on each line.
+/// </summary>
+/// <param name="file">
+/// The name of the CSV file.
+/// </param>
+/// <param name="targets">
+/// The set to which the kind and the name of each target is added.
+/// </param>
+/// <returns>
+/// True if the file was parsed, false otherwise.
+/// </returns>
+bool parseTargets(const std::string &file,
+		std::set<std::pair<uint8_t, std::string>> &targets) {
+	std::ifstream ifs(file);
+	if (!ifs.is_open()) return false;
+
+	std::string line;
+	unsigned int lineNumber = 0;
+	while (std::getline(ifs, line)) {
+		++lineNumber;
+
+		// Split the line on commas, dropping the quotes around names
+		line.erase(std::remove(line.begin(), line.end(), '"'), line.end());
+		std::vector<std::string> tokens;
+		std::stringstream ss(line);
+		std::string token;
+		while (std::getline(ss, token, ',')) {
+			if (!token.empty()) tokens.push_back(token);
+		}
+		if (tokens.empty()) continue;
+
+		if (tokens.size() == 2 && tokens[0] == "f") {
+			targets.emplace(1, tokens[1]);
+		} else if (tokens.size() == 3 && tokens[0] == "n") {
+			targets.emplace(2, tokens[1] + "::" +
+				std::to_string(atoi(tokens[2].c_str())));
+		} else if (tokens.size() == 2 && tokens[0] == "c") {
+			targets.emplace(3, tokens[1]);
+		} else {
+			std::cerr << "trace_query: unknown target on line " <<
+				lineNumber << " of \"" << file << "\"." << std::endl;
+		}
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Reads the specified shard, and adds the flows to the queried sinks from
+/// the queried sources found in its writes to the specified flows.
+/// </summary>
+/// <param name="query">
+/// The query.
+/// </param>
+/// <param name="shard">
+/// The name of the trace shard.
+/// </param>
+/// <param name="flows">
+/// The flows to which the flows of the shard are added.
+/// </param>
+/// <param name="records">
+/// The number of records read, which is incremented.
+/// </param>
+/// <returns>
+/// True if the shard was read, false otherwise.
+/// </returns>
+bool readShard(const Query &query, const std::string &shard, Flows &flows,
+		uint64_t &records) {
+	TraceReader reader;
+	std::string error;
+	if (!reader.open(shard, error)) {
+		std::cerr << "trace_query: \"" << shard << "\" " << error << "." <<
+			std::endl;
+		return false;
+	}
+
+	// Resolve the query against the IDs of this shard once, so that each
+	// record is only checked with a lookup by ID.
+	auto &targets = reader.getTargets();
+	auto &labels = reader.getLabels();
+	std::vector<bool> isSink(targets.size());
+	for (size_t id = 0; id < targets.size(); ++id) {
+		isSink[id] = query.sinks.empty() || query.sinks.count(
+			std::make_pair(targets[id].kind, targets[id].name));
+	}
+
+	std::vector<bool> isLabel(labels.size());
+	for (size_t label = 0; label < labels.size(); ++label) {
+		const TraceTarget &source = targets[labels[label].source];
+		isLabel[label] = (query.configuration < 0 ||
+			labels[label].configuration == query.configuration) &&
+			(query.sources.empty() || query.sources.count(
+			std::make_pair(source.kind, source.name)));
+	}
+
+	TraceEvent event;
+	uint64_t read = 0;
+	while (reader.next(event)) {
+		++read;
+		if (event.type == TraceType::Source ||
+				event.target >= isSink.size() || !isSink[event.target])
+			continue;
+
+		for (auto &count : event.histogram) {
+			if (count.first >= labels.size() || !isLabel[count.first])
+				continue;
+
+			const TraceLabel &label = labels[count.first];
+			const TraceTarget &source = targets[label.source];
+			const TraceTarget &sink = targets[event.target];
+			Flow &flow = flows[std::make_tuple(label.configuration,
+				source.kind, source.name, sink.kind, sink.name)];
+			flow.taintedBytes += count.second;
+			flow.writes++;
+		}
+	}
+
+	records += read;
+	if (reader.isCorrupt()) {
+		std::cerr << "trace_query: \"" << shard << "\" has a corrupt " <<
+			"record, only " << read << " of " << reader.getRecords() <<
+			" records were read." << std::endl;
+		return false;
+	}
+	if (!reader.isComplete()) {
+		std::cerr << "trace_query: \"" << shard << "\" was not closed, " <<
+			"its " << read << " records have no table of targets and " <<
+			"labels." << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Body of each thread, which reads shards until none are left, and merges
+/// the flows it found into the flows of the query.
+/// </summary>
+/// <param name="query">
+/// The query.
+/// </param>
+void readShards(Query *query) {
+	Flows flows;
+	uint64_t records = 0;
+	bool failed = false;
+
+	for (;;) {
+		size_t shard = query->nextShard++;
+		if (shard >= query->shards.size()) break;
+
+		if (!readShard(*query, query->shards[shard], flows, records))
+			failed = true;
+	}
+
+	std::lock_guard<std::mutex> guard(query->lock);
+	for (auto &flow : flows) {
+		Flow &total = query->flows[flow.first];
+		total.taintedBytes += flow.second.taintedBytes;
+		total.writes += flow.second.writes;
+	}
+	query->records += records;
+	query->failed = query->failed || failed;
+}
+
+/// <summary>
+/// Returns the specified name as a quoted CSV field, with each of its quotes
+/// doubled.
+/// </summary>
+std::string quote(const std::string &name) {
+	std::string field = "\"";
+	for (char c : name) {
+		if (c == '"') field += '"';
+		field += c;
+	}
+
+	return field + "\"";
+}
+
+/// <summary>
+/// Prints the usage of this tool.
+/// </summary>
+void printUsage() {
+	std::cerr << "usage: trace_query [-s sinks] [-r sources] [-c config] " <<
+		"[-j threads] [-o output] shard..." << std::endl <<
+		"  -s sinks    only count writes to the targets of this file" <<
+		std::endl <<
+		"  -r sources  only count labels of the targets of this file" <<
+		std::endl <<
+		"  -c config   only count labels of this configuration index" <<
+		std::endl <<
+		"  -j threads  number of shards read at once, defaults to the " <<
+		"number of cores" << std::endl <<
+		"  -o output   CSV file to write the flows to, defaults to stdout" <<
+		std::endl;
+}
+
+/// <summary>
+/// Answers a source and sink question from the event traces written by the
+/// trace option of dependency_tracker, without replaying. Each shard is read
+/// by one of a pool of threads, and the flows from the queried sources to
+/// the queried sinks are output in CSV format, with the header line:
+/// "configuration,source_kind,source,sink_kind,sink,tainted_bytes,writes",
+/// where the kinds are coded as in the sources and sinks files.
+/// </summary>
+int main(int argc, char **argv) {
+	Query query;
+	std::string output;
+	unsigned int threads = std::thread::hardware_concurrency();
+
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+
+		if (arg == "-s" && hasValue) {
+			if (!parseTargets(argv[++i], query.sinks)) {
+				std::cerr << "trace_query: failed to read sinks from \"" <<
+					argv[i] << "\"." << std::endl;
+				return 1;
+			}
+		} else if (arg == "-r" && hasValue) {
+			if (!parseTargets(argv[++i], query.sources)) {
+				std::cerr << "trace_query: failed to read sources from \"" <<
+					argv[i] << "\"." << std::endl;
+				return 1;
+			}
+		} else if (arg == "-c" && hasValue) {
+			query.configuration = atoll(argv[++i]);
+		} else if (arg == "-j" && hasValue) {
+			threads = atoi(argv[++i]);
+		} else if (arg == "-o" && hasValue) {
+			output = argv[++i];
+		} else if (!arg.empty() && arg[0] != '-') {
+			query.shards.push_back(arg);
+		} else {
+			printUsage();
+			return 1;
+		}
+	}
+
+	if (query.shards.empty()) {
+		printUsage();
+		return 1;
+	}
+
+	// Read the shards with a pool of threads, no larger than the number of
+	// shards.
+	auto start = std::chrono::steady_clock::now();
+	threads = std::max(1u, std::min<unsigned int>(threads,
+		query.shards.size()));
+	std::vector<std::thread> pool;
+	for (unsigned int i = 0; i < threads; ++i)
+		pool.emplace_back(readShards, &query);
+	for (auto &thread : pool) thread.join();
+	auto elapsed = std::chrono::duration<double>(
+		std::chrono::steady_clock::now() - start).count();
+
+	// Output the flows
+	std::ofstream ofs;
+	if (!output.empty()) {
+		ofs.open(output);
+		if (!ofs.is_open()) {
+			std::cerr << "trace_query: failed to open \"" << output <<
+				"\"." << std::endl;
+			return 1;
+		}
+	}
+	std::ostream &out = output.empty() ? std::cout : ofs;
+
+	out << "configuration,source_kind,source,sink_kind,sink,tainted_bytes," <<
+		"writes" << std::endl;
+	for (auto &flow : query.flows) {
+		out << std::get<0>(flow.first) << "," <<
+			getKindCode(std::get<1>(flow.first)) << "," <<
+			quote(std::get<2>(flow.first)) << "," <<
+			getKindCode(std::get<3>(flow.first)) << "," <<
+			quote(std::get<4>(flow.first)) << "," <<
+			flow.second.taintedBytes << "," << flow.second.writes << "\n";
+	}
+	out.flush();
+
+	std::cerr << "trace_query: read " << query.records << " records from " <<
+		query.shards.size() << " shards with " << threads << " threads in " <<
+		elapsed << " seconds." << std::endl;
+	return (query.failed || !out.good()) ? 1 : 0;
+}
@@ -0,0 +1,350 @@
+#ifndef DEPENDENCY_TOOLS_TRACE_READER
+#define DEPENDENCY_TOOLS_TRACE_READER
+
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+/// <summary>
+/// Enumeration of the types of the records of an event trace, which match
+/// the TraceRecord enumeration of dependency_tracker.
+/// </summary>
+enum class TraceType : uint8_t {
+	Source = 0,                                // Source was Labeled
+	Sink = 1,                                  // Sink was Queried
+	Write = 2                                  // Other Target was Written
+};
+
+/// <summary>
+/// Structure which represents a target of an event trace.
+/// </summary>
+struct TraceTarget {
+	uint8_t kind;                              // 1 File, 2 Network, 3 Channel
+	std::string name;                          // Name of the Target
+};
+
+/// <summary>
+/// Structure which represents the owner of a label of an event trace.
+/// </summary>
+struct TraceLabel {
+	uint32_t configuration;                    // Index of Configuration
+	uint32_t source;                           // ID of Source Target
+};
+
+/// <summary>
+/// Structure which represents a single decoded record of an event trace.
+/// </summary>
+struct TraceEvent {
+	TraceType type;                            // Type of the Record
+	uint64_t instruction;                      // Instruction Count
+	uint64_t asid;                             // ASID of the Process
+	uint32_t fd;                               // File Descriptor
+	uint32_t target;                           // ID of the Target
+	uint64_t length;                           // # of Bytes Moved
+	uint64_t tainted;                          // # of Bytes Tainted
+	uint32_t label;                            // Label of a Source Record
+
+	// The labels found by a sink or a write record, and their byte counts
+	std::vector<std::pair<uint32_t, uint64_t>> histogram;
+};
+
+/// <summary>
+/// Class which reads an event trace, or a single shard of one, written by the
+/// trace option of dependency_tracker. The file is mapped, its table of
+/// targets and labels is decoded when it is opened, and its records are then
+/// decoded one at a time. The records of a trace which was never closed can
+/// still be read, but it has no table. See the EventTrace class of
+/// dependency_tracker for the format.
+/// </summary>
+class TraceReader {
+public:
+	/// <summary>
+	/// Creates a new Trace Reader, which is not open.
+	/// </summary>
+	TraceReader() {
+		this->data = nullptr;
+		this->size = 0;
+		this->records = 0;
+		this->cursor = nullptr;
+		this->sectionEnd = nullptr;
+		this->instruction = 0;
+		this->asid = 0;
+		this->corrupt = false;
+		this->complete = false;
+	}
+
+	/// <summary>
+	/// Copying of Trace Reader instances is forbidden.
+	/// </summary>
+	TraceReader(const TraceReader&) = delete;
+
+	/// <summary>
+	/// Unmaps the trace, if it is open.
+	/// </summary>
+	~TraceReader() {
+		if (this->data) munmap(const_cast<uint8_t*>(this->data), this->size);
+	}
+
+	/// <summary>
+	/// Returns the owners of the labels of the trace, by label.
+	/// </summary>
+	/// <returns>
+	/// The constant reference to the labels.
+	/// </returns>
+	const std::vector<TraceLabel>& getLabels() const {
+		return this->labels;
+	}
+
+	/// <summary>
+	/// Returns the number of records of the trace, as stored in its header.
+	/// </summary>
+	/// <returns>
+	/// The number of records.
+	/// </returns>
+	uint64_t getRecords() const {
+		return this->records;
+	}
+
+	/// <summary>
+	/// Returns the targets of the trace, by ID.
+	/// </summary>
+	/// <returns>
+	/// The constant reference to the targets.
+	/// </returns>
+	const std::vector<TraceTarget>& getTargets() const {
+		return this->targets;
+	}
+
+	/// <summary>
+	/// Checks if the trace was closed, so that it has a table of targets and
+	/// labels. The targets and the labels of a trace which was not closed are
+	/// empty, and the targets of its records are not checked.
+	/// </summary>
+	/// <returns>
+	/// True if the trace is complete, false otherwise.
+	/// </returns>
+	bool isComplete() const {
+		return this->complete;
+	}
+
+	/// <summary>
+	/// Checks if a record of the trace could not be decoded, which ends the
+	/// records early.
+	/// </summary>
+	/// <returns>
+	/// True if the trace is corrupt, false otherwise.
+	/// </returns>
+	bool isCorrupt() const {
+		return this->corrupt;
+	}
+
+	/// <summary>
+	/// Decodes the next record of the trace.
+	/// </summary>
+	/// <param name="event">
+	/// The event to which the record is decoded.
+	/// </param>
+	/// <returns>
+	/// True if a record was decoded, false if there are no more records, or
+	/// if the record is corrupt.
+	/// </returns>
+	bool next(TraceEvent &event) {
+		if (this->corrupt || this->cursor >= this->sectionEnd) return false;
+
+		uint64_t type = 0, instruction = 0, asid = 0, fd = 0, target = 0;
+		uint64_t count = 0;
+		bool decoded = this->get(type) && this->get(instruction) &&
+			this->get(asid) && this->get(fd) && this->get(target) &&
+			this->get(event.length) && this->get(event.tainted) &&
+			type <= static_cast<uint8_t>(TraceType::Write);
+
+		// The instruction count is a delta, and the ASID a zigzag delta
+		this->instruction += instruction;
+		this->asid += (asid >> 1) ^ (0 - (asid & 1));
+
+		event.type = static_cast<TraceType>(type);
+		event.instruction = this->instruction;
+		event.asid = this->asid;
+		event.fd = static_cast<uint32_t>(fd);
+		event.target = static_cast<uint32_t>(target >> 2);
+		event.label = 0;
+		event.histogram.clear();
+
+		if (decoded && event.type == TraceType::Source) {
+			uint64_t label = 0;
+			decoded = this->get(label);
+			event.label = static_cast<uint32_t>(label);
+		} else if (decoded) {
+			decoded = this->get(count);
+			for (uint64_t i = 0; decoded && i < count; ++i) {
+				uint64_t label = 0, bytes = 0;
+				decoded = this->get(label) && this->get(bytes);
+				event.histogram.emplace_back(static_cast<uint32_t>(label),
+					bytes);
+			}
+		}
+
+		if (!decoded || (this->complete &&
+				event.target >= this->targets.size())) {
+			this->corrupt = true;
+			return false;
+		}
+
+		return true;
+	}
+
+	/// <summary>
+	/// Opens and maps the specified trace, and decodes its table.
+	/// </summary>
+	/// <param name="file">
+	/// The name of the trace file.
+	/// </param>
+	/// <param name="error">
+	/// The string to which the reason is written, if the trace cannot be
+	/// opened.
+	/// </param>
+	/// <returns>
+	/// True if the trace was opened, false otherwise.
+	/// </returns>
+	bool open(const std::string &file, std::string &error) {
+		int fd = ::open(file.c_str(), O_RDONLY);
+		if (fd < 0) {
+			error = "cannot be opened";
+			return false;
+		}
+
+		struct stat status;
+		void *data = MAP_FAILED;
+		if (fstat(fd, &status) == 0 && (size_t)status.st_size >= HEADER_SIZE) {
+			data = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd,
+				0);
+		}
+		::close(fd);
+
+		if (data == MAP_FAILED) {
+			error = "is too short or cannot be mapped";
+			return false;
+		}
+		this->data = static_cast<const uint8_t*>(data);
+		this->size = status.st_size;
+
+		// Check the header. The offset of the table is only filled in once the
+		// trace is closed.
+		uint32_t version;
+		uint64_t recordBytes, tableOffset;
+		memcpy(&version, this->data + 8, sizeof(version));
+		memcpy(&this->records, this->data + 16, sizeof(this->records));
+		memcpy(&recordBytes, this->data + 24, sizeof(recordBytes));
+		memcpy(&tableOffset, this->data + 32, sizeof(tableOffset));
+		if (memcmp(this->data, "FDTTRACE", 8) != 0) {
+			error = "is not a trace";
+			return false;
+		}
+		if (version != 1) {
+			error = "has an unknown version";
+			return false;
+		}
+		if (recordBytes > this->size - HEADER_SIZE || (tableOffset != 0 &&
+				tableOffset != HEADER_SIZE + recordBytes)) {
+			error = "has a corrupt header";
+			return false;
+		}
+
+		// A trace which was not closed has no table, but the header still
+		// counts the records appended
+		this->cursor = this->data + HEADER_SIZE;
+		this->sectionEnd = this->cursor + recordBytes;
+		this->complete = tableOffset != 0;
+		if (!this->complete) return true;
+
+		// Decode the table of targets and labels at the end of the trace
+		this->cursor = this->data + tableOffset;
+		this->sectionEnd = this->data + this->size;
+		if (!this->readTable()) {
+			error = "has a corrupt table";
+			return false;
+		}
+
+		this->cursor = this->data + HEADER_SIZE;
+		this->sectionEnd = this->data + tableOffset;
+		return true;
+	}
+
+	/// <summary>
+	/// Assignment of Trace Reader instances is forbidden.
+	/// </summary>
+	TraceReader& operator=(const TraceReader&) = delete;
+protected:
+	/// <summary>
+	/// Decodes the next unsigned LEB128 varint, without reading past the end
+	/// of the current section.
+	/// </summary>
+	bool get(uint64_t &value) {
+		value = 0;
+		for (unsigned shift = 0; shift < 64; shift += 7) {
+			if (this->cursor >= this->sectionEnd) return false;
+
+			uint8_t byte = *this->cursor++;
+			value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+			if (!(byte & 0x80)) return true;
+		}
+
+		return false;
+	}
+
+	/// <summary>
+	/// Decodes the table of targets and labels at the cursor.
+	/// </summary>
+	bool readTable() {
+		uint64_t count;
+		if (!this->get(count)) return false;
+		for (uint64_t i = 0; i < count; ++i) {
+			uint64_t kind, length;
+			if (!this->get(kind) || !this->get(length)) return false;
+			if (length > static_cast<size_t>(this->sectionEnd - this->cursor))
+				return false;
+
+			this->targets.push_back(TraceTarget{ static_cast<uint8_t>(kind),
+				std::string(reinterpret_cast<const char*>(this->cursor),
+				length) });
+			this->cursor += length;
+		}
+
+		if (!this->get(count)) return false;
+		for (uint64_t i = 0; i < count; ++i) {
+			uint64_t configuration, source;
+			if (!this->get(configuration) || !this->get(source)) return false;
+			if ((source >> 2) >= this->targets.size()) return false;
+
+			this->labels.push_back(TraceLabel{
+				static_cast<uint32_t>(configuration),
+				static_cast<uint32_t>(source >> 2) });
+		}
+
+		return true;
+	}
+
+	static const size_t HEADER_SIZE = 40;      // Size of the File Header
+
+	const uint8_t *data;                       // Mapping of the Trace
+	size_t size;                               // Size of the Trace
+	uint64_t records;                          // # of Records in Header
+	const uint8_t *cursor;                     // Next Byte to be Decoded
+	const uint8_t *sectionEnd;                 // End of Current Section
+	uint64_t instruction;                      // Instruction of Last Record
+	uint64_t asid;                             // ASID of Last Record
+	bool corrupt;                              // Was a Record Corrupt?
+	bool complete;                             // Was the Trace Closed?
+
+	std::vector<TraceTarget> targets;          // { Target ID -> Target }
+	std::vector<TraceLabel> labels;            // { Label -> Owner }
+};
+
+#endif
@@ -1,35 +1,647 @@
 #include "dependency_tracker_def.h"
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <math.h>
 #include <sstream>
 #include <stdexcept>
+#include <string.h>
+#include <utility>
 
 #include <linux/net.h>
+#include <sys/mman.h>
 
-template<typename T>
-std::vector<T> getMemoryValues(CPUState *cpu, uint32_t addr, uint32_t size) {
-	std::vector<T> values;
+uint32_t addConfiguration(const std::string &name, 
+		const std::string &sourcesFile, const std::string &sinksFile,
+		bool discover) {
+	auto &configurations = dependency_tracker.configurations;
+	for (auto &configuration : configurations) {
+		if (configuration->name != name) continue;
+		
+		std::cerr << "dependency_tracker: duplicate configuration \"" << 
+			name << "\"." << std::endl;
+		return NO_INDEX;
+	}
+	if (configurations.size() >> (64 - FLOW_INSTRUCTION_BITS)) {
+		std::cerr << "dependency_tracker: too many configurations, \"" << 
+			name << "\" is ignored." << std::endl;
+		return NO_INDEX;
+	}
+	
+	std::unique_ptr<Configuration> configuration(new Configuration());
+	configuration->name = name;
+	configuration->index = configurations.size();
+	configuration->discover = discover;
+	dependency_tracker.discover |= discover;
+	
+	// Read the sources and sinks files of the configuration. Each source gets
+	// its own label, so the labels of the configurations never overlap.
+	for (auto &target : parseTargets(sourcesFile)) 
+		getTargetSource(*configuration, target, true);
+	for (auto &target : parseTargets(sinksFile))
+		configuration->sinks.add(target);
+	configuration->flows.resize(configuration->sources.size(), 
+		configuration->sinks.size());
+	
+	uint32_t index = configuration->index;
+	uint64_t numSources = configuration->sources.size();
+	uint64_t numSinks = configuration->sinks.size();
+	configurations.push_back(std::move(configuration));
+	
+	if (dependency_tracker.debug) {
+		logEvent(LogType::Configuration, "configuration", Target(), index, 
+			numSources, numSinks);
+	}
+	
+	return index;
+}
+
+void applyShadow(CPUState *cpu, const Target &target, const TargetIO &io) {
+	// The data read from a connected UNIX socket was written to its peer
+	LabelShadow *shadow = getShadow(
+		isStream(target) ? getChannelPeer(target) : target, false);
+	if (!shadow) return;
+	
+	// Slice the range which was read out of the shadow. Pipes are read at 
+	// their read offset, and the data read from them is consumed.
+	auto &spans = dependency_tracker.spans;
+	spans.clear();
+	// If the position of a file is unknown, nothing is reapplied, rather 
+	// than the labels of the wrong range.
+	if (isStream(target)) {
+		shadow->slice(shadow->getReadOffset(), io.length, {}, spans);
+		shadow->consume(io.length);
+	} else {
+		uint64_t offset = 0;
+		if (!getIOOffset(cpu, io, offset)) return;
+		shadow->slice(offset, io.length, {}, spans);
+	}
+	
+	// Label the part of the buffer covered by each span with its labels
+	auto &runs = dependency_tracker.runs;
+	uint64_t bytes = 0;
+	for (auto &span : spans) {
+		runs.clear();
+		runs.add(cpu, io.segments, io.count, span.start, span.end - span.start);
+		for (auto label : span.labels) bytes += labelBufferContents(runs, label);
+	}
+	
+	if (bytes > 0) logEvent(LogType::ShadowRead, io.event, target, bytes);
+}
+
+Target classifyPeer(const Target &listener, const SocketAddress &peer) {
+	Target target;
+	if (dependency_tracker.peers.find(listener, peer, target)) return target;
+	
+	// Unless some configuration discovers targets, peers which were never 
+	// interned cannot be sources nor sinks, so they are not interned here.
+	// A peer which is a source or sink itself takes precedence over the 
+	// listening target of the socket, which covers every other peer. The 
+	// fallback to the listening target is not cached, since the peer may 
+	// become a source or sink later on.
+	target = getTargetAddress(peer, dependency_tracker.discover);
+	if (listener && !(target && (isSource(target) || isSink(target))))
+		return listener;
+	
+	dependency_tracker.peers.insert(listener, peer, target);
+	return target;
+}
+
+bool closeReport() {
+	auto &report = dependency_tracker.reportLog;
+	
+	// Drain the queue, so that the totals are written after every event
+	report.stop();
+	
+	// Foreach configuration, write the totals of each of its sources and 
+	// sinks, which are all that is left of the replay if the events were 
+	// dropped.
+	for (auto &configuration : dependency_tracker.configurations) {
+		auto &sources = configuration->sources;
+		auto &sinks = configuration->sinks;
+		
+		for (uint32_t source = 0; source < sources.size(); ++source) {
+			reportEvent(ReportType::Source, nullptr, 
+				packTarget(sources.getTarget(source)), configuration->index, 
+				sources.getTotalBytes(source), sources.getLabeledBytes(source));
+		}
+		for (uint32_t sink = 0; sink < sinks.size(); ++sink) {
+			reportEvent(ReportType::Sink, nullptr, 
+				packTarget(sinks.getTarget(sink)), configuration->index, 
+				sinks.getTotalBytes(sink), sinks.getTotalTaintBytes(sink));
+		}
+	}
+	
+	// The summary comes last, so that a report which ends without one is 
+	// known to be cut short.
+	reportEvent(ReportType::Summary, nullptr, rr_get_guest_instr_count(), 
+		report.getWritten(), report.getDropped());
+	
+	auto &stream = dependency_tracker.reportStream;
+	bool written = stream.good();
+	stream.close();
+	return written && !stream.fail();
+}
+
+bool closeTrace() {
+	auto &labels = dependency_tracker.labels;
+	auto &configurations = dependency_tracker.configurations;
+	
+	// Resolve each label to its configuration and to the target of its source
+	std::vector<std::pair<uint32_t, Target>> owners;
+	owners.reserve(labels.size());
+	for (uint32_t label = 0; label < labels.size(); ++label) {
+		uint32_t configuration = labels.getConfiguration(label);
+		uint32_t source = labels.getSource(label);
+		owners.emplace_back(configuration, 
+			configurations[configuration]->sources.getTarget(source));
+	}
+	
+	auto &trace = dependency_tracker.trace;
+	bool written = trace.close(dependency_tracker.targets, owners);
+	dependency_tracker.traceRecords += trace.getRecords();
+	dependency_tracker.traceBytes += trace.getBytes();
+	return written;
+}
+
+template<typename Policy>
+void copyFileDescriptors(CPUState *cpu, int32_t inFd, uint32_t inOffsetPtr,
+		int32_t outFd, uint32_t outOffsetPtr, bool wideOffsets,
+		const char *event, bool consume) {
+	// The number of bytes copied is stored in the EAX register. Skip if 
+	// nothing was copied, or if the call failed.
+	uint32_t length = ((CPUArchState*)cpu->env_ptr)->regs[0];
+	if ((int32_t)length <= 0) return;
+	
+	// Resolve both file descriptors. Their names are interned even if they 
+	// are neither sources nor sinks, since the data may only be passing 
+	// through them.
+	target_ulong asid = panda_current_asid(cpu);
+	Target in = resolveTarget(cpu, asid, inFd, true);
+	Target out = resolveTarget(cpu, asid, outFd, true);
+	if (!in || !out) return;
+
+	// Log that a recognizable copy was seen
+	if (Policy::debug) logEvent(LogType::Copy, event, in, packTarget(out));
+	
+	// Skip the copy if the offset of either side is unknown, rather than
+	// moving the labels of the wrong range of a file.
+	uint64_t inOffset = 0, outOffset = 0;
+	if (!getCopyOffset(cpu, asid, inFd, in, inOffsetPtr, wideOffsets, length,
+			inOffset)) return;
+	if (!getCopyOffset(cpu, asid, outFd, out, outOffsetPtr, wideOffsets, 
+			length, outOffset)) return;
+	copyTargetContents(in, inOffset, out, outOffset, length, event, consume);
+}
+
+void copyTargetContents(const Target &in, uint64_t inOffset, 
+		const Target &out, uint64_t outOffset, uint32_t length, 
+		const char *event, bool consume) {
+	auto &labels = dependency_tracker.copyLabels;
+	auto &spans = dependency_tracker.spans;
+	
+	// Every byte copied from a source carries the label of the source, in 
+	// each configuration in which the input is a source.
+	labels.clear();
+	for (auto &configuration : dependency_tracker.configurations) {
+		uint32_t source = getTargetSource(*configuration, in);
+		if (source == NO_INDEX) continue;
+		auto &sources = configuration->sources;
+		
+		labels.push_back(sources.getLabel(source));
+		sources.getTotalBytes(source) += length;
+		sources.getTotalReads(source)++;
+		dependency_tracker.series.touchSource(configuration->index, source);
+	}
+	std::sort(labels.begin(), labels.end());
+	countChannel(in, length, false);
+	countChannel(out, length, true);
+	
+	// Slice the copied range out of the shadow of the input, if it has one. 
+	// Pipes are read at their read offset, and the data is consumed unless it
+	// is only being duplicated. The data read from a connected UNIX socket 
+	// was written to its peer.
+	spans.clear();
+	LabelShadow *inShadow = getShadow(isStream(in) ? getChannelPeer(in) : in, 
+		false);
+	if (inShadow) {
+		if (isStream(in)) inOffset = inShadow->getReadOffset();
+		inShadow->slice(inOffset, length, labels, spans);
+		if (isStream(in) && consume) inShadow->consume(length);
+	} else if (!labels.empty()) {
+		spans.push_back(ShadowSpan{ 0, length, labels });
+	}
+	
+	// Record the labels in the shadow of the output, unless the output is a
+	// network, in which case the data leaves the guest. The shadow of a file
+	// is only created once labeled data is copied into it.
+	if (out.kind != TargetKind::Network) {
+		LabelShadow *outShadow = getShadow(out, !spans.empty());
+		if (outShadow) {
+			if (isStream(out)) outOffset = outShadow->produce(length);
+			outShadow->write(outOffset, length, spans);
+		}
+	}
+	
+	// Credit the labels of the copied data to the output, in each 
+	// configuration in which it is a sink. The bytes of each label are 
+	// counted per span, rather than per byte.
+	if (!findSinks(out)) return;
+	
+	auto &histogram = dependency_tracker.histogram;
+	histogram.clear();
+	for (auto &span : spans) {
+		for (auto label : span.labels) 
+			histogram.add(label, span.end - span.start);
+	}
+	histogram.sort();
+	
+	creditSinks(length, histogram, event, false);
+}
+
+uint64_t creditSink(Configuration &configuration, uint32_t sink, 
+		uint32_t length, const LabelHistogram &histogram, const char *event,
+		bool vectored) {
+	auto &sinks = configuration.sinks;
+	auto &labels = dependency_tracker.labels;
+	
+	uint64_t totalTaintBytes = 0;
+	for (auto label : histogram.getLabels()) {
+		// Labels owned by other configurations, or which were applied by 
+		// someone else, are not credited to this configuration.
+		if (labels.getConfiguration(label) != configuration.index) continue;
+		uint32_t source = labels.getSource(label);
+		
+		// Add the flow from the source to this sink in the flow matrix
+		uint64_t numTainted = histogram.getCount(label);
+		configuration.flows.add(source, sink, numTainted);
+		totalTaintBytes += numTainted;
+		
+		logEvent(LogType::SinkWrite, event, sinks.getTarget(sink), numTainted,
+			length, label);
+		reportEvent(ReportType::Flow, event, packTarget(sinks.getTarget(sink)),
+			packTarget(configuration.sources.getTarget(source)), 
+			(static_cast<uint64_t>(configuration.index) << 
+			FLOW_INSTRUCTION_BITS) | rr_get_guest_instr_count(), numTainted);
+	}
+	
+	// Notify Target Sink of the write
+	sinks.getTotalBytes(sink) += length;
+	sinks.getTotalTaintBytes(sink) += totalTaintBytes;
+	sinks.getTotalWrites(sink)++;
+	if (vectored) sinks.getVectoredWrites(sink)++;
+	dependency_tracker.series.touchSink(configuration.index, sink);
+	
+	return totalTaintBytes;
+}
+
+template<typename Policy>
+Target decodeMessage(CPUState *cpu, uint32_t args, const char *event,
+		uint32_t &sockfd) {
+	// Get the socket file descriptor and the message header address from the
+	// arguments, and the message header itself.
+	GuestMsgHdr header;
+	if (!readGuestMessage(cpu, args, sockfd, header)) {
+		if (countError(ErrorCategory::UntranslatablePage)) {
+			std::cerr << "dependency_tracker: failed to read message " <<
+				"header (" << event << " socket)." << std::endl;
+		}
+		
+		return Target();
+	}
+	
+	// Find the peer from the socket, or from the address of the message
+	Target target = getTargetPeer(cpu, panda_current_asid(cpu), sockfd,
+		header.name, header.nameLength);
+	if (!target) return Target();
+
+	// Log that a recognizable target was seen
+	if (Policy::debug) logEvent(LogType::Seen, event, target);
+	
+	// Read the whole iovec array of the message in one access
+	auto &iovecs = dependency_tracker.iovecs;
+	if (!readGuestValues(cpu, header.iov, iovecs, header.iovLength)) {
+		if (countError(ErrorCategory::UntranslatablePage)) {
+			std::cerr << "dependency_tracker: failed to read " << 
+				header.iovLength << " iovecs (" << event << " socket)." << 
+				std::endl;
+		}
+		
+		return Target();
+	}
+	
+	return target;
+}
+
+void countChannel(const Target &target, uint32_t length, bool write) {
+	if (target.kind != TargetKind::Channel) return;
+	
+	auto &channels = dependency_tracker.channelTraffic;
+	uint32_t channel = channels.add(target);
+	if (write) {
+		channels.getBytesWritten(channel) += length;
+		channels.getWrites(channel)++;
+	} else {
+		channels.getBytesRead(channel) += length;
+		channels.getReads(channel)++;
+	}
+}
+
+bool countError(ErrorCategory category) {
+	// The error is counted first, so that the tally is complete even if 
+	// errors are not logged.
+	return dependency_tracker.errors.count(category) && 
+		dependency_tracker.logErrors;
+}
+
+void creditSinks(uint32_t length, const LabelHistogram &histogram,
+		const char *event, bool vectored) {
+	auto &configurations = dependency_tracker.configurations;
+	auto &sinks = dependency_tracker.foundSinks;
 	
-	// An array of raw memory bytes. Since we want to fetch T elements from
-	// memory and we need enough bytes to store a single instance of T, so the 
-	// array's size is equivalent to the size of a single T.
-	uint8_t raw[sizeof(T)];
+	for (size_t i = 0; i < configurations.size(); ++i) {
+		if (sinks[i] == NO_INDEX) continue;
+		
+		creditSink(*configurations[i], sinks[i], length, histogram, event, 
+			vectored);
+	}
+}
+
+bool exportFlowMatrix(const Configuration &configuration) {
+	auto &flows = configuration.flows;
+	auto &sources = configuration.sources;
+	auto &sinks = configuration.sinks;
+	
+	// When several configurations are evaluated, each one gets its own file
+	std::string file = dependency_tracker.matrixFile;
+	if (dependency_tracker.configurations.size() > 1) 
+		file += "." + configuration.name;
 	
-	for (auto i = 0; i < size; ++i) {
-		// For each value, read the bytes from memory and store them into
-		// the raw memory array. Cast the raw memory to T and store in the 
-		// values list.
-		panda_virtual_memory_rw(cpu, addr + i * sizeof(T), raw, sizeof(T), 0);
-		T value = *(reinterpret_cast<T*>(raw));
-		values.push_back(value);
+	bool exported = false;
+	auto &format = dependency_tracker.matrixFormat;
+	if (format == "bin") {
+		exported = flows.exportBinary(file);
+	} else if (format == "dot" || format == "adj") {
+		// Describe each source and sink, with its totals, as a node of the 
+		// graph.
+		std::vector<FlowNode> sourceNodes;
+		std::vector<FlowNode> sinkNodes;
+		for (uint32_t i = 0; i < sources.size(); ++i) {
+			const Target &target = sources.getTarget(i);
+			sourceNodes.push_back(FlowNode{ getTargetName(target), 
+				getKindCode(target.kind), sources.getTotalBytes(i), 
+				sources.getLabeledBytes(i) });
+		}
+		for (uint32_t i = 0; i < sinks.size(); ++i) {
+			const Target &target = sinks.getTarget(i);
+			sinkNodes.push_back(FlowNode{ getTargetName(target), 
+				getKindCode(target.kind), sinks.getTotalBytes(i), 
+				sinks.getTotalTaintBytes(i) });
+		}
+		
+		if (format == "dot") {
+			exported = flows.exportDOT(file, configuration.name, sourceNodes, 
+				sinkNodes);
+		} else {
+			exported = flows.exportAdjacency(file, sourceNodes, sinkNodes);
+		}
+	} else {
+		// Resolve the names of the sources and sinks for the CSV rows
+		std::vector<std::string> sourceNames;
+		std::vector<std::string> sinkNames;
+		for (uint32_t i = 0; i < sources.size(); ++i) 
+			sourceNames.push_back(getTargetName(sources.getTarget(i)));
+		for (uint32_t i = 0; i < sinks.size(); ++i) 
+			sinkNames.push_back(getTargetName(sinks.getTarget(i)));
+		
+		exported = flows.exportCSV(file, sourceNames, sinkNames);
 	}
 	
-	return values;
+	if (!exported) {
+		std::cerr << "dependency_tracker: failed to export flow matrix to \""
+			<< file << "\"." << std::endl;
+	}
+	
+	return exported;
 }
 
-TargetFile getTargetFile(CPUState *cpu, target_ulong asid, uint32_t fd) {
+bool findSinks(const Target &target) {
+	auto &configurations = dependency_tracker.configurations;
+	auto &sinks = dependency_tracker.foundSinks;
+	
+	bool isSink = false;
+	sinks.resize(configurations.size());
+	for (size_t i = 0; i < configurations.size(); ++i) {
+		sinks[i] = getTargetSink(*configurations[i], target);
+		isSink |= (sinks[i] != NO_INDEX);
+	}
+	
+	return isSink;
+}
+
+void formatLogRecord(const LogRecord &record, std::string &text) {
+	std::string name = getTargetName(unpackTarget(record.values[0]));
+	
+	text += "dependency_tracker: ";
+	switch (static_cast<LogType>(record.type)) {
+	case LogType::Seen:
+		text += "saw " + std::string(record.event) + " target \"" + name + 
+			"\".";
+		break;
+	case LogType::Copy:
+		text += "saw " + std::string(record.event) + " from target \"" + 
+			name + "\" to target \"" + 
+			getTargetName(unpackTarget(record.values[1])) + "\".";
+		break;
+	case LogType::SourceRead:
+		text += "***saw " + std::string(record.event) + " of source target: " +
+			"\"" + name + "\", tainted " + std::to_string(record.values[1]) + 
+			"/" + std::to_string(record.values[2]) + " bytes with label " + 
+			std::to_string(record.values[3]) + "***";
+		break;
+	case LogType::SinkWrite:
+		text += "***saw " + std::string(record.event) + " of sink target \"" +
+			name + "\", " + std::to_string(record.values[1]) + "/" + 
+			std::to_string(record.values[2]) + " bytes written to target " +
+			"with label " + std::to_string(record.values[3]) + "***";
+		break;
+	case LogType::ShadowRead:
+		text += "***saw " + std::string(record.event) + " of shadowed " + 
+			"target: \"" + name + "\", reapplied " + 
+			std::to_string(record.values[1]) + " labeled bytes***";
+		break;
+	case LogType::SourceMapping:
+		text += "***saw " + std::string(record.event) + " of source target: " +
+			"\"" + name + "\", labeled " + std::to_string(record.values[1]) + 
+			"/" + std::to_string(record.values[2]) + " pages***";
+		break;
+	case LogType::SourceConnection:
+		text += "***saw " + std::string(record.event) + " source target: \"" +
+			name + "\"***";
+		break;
+	case LogType::SinkConnection:
+		text += "***saw " + std::string(record.event) + " sink target: \"" +
+			name + "\"***";
+		break;
+	case LogType::Configuration:
+		text += "configuration \"" + 
+			dependency_tracker.configurations[record.values[1]]->name + 
+			"\" has " + std::to_string(record.values[2]) + " sources and " + 
+			std::to_string(record.values[3]) + " sinks.";
+		break;
+	case LogType::TaintEnabled:
+		text += "enabling taint at instruction " + 
+			std::to_string(record.values[1]) + ".";
+		break;
+	}
+	
+	text += '\n';
+}
+
+void formatReportRecord(const LogRecord &record, std::string &text) {
+	auto &encoder = dependency_tracker.reportEncoder;
+	auto &configurations = dependency_tracker.configurations;
+	
+	// The configuration is packed with the length of a read, and with the
+	// instruction of a flow, and stored on its own by the total records.
+	const uint64_t instructionMask = (1ull << FLOW_INSTRUCTION_BITS) - 1;
+	std::string target = getTargetName(unpackTarget(record.values[0]));
+	switch (static_cast<ReportType>(record.type)) {
+	case ReportType::Read:
+		encoder.begin("read");
+		encoder.set(ReportField::Event, record.event);
+		encoder.set(ReportField::Configuration, 
+			configurations[record.values[2] >> 32]->name);
+		encoder.set(ReportField::Instruction, record.values[1]);
+		encoder.set(ReportField::Target, target);
+		encoder.set(ReportField::Bytes, record.values[2] & UINT32_MAX);
+		encoder.set(ReportField::Tainted, record.values[3]);
+		break;
+	case ReportType::Flow:
+		encoder.begin("flow");
+		encoder.set(ReportField::Event, record.event);
+		encoder.set(ReportField::Configuration, configurations[
+			record.values[2] >> FLOW_INSTRUCTION_BITS]->name);
+		encoder.set(ReportField::Instruction, 
+			record.values[2] & instructionMask);
+		encoder.set(ReportField::Target, target);
+		encoder.set(ReportField::Source, 
+			getTargetName(unpackTarget(record.values[1])));
+		encoder.set(ReportField::Tainted, record.values[3]);
+		break;
+	case ReportType::Source:
+	case ReportType::Sink:
+		encoder.begin(static_cast<ReportType>(record.type) == 
+			ReportType::Source ? "source" : "sink");
+		encoder.set(ReportField::Configuration, 
+			configurations[record.values[1]]->name);
+		encoder.set(ReportField::Target, target);
+		encoder.set(ReportField::Bytes, record.values[2]);
+		encoder.set(ReportField::Tainted, record.values[3]);
+		break;
+	case ReportType::Summary:
+		encoder.begin("summary");
+		encoder.set(ReportField::Instruction, record.values[0]);
+		encoder.set(ReportField::Records, record.values[1]);
+		encoder.set(ReportField::Dropped, record.values[2]);
+		break;
+	}
+	
+	encoder.end(text);
+}
+
+Target getChannelPeer(const Target &target) {
+	auto &peers = dependency_tracker.channelPeers;
+	if (peers.empty()) return target;
+	
+	auto it = peers.find(target);
+	return (it != peers.end()) ? it->second : target;
+}
+
+bool getCopyOffset(CPUState *cpu, target_ulong asid, uint32_t fd, 
+		const Target &target, uint32_t offsetPtr, bool wide, 
+		uint32_t length, uint64_t &offset) {
+	// Only files have offsets. Pipes are streams, and networks are not 
+	// shadowed at all.
+	offset = 0;
+	if (target.kind != TargetKind::File) return true;
+	
+	// If an offset pointer was passed, the kernel advanced the offset it
+	// points to past the copied data. Otherwise, it advanced the position of
+	// the file, which OSI reports as -1 if it cannot be resolved.
+	uint64_t end = 0;
+	if (offsetPtr != 0) {
+		uint32_t narrow = 0;
+		if (wide) {
+			if (!readGuestValues(cpu, offsetPtr, &end, 1)) return false;
+		} else {
+			if (!readGuestValues(cpu, offsetPtr, &narrow, 1)) return false;
+			end = narrow;
+		}
+	} else {
+		if (dependency_tracker.processes.count(asid) == 0) return false;
+		
+		auto &process = dependency_tracker.processes[asid];
+		end = osi_linux_fd_to_pos(cpu, &process, fd);
+		if (end == (uint64_t)(-1)) return false;
+	}
+	
+	offset = (end >= length) ? end - length : 0;
+	return true;
+}
+
+bool getIOOffset(CPUState *cpu, const TargetIO &io, uint64_t &offset) {
+	offset = io.position;
+	if (io.position != CURRENT_POSITION) return true;
+	
+	// The call advanced the position of the file past the data moved. OSI 
+	// reports the position as -1 if it cannot be resolved.
+	offset = 0;
+	target_ulong asid = panda_current_asid(cpu);
+	if (dependency_tracker.processes.count(asid) == 0) return false;
+	
+	auto &process = dependency_tracker.processes[asid];
+	uint64_t end = osi_linux_fd_to_pos(cpu, &process, io.fd);
+	if (end == (uint64_t)(-1)) return false;
+	
+	offset = (end >= io.length) ? end - io.length : 0;
+	return true;
+}
+
+const char* getKindCode(TargetKind kind) {
+	switch (kind) {
+	case TargetKind::Network:
+		return "n";
+	case TargetKind::Channel:
+		return "c";
+	default:
+		return "f";
+	}
+}
+
+LabelShadow* getShadow(const Target &target, bool create) {
+	auto &shadows = dependency_tracker.shadows;
+	if (isStream(target)) return &shadows[target];
+	
+	auto it = shadows.find(target);
+	if (it != shadows.end()) return &it->second;
+	if (!create) return nullptr;
+	
+	return &shadows.emplace(target, LabelShadow()).first->second;
+}
+
+Target getTargetAddress(const SocketAddress &address, bool intern) {
+	char ip[INET6_ADDRSTRLEN] = {0};
+	if (!formatSocketAddress(address, ip)) return Target();
+	
+	auto &targets = dependency_tracker.targets;
+	if (intern) return targets.internNetwork(ip, address.port);
+	return targets.findNetwork(ip, address.port);
+}
+
+Target getTargetFile(CPUState *cpu, target_ulong asid, uint32_t fd,
+		bool intern) {
 	if (dependency_tracker.processes.count(asid) > 0) {
 		auto &process = dependency_tracker.processes[asid];
 
@@ -37,101 +649,509 @@ TargetFile getTargetFile(CPUState *cpu, target_ulong asid, uint32_t fd) {
 		// continue with execution.
 		char *fileNamePtr = osi_linux_fd_to_filename(cpu, &process, fd);
 		if (!fileNamePtr) {
-			if (dependency_tracker.logErrors) {
+			if (countError(ErrorCategory::OSIFailure)) {
 				std::cerr << "dependency_tracker: osi_linux_fd_to_filename " <<
 					"failed" << " for fd " << fd << ", unable to get file " <<
 					"name." << std::endl;
 			}
 
-			return TargetFile();
+			return Target();
 		}
+		
+		// The name is allocated by osi_linux, so copy it and free it
+		std::string fileName(fileNamePtr);
+		g_free(fileNamePtr);
 
-		// If file name pointer is not null, the function worked, return file
-		// name as a string.
-		return TargetFile(std::string(fileNamePtr));
+		// Pipes and sockets have no path, the kernel names them after their
+		// inode instead. Pipes are always interned, so that their traffic is
+		// counted. Sockets are only channels if they were interned as UNIX 
+		// sockets when they were created, see internUnixSocket(). Internet 
+		// sockets are networks once they are connected, and unknown before.
+		auto &targets = dependency_tracker.targets;
+		const char *name = fileName.c_str();
+		size_t length = fileName.size();
+		if (fileName.compare(0, 5, "pipe:") == 0) 
+			return targets.intern(TargetKind::Channel, name, length);
+		if (fileName.compare(0, 7, "socket:") == 0) 
+			return targets.find(TargetKind::Channel, name, length);
+		
+		// If file name pointer is not null, the function worked. Look up the
+		// interned file target. Unless some configuration discovers targets,
+		// files which were never interned cannot be sources nor sinks, so 
+		// they are not interned here, unless requested.
+		if (dependency_tracker.discover || intern) {
+			return targets.intern(TargetKind::File, name, length);
+		}
+		
+		return targets.find(TargetKind::File, name, length);
 	}
 
 	// If this is reached, then ASID is unknown
-	if (dependency_tracker.logErrors) {
+	if (countError(ErrorCategory::UnknownASID)) {
 		std::cerr << "dependency_tracker: osi_linux_fd_to_filename failed " <<
 			" for fd " << fd << ", because ASID " << asid << " is unknown." <<
 			std::endl;
 	}
-	return TargetFile();
+	return Target();
+}
+
+Target getTargetListener(target_ulong asid, uint32_t fd) {
+	auto &listeners = dependency_tracker.listeners;
+	if (listeners.empty()) return Target();
+	
+	Target *listener = listeners.find(asid, fd);
+	return listener ? *listener : Target();
+}
+
+std::string getTargetName(const Target &target) {
+	return dependency_tracker.targets.getName(target);
+}
+
+Target getTargetPeer(CPUState *cpu, target_ulong asid, uint32_t fd,
+		uint32_t addr, uint32_t length) {
+	// Connected and accepted sockets are known by their file descriptor
+	Target *network = dependency_tracker.networks.find(asid, fd);
+	if (network) return *network;
+	
+	// Otherwise, the peer is taken from the address passed to the call, if 
+	// there is one, or else the socket may be listening.
+	if (addr != 0) return getTargetSockaddr(cpu, asid, fd, addr, length);
+	return getTargetListener(asid, fd);
 }
 
-TargetNetwork getTargetNetwork(target_ulong asid, uint32_t fd) {
-	try {
-		return dependency_tracker.networks.at(std::make_pair(asid, fd));
-	} catch (const std::out_of_range &e) {
-		if (dependency_tracker.logErrors) {		
+Target getTargetNetwork(target_ulong asid, uint32_t fd) {
+	Target *network = dependency_tracker.networks.find(asid, fd);
+	if (!network) {
+		// Sockets which are only bound receive from anything arriving on the
+		// bound port, so fall back to their listening target.
+		Target listener = getTargetListener(asid, fd);
+		if (listener) return listener;
+		
+		if (countError(ErrorCategory::UnknownFD)) {
 			std::cerr << "dependency_tracker: failed to fetch network for fd " 
 				<< fd << " and ASID " << asid << "." << std::endl;
 		}
 
-		return TargetNetwork();
+		return Target();
 	}
+	
+	return *network;
 }
 
-TargetSink& getTargetSink(const Target &target) {
-	for (const auto &sink : dependency_tracker.sinks) {
-		if (sink->getTarget() == target) {
-			return *sink;
-		}
-	}
+Target getTargetSockaddr(CPUState *cpu, target_ulong asid, uint32_t fd,
+		uint32_t addr, uint32_t length) {
+	SocketAddress peer;
+	if (!readSocketAddress(cpu, addr, length, peer)) return Target();
 	
-	throw std::invalid_argument("no sink exists for specified target");
+	return classifyPeer(getTargetListener(asid, fd), peer);
 }
 
-TargetSource& getTargetSource(const Target &target) {
-	for (const auto &source : dependency_tracker.sources) {
-		if (source->getTarget() == target) {
-			return *source;
-		}
+uint32_t getTargetSink(Configuration &configuration, const Target &target) {
+	// When discovering targets, every target written to becomes a sink the
+	// first time it is seen.
+	if (configuration.discover && target) {
+		return configuration.sinks.add(target);
 	}
 	
-	throw std::invalid_argument("no source exists for specified target");
+	return configuration.sinks.find(target);
+}
+
+uint32_t getTargetSource(Configuration &configuration, const Target &target,
+		bool add) {
+	auto &sources = configuration.sources;
+	
+	uint32_t source = sources.find(target);
+	if (source != NO_INDEX || !target) return source;
+	if (!add && !configuration.discover) return NO_INDEX;
+	
+	// The target is not a source yet, so allocate the next free label to it.
+	// When discovering targets, this happens the first time it is read from,
+	// so labels are allocated on demand.
+	uint32_t label = dependency_tracker.labels.allocate(configuration.index,
+		sources.size());
+	return sources.add(target, label);
+}
+
+Target internUnixSocket(CPUState *cpu, target_ulong asid, uint32_t fd) {
+	if (dependency_tracker.processes.count(asid) == 0) return Target();
+	auto &process = dependency_tracker.processes[asid];
+	
+	// UNIX sockets have no path, the kernel names them after their inode. The
+	// name is allocated by osi_linux, so copy it and free it.
+	char *fileNamePtr = osi_linux_fd_to_filename(cpu, &process, fd);
+	if (!fileNamePtr) return Target();
+	
+	std::string fileName(fileNamePtr);
+	g_free(fileNamePtr);
+	if (fileName.compare(0, 7, "socket:") != 0) return Target();
+	
+	Target target = dependency_tracker.targets.intern(TargetKind::Channel, 
+		fileName.c_str(), fileName.size());
+	dependency_tracker.channels.insert(asid, fd, target);
+	return target;
+}
+
+void invalidateProcess(target_ulong asid) {
+	dependency_tracker.networks.invalidate(asid);
+	dependency_tracker.listeners.invalidate(asid);
+	dependency_tracker.channels.invalidate(asid);
+	dependency_tracker.mappings.erase(asid);
+}
+
+bool isStream(const Target &target) {
+	return target.kind == TargetKind::Channel;
 }
 
 bool isSink(const Target &target) {
-	try {
-		getTargetSink(target);
-		return true;
-	} catch (const std::invalid_argument &e) {
-		return false;
+	for (auto &configuration : dependency_tracker.configurations) {
+		if (configuration->sinks.find(target) != NO_INDEX) return true;
 	}
+	
+	return false;
 }
 
 bool isSource(const Target &target) {
-	try {
-		getTargetSource(target);
-		return true;
-	} catch (const std::invalid_argument &e) {
-		return false;
+	for (auto &configuration : dependency_tracker.configurations) {
+		if (configuration->sources.find(target) != NO_INDEX) return true;
 	}
+	
+	return false;
 }
 
-int labelBufferContents(CPUState *cpu, target_ulong vAddr, uint32_t length,
-		uint32_t label) {
+int labelBufferContents(const PageRuns &runs, uint32_t label) {
 	if (!taint2_enabled()) return 0;
-	int bytesTainted = 0;               // Total number of bytes tainted
 	
-	for (auto i = 0; i < length; ++i) {
-		// Convert the virtual address to a physical, assert it is valid, if
-		// not skip this byte.
-		hwaddr pAddr = panda_virt_to_phys(cpu, vAddr + i);
-		if (pAddr == (hwaddr)(-1)) continue;
+	// Taint each byte of each run. The runs only cover mapped bytes, so no
+	// address has to be translated here.
+	for (auto &run : runs.getRuns()) {
+		for (uint32_t i = 0; i < run.length; ++i) 
+			taint2_label_ram_additive(run.pAddr + i, label);
+	}
+	
+	return runs.getMappedBytes();
+}
+
+void labelSources(CPUState *cpu, const Target &target, const TargetIO &io) {
+	auto &runs = dependency_tracker.runs;
+	bool translated = false;
+	countChannel(target, io.length, false);
+	
+	for (auto &configuration : dependency_tracker.configurations) {
+		// Get the index of the source associated with the target in this
+		// configuration, skip the configuration if there is none.
+		uint32_t source = getTargetSource(*configuration, target);
+		if (source == NO_INDEX) continue;
+		auto &sources = configuration->sources;
+		
+		// Translate the buffer the first time it has to be labeled, and
+		// reuse the runs for every other configuration.
+		if (!translated) {
+			runs.clear();
+			runs.add(cpu, io.segments, io.count, io.length);
+			translated = true;
+		}
 		
-		// Else, taint at the physical address specified
-		taint2_label_ram_additive(pAddr, label);
-		++bytesTainted;
+		// Label the buffer contents, add number of tainted bytes to the 
+		// target source.
+		uint32_t label = sources.getLabel(source);
+		uint32_t bytes = labelBufferContents(runs, label);
+		sources.getLabeledBytes(source) += bytes;
+		
+		// Notify Target Source of the read
+		sources.getTotalBytes(source) += io.length;
+		sources.getTotalReads(source)++;
+		if (io.vectored) sources.getVectoredReads(source)++;
+		dependency_tracker.series.touchSource(configuration->index, source);
+		
+		// Output that the target source was seen and tainted, if applicable
+		logEvent(LogType::SourceRead, io.event, target, bytes, io.length, 
+			label);
+		reportEvent(ReportType::Read, io.event, packTarget(target), 
+			rr_get_guest_instr_count(), 
+			(static_cast<uint64_t>(configuration->index) << 32) | io.length,
+			bytes);
+		if (dependency_tracker.trace.isOpen()) {
+			dependency_tracker.trace.addSource(rr_get_guest_instr_count(), 
+				panda_current_asid(cpu), io.fd, target, io.length, bytes, 
+				label);
+			rotateTrace();
+		}
+	}
+	
+	// Reapply the labels which the shadow of the target holds for the data
+	// read, if the target is shadowed.
+	applyShadow(cpu, target, io);
+}
+
+uint32_t labelMapping(CPUState *cpu, SourceMapping &mapping, 
+		uint32_t budget) {
+	return mapping.visit(budget, [&](target_ulong vAddr, uint32_t length) {
+		return labelMappingPage(cpu, mapping, vAddr, length);
+	});
+}
+
+bool labelMappingPage(CPUState *cpu, const SourceMapping &mapping, 
+		target_ulong vAddr, uint32_t length) {
+	auto &runs = dependency_tracker.runs;
+	auto &configurations = dependency_tracker.configurations;
+	auto &labels = dependency_tracker.labels;
+	
+	// The page can only be labeled once it is resident, and once taint2 is
+	// enabled.
+	if (!taint2_enabled()) return false;
+	
+	runs.clear();
+	runs.add(cpu, vAddr, length);
+	if (runs.getMappedBytes() < length) return false;
+	
+	// Label the page with the label of each source which was mapped
+	for (auto label : mapping.getLabels()) {
+		uint32_t bytes = labelBufferContents(runs, label);
+		
+		uint32_t index = labels.getConfiguration(label);
+		uint32_t source = labels.getSource(label);
+		configurations[index]->sources.getMappedBytes(source) += bytes;
+		dependency_tracker.series.touchSource(index, source);
+	}
+	
+	return true;
+}
+
+void labelMappingRange(CPUState *cpu, target_ulong asid, target_ulong start,
+		uint32_t length) {
+	auto it = dependency_tracker.mappings.find(asid);
+	if (it == dependency_tracker.mappings.end()) return;
+	auto &mappings = it->second;
+	
+	for (size_t i = 0; i < mappings.size(); ) {
+		auto &mapping = mappings[i];
+		mapping.visitRange(start, length, 
+			[&](target_ulong vAddr, uint32_t pageLength) {
+				return labelMappingPage(cpu, mapping, vAddr, pageLength);
+			});
+		
+		if (mapping.getRemainingPages() == 0) {
+			mappings.erase(mappings.begin() + i);
+		} else {
+			++i;
+		}
+	}
+	
+	if (mappings.empty()) dependency_tracker.mappings.erase(it);
+}
+
+void labelMappings(CPUState *cpu, target_ulong asid) {
+	auto it = dependency_tracker.mappings.find(asid);
+	if (it == dependency_tracker.mappings.end()) return;
+	auto &mappings = it->second;
+	
+	// Visit the pages of the mappings until the budget is spent, and forget
+	// the mappings whose pages were all labeled.
+	uint32_t budget = dependency_tracker.mappingBudget;
+	for (size_t i = 0; i < mappings.size() && budget > 0; ) {
+		uint32_t visited = std::min(budget, mappings[i].getRemainingPages());
+		labelMapping(cpu, mappings[i], visited);
+		budget -= visited;
+		
+		if (mappings[i].getRemainingPages() == 0) {
+			mappings.erase(mappings.begin() + i);
+		} else {
+			++i;
+		}
 	}
 	
-	return bytesTainted;
+	if (mappings.empty()) dependency_tracker.mappings.erase(it);
+}
+
+uint64_t loadShadowStore(const std::string &file) {
+	auto &configurations = dependency_tracker.configurations;
+	auto &targets = dependency_tracker.targets;
+	
+	// Each line holds one label of a range: the file, the start and end of 
+	// the range, the configuration and the kind and name of the source. The 
+	// labels of a range are on consecutive lines.
+	Target pending;
+	uint64_t pendingStart = 0;
+	uint64_t pendingEnd = 0;
+	std::vector<uint32_t> labels;
+	uint64_t ranges = 0;
+	
+	auto flush = [&]() {
+		if (!pending || labels.empty()) return;
+		
+		std::sort(labels.begin(), labels.end());
+		labels.erase(std::unique(labels.begin(), labels.end()), labels.end());
+		dependency_tracker.shadows[pending].write(pendingStart, 
+			pendingEnd - pendingStart, 
+			{ ShadowSpan{ 0, pendingEnd - pendingStart, labels } });
+		labels.clear();
+		++ranges;
+	};
+	
+	unsigned int lineNumber = 0;
+	for (auto &line : parseCSV(file)) {
+		++lineNumber;
+		
+		uint64_t start = 0;
+		uint64_t end = 0;
+		try {
+			if (line.size() != 6) throw std::invalid_argument("line");
+			start = std::stoull(line[1]);
+			end = std::stoull(line[2]);
+		} catch (const std::exception &e) {
+			std::cerr << "dependency_tracker: unknown shadow range on line " 
+				<< lineNumber << "." << std::endl;
+			continue;
+		}
+		
+		// Find the configuration which the label belongs to. Labels of 
+		// configurations which are not evaluated in this replay are dropped.
+		auto configuration = std::find_if(configurations.begin(), 
+			configurations.end(), [&](const std::unique_ptr<Configuration> &c) {
+				return c->name == line[3];
+			});
+		if (configuration == configurations.end() || end <= start) continue;
+		
+		// Start a new range, unless this line adds a label to the last one
+		Target target = targets.intern(TargetKind::File, line[0]);
+		if (target != pending || start != pendingStart || end != pendingEnd) {
+			flush();
+			pending = target;
+			pendingStart = start;
+			pendingEnd = end;
+		}
+		
+		// Resolve the source, making it a source of the configuration if it
+		// is not one already, and take its label in this replay.
+		Target source = targets.intern(parseKindCode(line[4]), line[5]);
+		uint32_t index = getTargetSource(**configuration, source, true);
+		labels.push_back((*configuration)->sources.getLabel(index));
+	}
+	
+	flush();
+	return ranges;
+}
+
+void logEvent(LogType type, const char *event, const Target &target,
+		uint64_t first, uint64_t second, uint64_t third) {
+	LogRecord record;
+	record.type = static_cast<uint16_t>(type);
+	record.event = event;
+	record.values[0] = packTarget(target);
+	record.values[1] = first;
+	record.values[2] = second;
+	record.values[3] = third;
+	
+	// Only the records of the targets seen and of the copies, which are only
+	// logged in debug mode, may be dropped if the logging thread falls 
+	// behind. The replay waits for room for every other record, since they
+	// are the results of the replay.
+	bool wait = (type != LogType::Seen && type != LogType::Copy);
+	dependency_tracker.eventLog.push(record, wait);
+}
+
+void mapSource(CPUState *cpu, uint32_t fd, uint32_t flags, uint32_t length) {
+	// The mapped address is stored in the EAX register, unless the call 
+	// failed, in which case it holds a negative error number.
+	target_ulong start = ((CPUArchState*)cpu->env_ptr)->regs[0];
+	if (start >= (target_ulong)(-4096) || length == 0) return;
+	
+	// The new mapping replaces whatever was mapped in its range before
+	target_ulong asid = panda_current_asid(cpu);
+	unmapSources(asid, start, length);
+	
+	// Anonymous mappings are not backed by any target
+	if (flags & MAP_ANONYMOUS) return;
+	
+	Target target = resolveTarget(cpu, asid, fd);
+	if (!target) return;
+	
+	// Collect the label of the target in each configuration in which it is a
+	// source, skip the mapping if there are none.
+	std::vector<uint32_t> labels;
+	for (auto &configuration : dependency_tracker.configurations) {
+		uint32_t source = getTargetSource(*configuration, target);
+		if (source == NO_INDEX) continue;
+		
+		labels.push_back(configuration->sources.getLabel(source));
+	}
+	if (labels.empty()) return;
+	
+	// Label the pages which are already resident right away. The other pages
+	// are labeled once they are found resident, see labelMappings().
+	SourceMapping mapping(start, length, labels);
+	uint32_t pages = mapping.getRemainingPages();
+	uint32_t labeled = labelMapping(cpu, mapping, pages);
+	
+	logEvent(LogType::SourceMapping, "mmap", target, labeled, pages);
+	
+	if (mapping.getRemainingPages() > 0) 
+		dependency_tracker.mappings[asid].push_back(std::move(mapping));
+}
+
+void matchPeer(const std::string &path, const Target &target, bool accepted) {
+	auto &pendingPeers = dependency_tracker.pendingPeers;
+	auto &pending = pendingPeers[path];
+	auto &waiting = accepted ? pending.accepted : pending.connected;
+	auto &others = accepted ? pending.connected : pending.accepted;
+	
+	// Pair the end with the oldest end of the other side, or wait for one. 
+	// The kernel queues no more than SOMAXCONN connections per listening 
+	// socket, so older ends which were never matched are forgotten.
+	if (!others.empty()) {
+		pairChannels(others.front(), target);
+		others.pop_front();
+	} else {
+		waiting.push_back(target);
+		if (waiting.size() > SOMAXCONN) waiting.pop_front();
+	}
+	
+	if (pending.connected.empty() && pending.accepted.empty()) 
+		pendingPeers.erase(path);
 }
 
 int on_before_block_execution(CPUState *cpu, TranslationBlock *tB) {
-	// Do nothing if PANDA is not in Kernel Mode
+	// Publish how far the replay got, for the readers of the stats file, and
+	// append the changes of the counters to the interval series once an 
+	// interval has ended.
+	auto &stats = dependency_tracker.stats;
+	auto &series = dependency_tracker.series;
+	auto &configurations = dependency_tracker.configurations;
+	if (stats.isOpen() || series.isOpen()) {
+		uint64_t instruction = rr_get_guest_instr_count();
+		if (stats.isOpen()) stats.setInstruction(instruction);
+		if (series.isDue(instruction) && 
+				!series.snapshot(instruction, configurations)) {
+			std::cerr << "dependency_tracker: failed to write interval " <<
+				"series \"" << dependency_tracker.seriesFile << "\"." << 
+				std::endl;
+		}
+	}
+	
+	// Label the pages of the source mappings of the current process. This is
+	// only done in user mode, since the kernel only touches mapped pages on 
+	// behalf of system calls, whose buffers are labeled when they are 
+	// queried. The page of a new page fault, whose faulting instruction is 
+	// about to be retried, is labeled before it is read. The other pages 
+	// which have become resident are only checked once in a while, so that a
+	// large mapping which is only partly touched does not slow every block.
+	if (!dependency_tracker.mappings.empty() && !panda_in_kernel(cpu)) {
+		target_ulong asid = panda_current_asid(cpu);
+		target_ulong faultAddress = ((CPUArchState*)cpu->env_ptr)->cr[2];
+		if (faultAddress != dependency_tracker.lastFault) {
+			dependency_tracker.lastFault = faultAddress;
+			labelMappingRange(cpu, asid, faultAddress, 1);
+		}
+		
+		uint64_t instruction = rr_get_guest_instr_count();
+		if (instruction >= dependency_tracker.nextMappingCheck) {
+			dependency_tracker.nextMappingCheck = instruction + 
+				dependency_tracker.mappingInterval;
+			labelMappings(cpu, asid);
+		}
+	}
+	
+	// Do nothing else if PANDA is not in Kernel Mode
 	if (!panda_in_kernel(cpu)) return 0;
 	
 	// Get the current process using OSI and add it to the processes map
@@ -144,15 +1164,14 @@ int on_before_block_execution(CPUState *cpu, TranslationBlock *tB) {
 	return 1;
 }
 
+template<typename Policy>
 int on_before_block_translate(CPUState *cpu, target_ulong pc) {
 	// Enable taint if current instruction is g.t. when we are supposed to
 	// enable taint.
 	int instr = rr_get_guest_instr_count();
 	if (!taint2_enabled() && instr > dependency_tracker.enableTaintAt) {
-		if (dependency_tracker.debug) {
-			std::cout << "dependency_tracker: enabling taint at instruction " 
-				<< instr << "." << std::endl;
-		}
+		if (Policy::debug) 
+			logEvent(LogType::TaintEnabled, "taint", Target(), instr);
 		
 		taint2_enable_taint();
 	}
@@ -160,195 +1179,429 @@ int on_before_block_translate(CPUState *cpu, target_ulong pc) {
 	return 0;
 }
 
+void on_close_return(CPUState *cpu, target_ulong pc, uint32_t fd) {
+	if ((int32_t)((CPUArchState*)cpu->env_ptr)->regs[0] < 0) return;
+	
+	target_ulong asid = panda_current_asid(cpu);
+	dependency_tracker.networks.erase(asid, fd);
+	dependency_tracker.listeners.erase(asid, fd);
+	dependency_tracker.channels.erase(asid, fd);
+}
+
+template<typename Policy>
+void on_copy_file_range_return(CPUState *cpu, target_ulong pc, int32_t fd_in,
+		uint32_t off_in, int32_t fd_out, uint32_t off_out, uint32_t len,
+		uint32_t flags) {
+	copyFileDescriptors<Policy>(cpu, fd_in, off_in, fd_out, off_out, true, 
+		"copy_file_range", true);
+}
+
+void on_execve_enter(CPUState *cpu, target_ulong pc, uint32_t filename,
+		uint32_t argv, uint32_t envp) {
+	// The ASID is no longer current once the new program is loaded, so it is
+	// remembered by the PID, which the new program keeps.
+	OsiProc *process = get_current_process(cpu);
+	if (!process) return;
+	
+	dependency_tracker.execs[process->pid] = panda_current_asid(cpu);
+	free_osiproc(process);
+}
+
+void on_execve_return(CPUState *cpu, target_ulong pc, uint32_t filename,
+		uint32_t argv, uint32_t envp) {
+	OsiProc *process = get_current_process(cpu);
+	if (!process) return;
+	
+	auto &execs = dependency_tracker.execs;
+	auto it = execs.find(process->pid);
+	free_osiproc(process);
+	if (it == execs.end()) return;
+	
+	// The file descriptors of the old program are all forgotten, including
+	// those without the close on exec flag, which the new program keeps.
+	target_ulong asid = it->second;
+	execs.erase(it);
+	if (((CPUArchState*)cpu->env_ptr)->regs[0] == 0) invalidateProcess(asid);
+}
+
+void on_exit_group_enter(CPUState *cpu, target_ulong pc, int32_t error_code) {
+	// The exit system call is not hooked, since it only ends the calling 
+	// thread, and the other threads of the process share its file 
+	// descriptors. The C library ends processes with exit_group.
+	invalidateProcess(panda_current_asid(cpu));
+}
+
+void on_mmap_pgoff_return(CPUState *cpu, target_ulong pc, uint32_t addr,
+		uint32_t len, uint32_t prot, uint32_t flags, uint32_t fd, 
+		uint32_t pgoff) {
+	mapSource(cpu, fd, flags, len);
+}
+
+void on_mremap_return(CPUState *cpu, target_ulong pc, uint32_t addr,
+		uint32_t old_len, uint32_t new_len, uint32_t flags, uint32_t new_addr) {
+	// The new address is stored in the EAX register, unless the call failed,
+	// in which case it holds a negative error number and nothing moved.
+	target_ulong start = ((CPUArchState*)cpu->env_ptr)->regs[0];
+	if (start >= (target_ulong)(-4096)) return;
+	
+	// The pages of the old range may have moved, and the new range replaces
+	// whatever was mapped there before.
+	target_ulong asid = panda_current_asid(cpu);
+	unmapSources(asid, addr, old_len);
+	unmapSources(asid, start, new_len);
+}
+
+void on_munmap_return(CPUState *cpu, target_ulong pc, uint32_t addr, 
+		uint32_t len) {
+	if (((CPUArchState*)cpu->env_ptr)->regs[0] != 0) return;
+	
+	unmapSources(panda_current_asid(cpu), addr, len);
+}
+
+void on_old_mmap_return(CPUState *cpu, target_ulong pc, uint32_t arg) {
+	// The old mmap call passes its arguments in a structure: the address, 
+	// length, protection, flags, file descriptor and offset.
+	uint32_t arguments[6];
+	if (!readGuestValues(cpu, arg, arguments, 6)) return;
+	
+	mapSource(cpu, arguments[4], arguments[3], arguments[1]);
+}
+
+template<typename Policy>
 void on_pread64_return(CPUState *cpu, target_ulong pc, uint32_t fd,
 		uint32_t buffer, uint32_t count, uint64_t pos) {
 	// For pread64 events, we assume that the target being read is a file or a
-	// network, so try finding the TargetFile/TargetNetwork associated with the
-	// file descriptor argument.
-	TargetFile tF = getTargetFile(cpu, panda_current_asid(cpu), fd);
-	TargetNetwork tN = getTargetNetwork(panda_current_asid(cpu), fd);
-	
-	// For each target type, if it is valid, set the target pointer to it. If
-	// no target returned is valid, return because we don't know what this file
-	// descriptor corresponds to.
-	Target *target = nullptr;
-	if (tF)      target = &tF;
-	else if (tN) target = &tN;
-	else         return;
+	// network, so try resolving the file descriptor to either. If neither is
+	// valid, return because we don't know what this file descriptor 
+	// corresponds to.
+	Target target = resolveTarget(cpu, panda_current_asid(cpu), fd);
+	if (!target) return;
 
 	// Log that a recognizable target was seen
-	if (dependency_tracker.debug) {
-		std::cout << "dependency_tracker: saw read of target \"" << *target << 
-			"\"." << std::endl;
-	}
-
-	// Get the pointer to the target source associated with the fetched target
-	TargetSource *targetSource = nullptr;
-	try {
-		targetSource = &getTargetSource(*target);
-	} catch (const std::invalid_argument &e) {
-		return;
-	}
+	if (Policy::debug) logEvent(LogType::Seen, "read of", target);
 
-	// Get the true buffer length. For files, this is stored in the the EAX
-	// register, but for networks the buffer count provided is accurate.
-	uint32_t actualCount = count;
-	if (tF) 
-		actualCount = ((CPUArchState*)cpu->env_ptr)->regs[0];
-		
-	// Skip if nothing is actually being read from the file
-	if (actualCount <= 0) return;
-	
-	// Label the buffer contents, add number of tainted bytes to the target
-	// source.
-	uint32_t bytes = labelBufferContents(cpu, buffer, actualCount, 
-		targetSource->getIndex());
-	targetSource->getLabeledBytes() += bytes;
+	// Get the true buffer length, which is stored in the EAX register for 
+	// every kind of target, since the read may be shorter than the count 
+	// requested, in particular from a pipe or a socket.
+	uint32_t actualCount = ((CPUArchState*)cpu->env_ptr)->regs[0];
 	
-	// Notify Target Source of the read
-	targetSource->getTotalBytes() += actualCount;
-	targetSource->getTotalReads()++;
+	// Skip if nothing is actually being read from the file, or if the read
+	// failed, in which case EAX holds a negative error number.
+	if ((int32_t)actualCount <= 0) return;
 	
-	// Output that the target source was seen and tainted, if applicable
-	std::cout << "dependency_tracker: ***saw read of source target: \"" <<
-		*target << "\", tainted " << bytes << "/" << actualCount <<
-		" bytes with label " << targetSource->getIndex() << "***" << std::endl;
+	// Label the buffer contents for each configuration in which the target is
+	// a source.
+	GuestIOVec segment = { buffer, actualCount };
+	TargetIO io = { fd, pos, &segment, 1, actualCount, "read", false };
+	labelSources(cpu, target, io);
 }
 
+template<typename Policy>
 void on_pwrite64_return(CPUState *cpu, target_ulong pc, uint32_t fd,
 		uint32_t buffer, uint32_t count, uint64_t pos) {
 	// For pwrite64 events, we assume that the target being read is a file or a
-	// network, so try finding the TargetFile/TargetNetwork associated with the
-	// file descriptor argument.
-	TargetFile tF = getTargetFile(cpu, panda_current_asid(cpu), fd);
-	TargetNetwork tN = getTargetNetwork(panda_current_asid(cpu), fd);
-	
-	// For each target type, if it is valid, set the target pointer to it. If
-	// no target returned is valid, return because we don't know what this file
-	// descriptor corresponds to.
-	Target *target = nullptr;
-	if (tF)      target = &tF;
-	else if (tN) target = &tN;
-	else         return;
+	// network, so try resolving the file descriptor to either. If neither is
+	// valid, return because we don't know what this file descriptor 
+	// corresponds to. If all file writes are shadowed or traced, every file
+	// is resolved.
+	Target target = resolveTarget(cpu, panda_current_asid(cpu), fd,
+		dependency_tracker.shadowWrites || dependency_tracker.traceWrites);
+	if (!target) return;
 
 	// Log that a recognizable target was seen
-	if (dependency_tracker.debug) {
-		std::cout << "dependency_tracker: saw write of target \"" << *target << 
-			"\"." << std::endl;
-	}
+	if (Policy::debug) logEvent(LogType::Seen, "write of", target);
+	
+	// The number of bytes written is stored in the EAX register, and may be
+	// less than the count requested. Skip if nothing was written, or if the
+	// write failed.
+	uint32_t actualCount = ((CPUArchState*)cpu->env_ptr)->regs[0];
+	if ((int32_t)actualCount <= 0) return;
 	
-	// Get the pointer to the target sink associated with the fetched target
-	TargetSink *targetSink = nullptr;
-	try {
-		targetSink = &getTargetSink(*target);
-	} catch (const std::invalid_argument &e) {
+	// Query the buffer contents and credit the sources found in it to the
+	// sink, in each configuration in which the target is a sink.
+	GuestIOVec segment = { buffer, actualCount };
+	TargetIO io = { fd, pos, &segment, 1, actualCount, "write", false };
+	querySinks(cpu, target, io);
+}
+
+template<typename Policy>
+void on_preadv_return(CPUState *cpu, target_ulong pc, uint32_t fd,
+		uint32_t vec, uint32_t vlen, uint32_t pos_l, uint32_t pos_h) {
+	// The number of bytes read is stored in the EAX register. Skip if nothing
+	// was read, or if the read failed.
+	uint32_t actualCount = ((CPUArchState*)cpu->env_ptr)->regs[0];
+	if ((int32_t)actualCount <= 0) return;
+	
+	// Resolve the file descriptor to a file or network target. If neither is
+	// valid, return because we don't know what this file descriptor 
+	// corresponds to.
+	Target target = resolveTarget(cpu, panda_current_asid(cpu), fd);
+	if (!target) return;
+
+	// Log that a recognizable target was seen
+	if (Policy::debug) 
+		logEvent(LogType::Seen, "vectored read of", target);
+	
+	// Read the whole iovec array in one access. The kernel accepted it, so
+	// failing to read it means that it is not mapped in the replay.
+	auto &iovecs = dependency_tracker.iovecs;
+	if (!readGuestValues(cpu, vec, iovecs, vlen)) {
+		if (countError(ErrorCategory::UntranslatablePage)) {
+			std::cerr << "dependency_tracker: failed to read " << vlen <<
+				" iovecs for fd " << fd << "." << std::endl;
+		}
+		
 		return;
 	}
 	
-	// Skip if nothing is actually being written to the file
-	if (count <= 0) return;
+	// Label the segments which were filled in, for each configuration in 
+	// which the target is a source.
+	uint64_t pos = ((uint64_t)pos_h << 32) | pos_l;
+	TargetIO io = { fd, pos, iovecs.data(), vlen, actualCount, "readv", true };
+	labelSources(cpu, target, io);
+}
+
+template<typename Policy>
+void on_pwritev_return(CPUState *cpu, target_ulong pc, uint32_t fd,
+		uint32_t vec, uint32_t vlen, uint32_t pos_l, uint32_t pos_h) {
+	// The number of bytes written is stored in the EAX register. Skip if 
+	// nothing was written, or if the write failed.
+	uint32_t actualCount = ((CPUArchState*)cpu->env_ptr)->regs[0];
+	if ((int32_t)actualCount <= 0) return;
 	
-	// Query the buffer contents, add the results to the labeled bytes
-	// property of the sink.
-	std::map<uint32_t, uint32_t> bytes = queryBufferContents(
-		cpu, buffer, count);
-	uint32_t totalTaintBytes = 0;
-	for (auto &it : bytes) {
-		uint32_t source = it.first;
-		uint32_t numTainted = it.second;
-		
-		// Note here that if source D.N.E. in the labeled bytes map, it will
-		// be default constructed with a value of zero.
-		targetSink->getLabeledBytes()[source] += numTainted;
-		totalTaintBytes += numTainted;
+	// Resolve the file descriptor to a file or network target. If neither is
+	// valid, return because we don't know what this file descriptor 
+	// corresponds to. If all file writes are shadowed or traced, every file
+	// is resolved.
+	Target target = resolveTarget(cpu, panda_current_asid(cpu), fd,
+		dependency_tracker.shadowWrites || dependency_tracker.traceWrites);
+	if (!target) return;
+
+	// Log that a recognizable target was seen
+	if (Policy::debug) 
+		logEvent(LogType::Seen, "vectored write of", target);
+	
+	// Read the whole iovec array in one access
+	auto &iovecs = dependency_tracker.iovecs;
+	if (!readGuestValues(cpu, vec, iovecs, vlen)) {
+		if (countError(ErrorCategory::UntranslatablePage)) {
+			std::cerr << "dependency_tracker: failed to read " << vlen <<
+				" iovecs for fd " << fd << "." << std::endl;
+		}
 		
-		std::cout << "dependency_tracker: ***saw write of sink target \"" <<
-			*target << "\", " << numTainted << "/" << count << 
-			" bytes written to target with label " << source << "***" << 
-			std::endl;
+		return;
 	}
 	
-	// Notify Target Sink of the write
-	targetSink->getTotalBytes() += count;
-	targetSink->getTotalTaintBytes() += totalTaintBytes;
-	targetSink->getTotalWrites()++;
+	// Query the segments which were written out, for each configuration in
+	// which the target is a sink.
+	uint64_t pos = ((uint64_t)pos_h << 32) | pos_l;
+	TargetIO io = { fd, pos, iovecs.data(), vlen, actualCount, "writev", 
+		true };
+	querySinks(cpu, target, io);
 }
 
+template<typename Policy>
 void on_read_return(CPUState *cpu, target_ulong pc, uint32_t fd, 
 		uint32_t buffer, uint32_t count) {
-	on_pread64_return(cpu, pc, fd, buffer, count, 0);
+	// Read advances the position of the file, which is looked up afterwards
+	on_pread64_return<Policy>(cpu, pc, fd, buffer, count, CURRENT_POSITION);
+}
+
+template<typename Policy>
+void on_readv_return(CPUState *cpu, target_ulong pc, uint32_t fd, 
+		uint32_t vec, uint32_t vlen) {
+	on_preadv_return<Policy>(cpu, pc, fd, vec, vlen, 
+		(uint32_t)CURRENT_POSITION, (uint32_t)(CURRENT_POSITION >> 32));
+}
+
+template<typename Policy>
+void on_sendfile_return(CPUState *cpu, target_ulong pc, int32_t out_fd,
+		int32_t in_fd, uint32_t offset, uint32_t count) {
+	copyFileDescriptors<Policy>(cpu, in_fd, offset, out_fd, 0, false, 
+		"sendfile", true);
+}
+
+template<typename Policy>
+void on_sendfile64_return(CPUState *cpu, target_ulong pc, int32_t out_fd,
+		int32_t in_fd, uint32_t offset, uint32_t count) {
+	copyFileDescriptors<Policy>(cpu, in_fd, offset, out_fd, 0, true, "sendfile",
+		true);
 }
 
+template<typename Policy>
 void on_socketcall_return(CPUState *cpu, target_ulong pc, int32_t call,
 		uint32_t args) {
 	switch (call) {
+	case SYS_ACCEPT:
+	case SYS_ACCEPT4:
+		return on_socketcall_accept_return<Policy>(cpu, args);
+	case SYS_BIND:
+		return on_socketcall_bind_return<Policy>(cpu, args);
 	case SYS_CONNECT:
-		return on_socketcall_connect_return(cpu, args);
+		return on_socketcall_connect_return<Policy>(cpu, args);
 	case SYS_RECV:
+		return on_socketcall_recv_return<Policy>(cpu, args);
 	case SYS_RECVFROM:
-		return on_socketcall_recv_return(cpu, args);
+		return on_socketcall_recvfrom_return<Policy>(cpu, args);
+	case SYS_RECVMSG:
+		return on_socketcall_recvmsg_return<Policy>(cpu, args);
 	case SYS_SEND:
+		return on_socketcall_send_return<Policy>(cpu, args);
 	case SYS_SENDTO:
-		return on_socketcall_send_return(cpu, args);
+		return on_socketcall_sendto_return<Policy>(cpu, args);
+	case SYS_SENDMSG:
+		return on_socketcall_sendmsg_return<Policy>(cpu, args);
+	case SYS_SOCKET:
+		return on_socketcall_socket_return<Policy>(cpu, args);
+	case SYS_SOCKETPAIR:
+		return on_socketcall_socketpair_return<Policy>(cpu, args);
+	}
+}
+
+template<typename Policy>
+void on_socketcall_accept_return(CPUState *cpu, uint32_t args) {
+	// The accepted socket is returned in the EAX register. Skip if the call
+	// failed.
+	uint32_t sockfd = ((CPUArchState*)cpu->env_ptr)->regs[0];
+	if ((int32_t)sockfd < 0) return;
+	
+	// Get the listening socket, and the address and address length pointer
+	// which the peer was written to, if any.
+	uint32_t arguments[3];
+	if (!readSocketcallArgs(cpu, args, arguments)) return;
+	
+	// Sockets accepted on a UNIX socket are channels, whose peer is the end 
+	// which connected to the path of the listening socket.
+	target_ulong asid = panda_current_asid(cpu);
+	Target listening = resolveTarget(cpu, asid, arguments[0]);
+	if (listening.kind == TargetKind::Channel) {
+		Target target = internUnixSocket(cpu, asid, sockfd);
+		auto path = dependency_tracker.boundPaths.find(listening);
+		if (target && path != dependency_tracker.boundPaths.end())
+			matchPeer(path->second, target, true);
+		
+		return;
+	}
+	
+	uint32_t length = 0;
+	if (arguments[1] != 0 && 
+			!readGuestValues(cpu, arguments[2], &length, 1)) {
+		length = 0;
+	}
+	
+	// Classify the peer once, and map the accepted socket to it so that its
+	// reads and writes are resolved without decoding any address.
+	Target target;
+	if (length > 0) {
+		target = getTargetSockaddr(cpu, asid, arguments[0], arguments[1], 
+			length);
+	}
+	if (!target) target = getTargetListener(asid, arguments[0]);
+	if (!target) return;
+	
+	dependency_tracker.networks.insert(asid, sockfd, target);
+
+	// Log that a recognizable target was seen
+	if (Policy::debug) 
+		logEvent(LogType::Seen, "accept from", target);
+	
+	// Log connection if this is a source or sink
+	if (isSource(target)) {
+		logEvent(LogType::SourceConnection, "accept from", target);
+	} else if (isSink(target)) {
+		logEvent(LogType::SinkConnection, "accept from", target);
+	}
+}
+
+template<typename Policy>
+void on_socketcall_bind_return(CPUState *cpu, uint32_t args) {
+	// Skip if the call failed, in which case EAX holds a negative error 
+	// number.
+	if (((CPUArchState*)cpu->env_ptr)->regs[0] != 0) return;
+	
+	uint32_t arguments[3];
+	if (!readSocketcallArgs(cpu, args, arguments)) return;
+	
+	// UNIX sockets are bound to a path, which their peers connect to
+	std::string path;
+	if (readUnixSocketPath(cpu, arguments[1], arguments[2], path)) {
+		Target target = resolveTarget(cpu, panda_current_asid(cpu), 
+			arguments[0]);
+		if (target.kind == TargetKind::Channel) 
+			dependency_tracker.boundPaths[target] = path;
+		
+		return;
 	}
+	
+	SocketAddress address;
+	if (!readSocketAddress(cpu, arguments[1], arguments[2], address)) return;
+	
+	// A socket bound to a port receives anything arriving on that port, 
+	// whatever the local address, so it is known by the wildcard target of 
+	// the port. Only wildcard targets which are sources or sinks are used.
+	Target listener = dependency_tracker.targets.findNetwork("*", 
+		address.port);
+	if (!listener) return;
+	
+	target_ulong asid = panda_current_asid(cpu);
+	dependency_tracker.listeners.insert(asid, arguments[0], listener);
+	
+	// Log that a recognizable target was seen
+	if (Policy::debug) logEvent(LogType::Seen, "bind to", listener);
 }
 
+template<typename Policy>
 void on_socketcall_connect_return(CPUState *cpu, uint32_t args) {
-	// Get the arguments from the args virtual memory
-	auto arguments = getMemoryValues<uint32_t>(cpu, args, 3);
-
-	// Get the sockaddr structure from the arguments. The virtual memory 
-	// address to the sockaddr structure is stored in the second argument of
-	// the args passed to connect(). Use that address to get the sockaddr.
-	auto sockaddrPtr = arguments[1];
-	sockaddr addr = getMemoryValues<sockaddr>(cpu, sockaddrPtr, 1)[0];
-	
-	// Stores the IP address found and the port number
-	char ip[INET6_ADDRSTRLEN] = {0};
-	unsigned short port = 0;
+	// Get the arguments from the args virtual memory, and the address which
+	// the socket was connected to, which is the second argument. Its length,
+	// the third argument, covers the whole address, so IPv6 addresses are
+	// read in full. We only process IPv4 and IPv6 connections here, and the
+	// connections of UNIX sockets to a path.
+	uint32_t arguments[3];
+	if (!readSocketcallArgs(cpu, args, arguments)) return;
+	uint32_t sockfd = arguments[0];
 	
-	// Get the IP address and Port Number using the sockaddr structure. We
-	// only process IPv4 and IPv6 connections here.
-	auto saFam = addr.sa_family;
-	if (saFam == AF_INET) {
-		sockaddr_in *sin4 = reinterpret_cast<sockaddr_in*>(&addr);
+	// The connecting UNIX socket is the peer of the socket accepted on the
+	// path, if the connection succeeded.
+	std::string path;
+	if (readUnixSocketPath(cpu, arguments[1], arguments[2], path)) {
+		if (((CPUArchState*)cpu->env_ptr)->regs[0] != 0) return;
 		
-		inet_ntop(AF_INET, &sin4->sin_addr, ip, INET6_ADDRSTRLEN);
-		port = sin4->sin_port;
-	} else if (saFam == AF_INET6) {
-		sockaddr_in6 *sin6 = reinterpret_cast<sockaddr_in6*>(&addr);
+		Target target = resolveTarget(cpu, panda_current_asid(cpu), sockfd);
+		if (target.kind != TargetKind::Channel) return;
+		matchPeer(path, target, false);
 		
-		inet_ntop(AF_INET6, &sin6->sin6_addr, ip, INET6_ADDRSTRLEN);
-		port = sin6->sin6_port;
-	} else {
+		// Log that a recognizable target was seen
+		if (Policy::debug) logEvent(LogType::Seen, "connect to", target);
 		return;
 	}
 	
-	// Map the current ASID and File Descriptor to the Network Target.
-	int sockfd = arguments[0];
-	auto asid_fd_pair = std::make_pair(panda_current_asid(cpu), sockfd);
-	TargetNetwork target(std::string(ip), port);
-	dependency_tracker.networks[asid_fd_pair] = target;
+	SocketAddress address;
+	if (!readSocketAddress(cpu, arguments[1], arguments[2], address)) return;
+	
+	// Map the current ASID and File Descriptor to the interned Network 
+	// Target.
+	Target target = getTargetAddress(address, true);
+	if (!target) return;
+	dependency_tracker.networks.insert(panda_current_asid(cpu), sockfd, 
+		target);
 
 	// Log that a recognizable target was seen
-	if (dependency_tracker.debug) {
-		std::cout << "dependency_tracker: saw connect to target \"" << target 
-			<< "\"." << std::endl;
-	}
+	if (Policy::debug) logEvent(LogType::Seen, "connect to", target);
 	
 	// Log connection if this is a source or sink
 	if (isSource(target)) {
-		std::cout << "dependency_tracker: ***saw connect to source target: \"" 
-			<< target << "\"***" << std::endl;
+		logEvent(LogType::SourceConnection, "connect to", target);
 	} else if (isSink(target)) {
-		std::cout << "dependency_tracker: ***saw connect to sink target: \"" 
-			<< target << "\"***" << std::endl;
+		logEvent(LogType::SinkConnection, "connect to", target);
 	}
 }
 
+template<typename Policy>
 void on_socketcall_recv_return(CPUState *cpu, uint32_t args) {
 	// Get the arguments from the args virtual memory
-	auto arguments = getMemoryValues<uint32_t>(cpu, args, 3);
+	uint32_t arguments[3];
+	if (!readSocketcallArgs(cpu, args, arguments)) return;
 	
 	// Retrieve the socket file descriptor, buffer address and buffer length
 	// from the arguments.
@@ -361,46 +1614,81 @@ void on_socketcall_recv_return(CPUState *cpu, uint32_t args) {
 	
 	// We are expecting a Source Network Target here, so we only have to try to
 	// get a Network Target.
-	TargetNetwork tN = getTargetNetwork(panda_current_asid(cpu), sockfd);
-	
-	// Check that the target network is valid, if not continue
-	Target *target = nullptr;
-	if (tN)      target = &tN;
-	else         return;
+	Target target = getTargetNetwork(panda_current_asid(cpu), sockfd);
+	if (!target) return;
 
 	// Log that a recognizable target was seen
-	if (dependency_tracker.debug) {
-		std::cout << "dependency_tracker: saw recv from target \"" << *target 
-			<< "\"." << std::endl;
-	}
+	if (Policy::debug) logEvent(LogType::Seen, "recv from", target);
 	
-	// Get the pointer to the target source associated with the fetched target
-	TargetSource *targetSource = nullptr;
-	try {
-		targetSource = &getTargetSource(*target);
-	} catch (const std::invalid_argument &e) {
-		return;
+	// Label the buffer contents for each configuration in which the target is
+	// a source.
+	GuestIOVec segment = { buffer, length };
+	TargetIO io = { sockfd, 0, &segment, 1, length, "recv", false };
+	labelSources(cpu, target, io);
+}
+
+template<typename Policy>
+void on_socketcall_recvfrom_return(CPUState *cpu, uint32_t args) {
+	// The number of bytes received is stored in the EAX register. Skip if 
+	// nothing was received, or if the call failed.
+	uint32_t length = ((CPUArchState*)cpu->env_ptr)->regs[0];
+	if ((int32_t)length <= 0) return;
+	
+	// Get the socket, buffer, flags, and the address and address length 
+	// pointer which the sender was written to, if any.
+	uint32_t arguments[6];
+	if (!readSocketcallArgs(cpu, args, arguments)) return;
+	
+	uint32_t sockfd = arguments[0];
+	uint32_t buffer = arguments[1];
+	uint32_t addrLength = 0;
+	if (arguments[4] != 0 && 
+			!readGuestValues(cpu, arguments[5], &addrLength, 1)) {
+		addrLength = 0;
 	}
 	
-	// Label the buffer contents, add number of tainted bytes to the target
-	// source.
-	uint32_t bytes = labelBufferContents(cpu, buffer, length, 
-		targetSource->getIndex());
-	targetSource->getLabeledBytes() += bytes;
+	// Resolve the sender, which is classified once per peer
+	Target target = getTargetPeer(cpu, panda_current_asid(cpu), sockfd,
+		addrLength > 0 ? arguments[4] : 0, addrLength);
+	if (!target) return;
+
+	// Log that a recognizable target was seen
+	if (Policy::debug) 
+		logEvent(LogType::Seen, "recvfrom from", target);
+	
+	// Label the buffer contents for each configuration in which the target is
+	// a source.
+	GuestIOVec segment = { buffer, length };
+	TargetIO io = { sockfd, 0, &segment, 1, length, "recvfrom", false };
+	labelSources(cpu, target, io);
+}
+
+template<typename Policy>
+void on_socketcall_recvmsg_return(CPUState *cpu, uint32_t args) {
+	// The number of bytes received is stored in the EAX register. Skip if 
+	// nothing was received, or if the call failed.
+	uint32_t length = ((CPUArchState*)cpu->env_ptr)->regs[0];
+	if ((int32_t)length <= 0) return;
 	
-	// Notify Target Source of the read
-	targetSource->getTotalBytes() += length;
-	targetSource->getTotalReads()++;
+	// Decode the message header, the network target it was received from and
+	// its iovec array.
+	uint32_t sockfd = 0;
+	Target target = decodeMessage<Policy>(cpu, args, "recvmsg of", sockfd);
+	if (!target) return;
 	
-	// Output that the target source was seen and tainted, if applicable
-	std::cout << "dependency_tracker: ***saw recv of source target: \"" <<
-		*target << "\", tainted " << bytes << "/" << length << 
-		" bytes with label " << targetSource->getIndex() << "***" << std::endl;
+	// Label the segments which were filled in, for each configuration in 
+	// which the target is a source.
+	auto &iovecs = dependency_tracker.iovecs;
+	TargetIO io = { sockfd, 0, iovecs.data(), (uint32_t)iovecs.size(), length, 
+		"recvmsg", true };
+	labelSources(cpu, target, io);
 }
 
+template<typename Policy>
 void on_socketcall_send_return(CPUState *cpu, uint32_t args) {
 	// Get the arguments from the args virtual memory
-	auto arguments = getMemoryValues<uint32_t>(cpu, args, 3);
+	uint32_t arguments[3];
+	if (!readSocketcallArgs(cpu, args, arguments)) return;
 	
 	// Retrieve the socket file descriptor, buffer address and buffer length
 	// from the arguments.
@@ -413,56 +1701,223 @@ void on_socketcall_send_return(CPUState *cpu, uint32_t args) {
 	
 	// We are expecting a Sink Network Target here, so we only have to try to
 	// get a Network Target.
-	TargetNetwork tN = getTargetNetwork(panda_current_asid(cpu), sockfd);
-
-	// Check that the target network is valid, if not continue
-	Target *target = nullptr;
-	if (tN)      target = &tN;
-	else         return;
+	Target target = getTargetNetwork(panda_current_asid(cpu), sockfd);
+	if (!target) return;
 
 		// Log that a recognizable target was seen
-	if (dependency_tracker.debug) {
-		std::cout << "dependency_tracker: saw send to target \"" << *target << 
-			"\"." << std::endl;
-	}
+	if (Policy::debug) logEvent(LogType::Seen, "send to", target);
+
+	// Query the buffer contents and credit the sources found in it to the
+	// sink, in each configuration in which the target is a sink.
+	GuestIOVec segment = { buffer, length };
+	TargetIO io = { sockfd, 0, &segment, 1, length, "send", false };
+	querySinks(cpu, target, io);
+}
+
+template<typename Policy>
+void on_socketcall_sendto_return(CPUState *cpu, uint32_t args) {
+	// The number of bytes sent is stored in the EAX register. Skip if nothing
+	// was sent, or if the call failed.
+	uint32_t length = ((CPUArchState*)cpu->env_ptr)->regs[0];
+	if ((int32_t)length <= 0) return;
+	
+	// Get the socket, buffer, flags, and the destination address and its 
+	// length, if any.
+	uint32_t arguments[6];
+	if (!readSocketcallArgs(cpu, args, arguments)) return;
+	
+	uint32_t sockfd = arguments[0];
+	uint32_t buffer = arguments[1];
+	
+	// Resolve the destination, which is classified once per peer
+	Target target = getTargetPeer(cpu, panda_current_asid(cpu), sockfd,
+		arguments[4], arguments[5]);
+	if (!target) return;
 
-	// Get the pointer to the target source associated with the fetched target
-	TargetSink *targetSink = nullptr;
-	try {
-		targetSink = &getTargetSink(*target);
-	} catch (const std::invalid_argument &e) {
+	// Log that a recognizable target was seen
+	if (Policy::debug) logEvent(LogType::Seen, "sendto to", target);
+
+	// Query the buffer contents and credit the sources found in it to the
+	// sink, in each configuration in which the target is a sink.
+	GuestIOVec segment = { buffer, length };
+	TargetIO io = { sockfd, 0, &segment, 1, length, "sendto", false };
+	querySinks(cpu, target, io);
+}
+
+template<typename Policy>
+void on_socketcall_sendmsg_return(CPUState *cpu, uint32_t args) {
+	// The number of bytes sent is stored in the EAX register. Skip if nothing
+	// was sent, or if the call failed.
+	uint32_t length = ((CPUArchState*)cpu->env_ptr)->regs[0];
+	if ((int32_t)length <= 0) return;
+	
+	// Decode the message header, the network target it was sent to and its
+	// iovec array.
+	uint32_t sockfd = 0;
+	Target target = decodeMessage<Policy>(cpu, args, "sendmsg of", sockfd);
+	if (!target) return;
+	
+	// Query the segments which were sent, for each configuration in which the
+	// target is a sink.
+	auto &iovecs = dependency_tracker.iovecs;
+	TargetIO io = { sockfd, 0, iovecs.data(), (uint32_t)iovecs.size(), length, 
+		"sendmsg", true };
+	querySinks(cpu, target, io);
+}
+
+template<typename Policy>
+void on_socketcall_socket_return(CPUState *cpu, uint32_t args) {
+	// The new socket is returned in the EAX register. Skip if the call 
+	// failed.
+	uint32_t sockfd = ((CPUArchState*)cpu->env_ptr)->regs[0];
+	if ((int32_t)sockfd < 0) return;
+	
+	// Only UNIX sockets are channels. The domain is the first argument.
+	uint32_t arguments[1];
+	if (!readSocketcallArgs(cpu, args, arguments)) return;
+	if (arguments[0] != AF_UNIX) return;
+	
+	Target target = internUnixSocket(cpu, panda_current_asid(cpu), sockfd);
+	if (!target) return;
+	
+	// Log that a recognizable target was seen
+	if (Policy::debug) logEvent(LogType::Seen, "socket of", target);
+}
+
+template<typename Policy>
+void on_socketcall_socketpair_return(CPUState *cpu, uint32_t args) {
+	// Skip if the call failed, in which case EAX holds a negative error 
+	// number.
+	if (((CPUArchState*)cpu->env_ptr)->regs[0] != 0) return;
+	
+	// Get the domain and the address of the array of the two new sockets,
+	// which are the first and the fourth arguments.
+	uint32_t arguments[4];
+	int32_t sockets[2];
+	if (!readSocketcallArgs(cpu, args, arguments) || 
+			arguments[0] != AF_UNIX ||
+			!readGuestValues(cpu, arguments[3], sockets, 2)) {
 		return;
 	}
+	
+	// The data written to either end is read from the other end
+	target_ulong asid = panda_current_asid(cpu);
+	Target first = internUnixSocket(cpu, asid, sockets[0]);
+	Target second = internUnixSocket(cpu, asid, sockets[1]);
+	pairChannels(first, second);
+	
+	// Log that a recognizable target was seen
+	if (Policy::debug && first) logEvent(LogType::Seen, "socketpair of", first);
+}
+
+template<typename Policy>
+void on_splice_return(CPUState *cpu, target_ulong pc, int32_t fd_in,
+		uint32_t off_in, int32_t fd_out, uint32_t off_out, uint32_t len,
+		uint32_t flags) {
+	copyFileDescriptors<Policy>(cpu, fd_in, off_in, fd_out, off_out, true, 
+		"splice", true);
+}
+
+template<typename Policy>
+void on_tee_return(CPUState *cpu, target_ulong pc, int32_t fdin, 
+		int32_t fdout, uint32_t len, uint32_t flags) {
+	// Tee duplicates the data of one pipe into another, without consuming it
+	copyFileDescriptors<Policy>(cpu, fdin, 0, fdout, 0, true, "tee", false);
+}
+
+template<typename Policy>
+void on_write_return(CPUState *cpu, target_ulong pc, uint32_t fd, 
+		uint32_t buffer, uint32_t count) {
+	// Write advances the position of the file, which is looked up afterwards
+	on_pwrite64_return<Policy>(cpu, pc, fd, buffer, count, CURRENT_POSITION);
+}
+
+template<typename Policy>
+void on_writev_return(CPUState *cpu, target_ulong pc, uint32_t fd, 
+		uint32_t vec, uint32_t vlen) {
+	on_pwritev_return<Policy>(cpu, pc, fd, vec, vlen, 
+		(uint32_t)CURRENT_POSITION, (uint32_t)(CURRENT_POSITION >> 32));
+}
+
+bool openReport(const std::string &format, uint32_t queue) {
+	if (format != "jsonl" && format != "csv") {
+		std::cerr << "dependency_tracker: unknown report format \"" << 
+			format << "\"." << std::endl;
+		return false;
+	}
+	
+	auto &stream = dependency_tracker.reportStream;
+	stream.open(dependency_tracker.reportFile);
+	if (!stream.is_open()) {
+		std::cerr << "dependency_tracker: failed to create report \"" << 
+			dependency_tracker.reportFile << "\"." << std::endl;
+		return false;
+	}
+	
+	auto &encoder = dependency_tracker.reportEncoder;
+	encoder.setFormat((format == "csv") ? ReportFormat::CSV : 
+		ReportFormat::JSONLines);
+	stream << encoder.getHeader() << std::flush;
+	
+	auto &report = dependency_tracker.reportLog;
+	report.setOutput(stream);
+	report.start(queue);
+	return true;
+}
 
-	// Query the buffer contents, add the results to the labeled bytes
-	// property of the sink.
-	std::map<uint32_t, uint32_t> bytes = queryBufferContents(
-		cpu, buffer, length);
-	uint32_t totalTaintBytes = 0;
-	for (auto &it : bytes) {
-		uint32_t source = it.first;
-		uint32_t numTainted = it.second;
-		
-		// Note here that if source D.N.E. in the labeled bytes map, it will
-		// be default constructed with a value of zero.
-		targetSink->getLabeledBytes()[source] += numTainted;
-		totalTaintBytes += numTainted;
-		
-		std::cout << "dependency_tracker: ***saw send of sink target \"" <<
-			*target << "\", " << numTainted << "/" << length << 
-			" bytes written to target with label " << source << "***" << 
+bool openStats() {
+	auto &stats = dependency_tracker.stats;
+	auto &configurations = dependency_tracker.configurations;
+	if (!stats.open(dependency_tracker.statsFile, dependency_tracker.targets,
+			2 * configurations.size())) {
+		std::cerr << "dependency_tracker: failed to create stats file \"" <<
+			dependency_tracker.statsFile << "\"." << std::endl;
+		return false;
+	}
+	
+	// The counters which do not fit are kept in memory, and only show up in
+	// the reports.
+	bool attached = true;
+	for (auto &configuration : configurations) {
+		attached &= configuration->sources.attach(stats, configuration->index,
+			configuration->name);
+		attached &= configuration->sinks.attach(stats, configuration->index,
+			configuration->name);
+	}
+	if (!attached) {
+		std::cerr << "dependency_tracker: failed to map every counter into " <<
+			"stats file \"" << dependency_tracker.statsFile << "\"." << 
 			std::endl;
 	}
 	
-	// Notify Target Sink of the write
-	targetSink->getTotalBytes() += length;
-	targetSink->getTotalTaintBytes() += totalTaintBytes;
-	targetSink->getTotalWrites()++;
+	return attached;
 }
 
-void on_write_return(CPUState *cpu, target_ulong pc, uint32_t fd, 
-		uint32_t buffer, uint32_t count) {
-	on_pwrite64_return(cpu, pc, fd, buffer, count, 0);
+bool openTrace() {
+	auto &trace = dependency_tracker.trace;
+	std::string file = dependency_tracker.traceFile;
+	if (dependency_tracker.traceShardSize > 0) 
+		file += "." + std::to_string(dependency_tracker.traceShards);
+	
+	if (!trace.open(file)) {
+		std::cerr << "dependency_tracker: failed to create event trace \"" << 
+			file << "\"." << std::endl;
+		return false;
+	}
+	
+	++dependency_tracker.traceShards;
+	return true;
+}
+
+uint64_t packTarget(const Target &target) {
+	return (static_cast<uint64_t>(target.kind) << 32) | target.id;
+}
+
+void pairChannels(const Target &first, const Target &second) {
+	if (!first || !second) return;
+	
+	dependency_tracker.channelPeers[first] = second;
+	dependency_tracker.channelPeers[second] = first;
 }
 
 std::vector<std::vector<std::string>> parseCSV(const std::string &fileName) {
@@ -473,28 +1928,30 @@ std::vector<std::vector<std::string>> parseCSV(const std::string &fileName) {
 	if (!ifs.is_open()) return lines;
 
 	// Read the file in line by line
-	std::string token;
 	std::string line;
 	while (std::getline(ifs, line)) {
 		std::vector<std::string> tokens;
 
-		// Split the string by quotation marks into tokens
-		std::stringstream ssLine(line);		
-		while(std::getline(ssLine, token, '"')) {
-			std::stringstream ss(token);
-
-			// For each token, split on a comma and add each individual token
-			// to the tokens of this line vector.
-			while(std::getline(ss, token, ',')) {
-				if (!token.empty()) tokens.push_back(token);
-			}
-			
-			// If this token contains a end-quotation mark, add it to the 
-			// individual tokens list as well.
-			if(std::getline(ssLine, token, '"')) {
+		// Split the line on the commas which are not in quotes. A quote in a
+		// quoted token is written as two quotes.
+		std::string token;
+		bool quoted = false;
+		for (size_t i = 0; i < line.size(); ++i) {
+			char c = line[i];
+			if (c == '"' && quoted && i + 1 < line.size() && 
+					line[i + 1] == '"') {
+				token += c;
+				++i;
+			} else if (c == '"') {
+				quoted = !quoted;
+			} else if (c == ',' && !quoted) {
 				if (!token.empty()) tokens.push_back(token);
+				token.clear();
+			} else {
+				token += c;
 			}
 		}
+		if (!token.empty()) tokens.push_back(token);
 
 		// Add the tokens of this line to the lines list
 		if (!tokens.empty()) lines.push_back(tokens);
@@ -503,8 +1960,34 @@ std::vector<std::vector<std::string>> parseCSV(const std::string &fileName) {
 	return lines;
 }
 
-std::vector<std::unique_ptr<Target>> parseTargets(const std::string &file) {
-	std::vector<std::unique_ptr<Target>> targets;
+void parseConfigurations(const std::string &file) {
+	std::vector<std::vector<std::string>> lines = parseCSV(file);
+	if (lines.empty()) {
+		std::cerr << "dependency_tracker: no configurations found in \"" << 
+			file << "\"." << std::endl;
+	}
+
+	unsigned int lineNumber = 0;
+	for (auto &line : lines) {
+		++lineNumber;
+
+		if (line.size() == 3) {
+			addConfiguration(line[0], line[1], line[2], false);
+		} else {
+			std::cerr << "dependency_tracker: unknown configuration on line " 
+				<< lineNumber << "." << std::endl;
+		}
+	}
+}
+
+TargetKind parseKindCode(const std::string &code) {
+	if (code == "n") return TargetKind::Network;
+	if (code == "c") return TargetKind::Channel;
+	return TargetKind::File;
+}
+
+std::vector<Target> parseTargets(const std::string &file) {
+	std::vector<Target> targets;
 	std::vector<std::vector<std::string>> lines = parseCSV(file);
 
 	unsigned int lineNumber = 0;
@@ -514,9 +1997,13 @@ std::vector<std::unique_ptr<Target>> parseTargets(const std::string &file) {
 		if (line.size() == 2 && line[0] == "f") {
 			std::string fileName = line[1];
 	
-			auto target = std::unique_ptr<TargetFile>(
-				new TargetFile(fileName));
-			targets.push_back(std::move(target));
+			targets.push_back(dependency_tracker.targets.intern(
+				TargetKind::File, fileName));
+		} else if (line.size() == 2 && line[0] == "c") {
+			std::string channelName = line[1];
+			
+			targets.push_back(dependency_tracker.targets.intern(
+				TargetKind::Channel, channelName));
 		} else if (line.size() == 3 && line[0] == "n") {
 			std::string ip = line[1];
 			unsigned short port = 0;			
@@ -535,9 +2022,8 @@ std::vector<std::unique_ptr<Target>> parseTargets(const std::string &file) {
 				continue;
 			}
 
-			auto target = std::unique_ptr<TargetNetwork>(
-				new TargetNetwork(ip, port));
-			targets.push_back(std::move(target));
+			targets.push_back(dependency_tracker.targets.internNetwork(
+				ip.c_str(), port));
 		} else {
 			std::cerr << "dependency_tracker: unknown target on line " <<
 				lineNumber << "." << std::endl;
@@ -547,37 +2033,292 @@ std::vector<std::unique_ptr<Target>> parseTargets(const std::string &file) {
 	return targets;
 }
 
-std::map<uint32_t, uint32_t> queryBufferContents(
-		CPUState *cpu, target_ulong vAddr, uint32_t length) {
-	std::map<uint32_t, uint32_t> map; // { label -> number of bytes tainted }
-	if (!taint2_enabled()) return map;
+void queryBufferContents(const PageRuns &runs, LabelHistogram &histogram,
+		std::vector<ShadowSpan> *spans) {
+	histogram.clear();
+	if (!taint2_enabled()) return;
+	
+	// Reusable label sets, grown to the largest label set seen: the label 
+	// set of the current range of bytes, and the label set of a byte.
+	auto &labelSet = dependency_tracker.labelSet;
+	auto &byteLabelSet = dependency_tracker.byteLabelSet;
+	uint64_t rangeStart = 0;
+	uint64_t rangeEnd = 0;
+	
+	// Adjacent bytes usually carry the same label set, so the bytes are 
+	// merged into ranges with the same label set, and each range is added to
+	// the histogram and to the spans at once.
+	auto flush = [&]() {
+		if (rangeStart == rangeEnd) return;
+		
+		// Drop the elements which taint2_query_set_ram did not write to and
+		// add the range to the number of bytes tainted by each label.
+		labelSet.erase(std::remove(labelSet.begin(), labelSet.end(), 
+			(uint32_t)(-1)), labelSet.end());
+		for (auto label : labelSet) histogram.add(label, rangeEnd - rangeStart);
+		
+		// Sort the labels, so that the label sets of adjacent ranges can be
+		// compared. Extend the last span if this range follows it and carries
+		// the same labels, otherwise start a new span.
+		if (spans && !labelSet.empty()) {
+			std::sort(labelSet.begin(), labelSet.end());
+			if (!spans->empty() && spans->back().end == rangeStart &&
+					spans->back().labels == labelSet) {
+				spans->back().end = rangeEnd;
+			} else {
+				spans->push_back(ShadowSpan{ rangeStart, rangeEnd, labelSet });
+			}
+		}
+		
+		rangeStart = rangeEnd;
+	};
+	
+	for (auto &run : runs.getRuns()) {
+		for (uint32_t i = 0; i < run.length; ++i) {
+			hwaddr pAddr = run.pAddr + i;
+			uint64_t offset = run.offset + i;
+			
+			// Bytes which are not tainted end the current range
+			uint32_t labelSetSize = taint2_query_ram(pAddr);
+			if (labelSetSize == 0) {
+				flush();
+				continue;
+			}
+			
+			// Get the label set of the byte. By default, set each label to a
+			// negative number to indicate no source wrote anything to it.
+			byteLabelSet.assign(labelSetSize, (uint32_t)(-1));
+			taint2_query_set_ram(pAddr, byteLabelSet.data());
+			
+			// Extend the current range if this byte follows it and carries 
+			// the same label set, otherwise start a new range.
+			if (rangeStart != rangeEnd && rangeEnd == offset && 
+					byteLabelSet == labelSet) {
+				++rangeEnd;
+			} else {
+				flush();
+				labelSet.swap(byteLabelSet);
+				rangeStart = offset;
+				rangeEnd = offset + 1;
+			}
+		}
+	}
+	
+	flush();
+	
+	// Sort the labels, so that sources are reported in order
+	histogram.sort();
+}
+
+void querySinks(CPUState *cpu, const Target &target, const TargetIO &io) {
+	auto &runs = dependency_tracker.runs;
+	auto &spans = dependency_tracker.spans;
+	
+	countChannel(target, io.length, true);
+	
+	// Get the index of the sink associated with the target in each
+	// configuration. The labels of data written to files and channels are 
+	// recorded in their shadows if all writes are shadowed, or if the target
+	// already is shadowed. Every write is queried if writes are traced. If
+	// none of these applies, the buffer need not be queried at all.
+	bool isSink = findSinks(target);
+	LabelShadow *shadow = getShadow(target, false);
+	bool record = (shadow && !(isStream(target) && shadow->empty())) || 
+		(dependency_tracker.shadowWrites && target.kind != TargetKind::Network);
+	auto &trace = dependency_tracker.trace;
+	bool traced = trace.isOpen() && (isSink || dependency_tracker.traceWrites);
+	
+	// The data written to a stream advances its write offset, even if its
+	// labels are not recorded, so that the labels written later line up with
+	// the data read.
+	if (!isSink && !record && !traced) {
+		if (shadow) shadow->produce(io.length);
+		return;
+	}
+	
+	// The kernel just read the buffer, so the pages of source mappings which
+	// it covers are resident now. Label them before they are queried, in 
+	// case they were not found resident yet.
+	if (!dependency_tracker.mappings.empty()) {
+		target_ulong asid = panda_current_asid(cpu);
+		for (uint32_t i = 0; i < io.count; ++i) {
+			labelMappingRange(cpu, asid, io.segments[i].base, 
+				io.segments[i].length);
+		}
+	}
+	
+	// Query the buffer contents once
+	runs.clear();
+	runs.add(cpu, io.segments, io.count, io.length);
+	spans.clear();
+	queryBufferContents(runs, dependency_tracker.histogram, 
+		record ? &spans : nullptr);
+	
+	// Record the labels of the data in the shadow of the target, which 
+	// overwrites the labels of the range written. The shadow of a file is 
+	// only created once labeled data is written to it. If the position of a
+	// file is unknown, the shadow is left as is, rather than overwriting the
+	// labels of the wrong range.
+	if (record && !spans.empty()) shadow = getShadow(target, true);
+	if (shadow) {
+		uint64_t offset = 0;
+		bool known = record;
+		if (isStream(target)) offset = shadow->produce(io.length);
+		else known = known && getIOOffset(cpu, io, offset);
+		
+		if (known) shadow->write(offset, io.length, spans);
+	}
+	
+	// Credit the labels found to the configurations which own them
+	if (isSink) {
+		creditSinks(io.length, dependency_tracker.histogram, io.event, 
+			io.vectored);
+	}
 	
-	for (auto i = 0; i < length; ++i) {
-		// Convert the virtual address to a physical, assert it is valid, if
-		// not skip this byte.
-		hwaddr pAddr = panda_virt_to_phys(cpu, vAddr + i);
-		if (pAddr == (hwaddr)(-1)) continue;
+	// Trace the labels found, so that the write can be analyzed again 
+	// offline, against other sinks.
+	if (traced) {
+		uint64_t instruction = rr_get_guest_instr_count();
+		target_ulong asid = panda_current_asid(cpu);
+		if (isSink) {
+			trace.addSink(instruction, asid, io.fd, target, io.length, 
+				dependency_tracker.histogram);
+		} else {
+			trace.addWrite(instruction, asid, io.fd, target, io.length, 
+				dependency_tracker.histogram);
+		}
 		
-		// Initialize the label set to store the sources which tainted this
-		// byte. By default, set each source index to a negative number to
-		// indicate no source wrote anything to this byte.
-		uint32_t labelSetSize = taint2_query_ram(pAddr);
-		uint32_t labelSet[labelSetSize];
-		for (auto i = 0; i < labelSetSize; ++i) labelSet[i] = -1;
+		rotateTrace();
+	}
+}
+
+void reportEvent(ReportType type, const char *event, uint64_t first, 
+		uint64_t second, uint64_t third, uint64_t fourth) {
+	if (!dependency_tracker.reportStream.is_open()) return;
+	
+	LogRecord record;
+	record.type = static_cast<uint16_t>(type);
+	record.event = event;
+	record.values[0] = first;
+	record.values[1] = second;
+	record.values[2] = third;
+	record.values[3] = fourth;
+	
+	dependency_tracker.reportLog.push(record);
+}
+
+template<typename Policy>
+void registerIOCallbacks() {
+	PPP_REG_CB("syscalls2", on_sys_socketcall_return, 
+		on_socketcall_return<Policy>);
+	PPP_REG_CB("syscalls2", on_sys_pread64_return, on_pread64_return<Policy>);
+	PPP_REG_CB("syscalls2", on_sys_read_return, on_read_return<Policy>);
+	PPP_REG_CB("syscalls2", on_sys_pwrite64_return, 
+		on_pwrite64_return<Policy>);
+	PPP_REG_CB("syscalls2", on_sys_write_return, on_write_return<Policy>);
+	PPP_REG_CB("syscalls2", on_sys_preadv_return, on_preadv_return<Policy>);
+	PPP_REG_CB("syscalls2", on_sys_readv_return, on_readv_return<Policy>);
+	PPP_REG_CB("syscalls2", on_sys_pwritev_return, on_pwritev_return<Policy>);
+	PPP_REG_CB("syscalls2", on_sys_writev_return, on_writev_return<Policy>);
+	PPP_REG_CB("syscalls2", on_sys_sendfile_return, 
+		on_sendfile_return<Policy>);
+	PPP_REG_CB("syscalls2", on_sys_sendfile64_return, 
+		on_sendfile64_return<Policy>);
+	PPP_REG_CB("syscalls2", on_sys_splice_return, on_splice_return<Policy>);
+	PPP_REG_CB("syscalls2", on_sys_tee_return, on_tee_return<Policy>);
+	PPP_REG_CB("syscalls2", on_sys_copy_file_range_return, 
+		on_copy_file_range_return<Policy>);
+}
+
+Target resolveTarget(CPUState *cpu, target_ulong asid, uint32_t fd,
+		bool intern) {
+	// Connected sockets are known without asking OSI for the file name, so
+	// check the networks first. Their file names are of no use anyways.
+	Target *network = dependency_tracker.networks.find(asid, fd);
+	if (network) return *network;
+	
+	// Channels are cached, since their names are only ever their inode
+	auto &channels = dependency_tracker.channels;
+	Target *channel = channels.find(asid, fd);
+	if (channel) return *channel;
+	
+	Target target = getTargetFile(cpu, asid, fd, intern);
+	if (target.kind == TargetKind::Channel) channels.insert(asid, fd, target);
+	return target;
+}
 
-		// Get the label set for the physical address and for each label in
-		// the set, increment the number of bytes tainted with it by one.
-		taint2_query_set_ram(pAddr, labelSet);
-		for (auto label : labelSet) {
-			// Occurs if taint2_query_set_ram did not write to this element of
-			// the labelSet array.
-			if (label == (uint32_t)(-1)) continue;
+void rotateTrace() {
+	auto &trace = dependency_tracker.trace;
+	uint64_t shardSize = dependency_tracker.traceShardSize;
+	if (shardSize == 0 || trace.getBytes() < shardSize) return;
+	
+	if (!closeTrace()) {
+		std::cerr << "dependency_tracker: failed to write event trace " <<
+			"shard " << dependency_tracker.traceShards - 1 << "." << std::endl;
+	}
+	openTrace();
+}
 
-			++map[label];
+bool saveShadowStore(const std::string &file) {
+	std::ofstream ofs(file);
+	if (!ofs.is_open()) return false;
+	
+	auto &labels = dependency_tracker.labels;
+	auto &configurations = dependency_tracker.configurations;
+	
+	// Names are quoted, so quotes in them are doubled, see parseCSV()
+	auto quote = [](const std::string &value) {
+		std::string text = "\"";
+		for (char c : value) {
+			if (c == '"') text += '"';
+			text += c;
 		}
+		return text + "\"";
+	};
+	
+	// Channels do not outlive the replay, so only the shadows of files are 
+	// saved.
+	for (auto &shadow : dependency_tracker.shadows) {
+		const Target &target = shadow.first;
+		if (target.kind != TargetKind::File) continue;
+		
+		std::string name = quote(getTargetName(target));
+		shadow.second.forEach([&](uint64_t start, uint64_t end,
+				const std::vector<uint32_t> &rangeLabels) {
+			for (auto label : rangeLabels) {
+				uint32_t index = labels.getConfiguration(label);
+				if (index == NO_INDEX) continue;
+				
+				auto &configuration = *configurations[index];
+				const Target &source = configuration.sources.getTarget(
+					labels.getSource(label));
+				ofs << name << "," << start << "," << end << "," <<
+					quote(configuration.name) << "," << 
+					getKindCode(source.kind) << "," <<
+					quote(getTargetName(source)) << "\n";
+			}
+		});
 	}
 	
-	return map;
+	return ofs.good();
+}
+
+void unmapSources(target_ulong asid, target_ulong start, uint32_t length) {
+	auto it = dependency_tracker.mappings.find(asid);
+	if (it == dependency_tracker.mappings.end() || length == 0) return;
+	auto &mappings = it->second;
+	
+	mappings.erase(std::remove_if(mappings.begin(), mappings.end(),
+		[&](const SourceMapping &mapping) { 
+			return mapping.overlaps(start, length); 
+		}), mappings.end());
+	
+	if (mappings.empty()) dependency_tracker.mappings.erase(it);
+}
+
+Target unpackTarget(uint64_t packed) {
+	return Target(static_cast<TargetKind>(packed >> 32), 
+		static_cast<uint32_t>(packed));
 }
 
 bool init_plugin(void *self) {
@@ -593,9 +2334,11 @@ bool init_plugin(void *self) {
 	assert(init_osi_linux_api());
 	assert(init_taint2_api());
 
-	// The paths to the files containing the sources list and the sinks list
+	// The paths to the files containing the sources list and the sinks list,
+	// and to the file containing the list of configurations.
 	std::string sourcesFile;
 	std::string sinksFile;
+	std::string configsFile;
 
 	// Fetch arguments from PANDA
 	auto args = panda_get_args("dependency_tracker");
@@ -603,51 +2346,143 @@ bool init_plugin(void *self) {
 		"sources file name");
 	sinksFile = panda_parse_string_opt(args, "sinks", "sinks",
 		"sinks file name");
+	configsFile = panda_parse_string_opt(args, "configs", "",
+		"configurations file name (name,sources file,sinks file per line)");
+	bool discover = panda_parse_bool_opt(args, "discover",
+		"label every read target and query every written target?");
 	dependency_tracker.debug = panda_parse_bool_opt(args, "debug", 
 		"debug mode?");
 	dependency_tracker.logErrors = panda_parse_bool_opt(args, "logFail",
-		"log failed target fetches?");
+		"log the first failed target fetches of each category?");
+	dependency_tracker.errors.setSamples(panda_parse_uint32_opt(args, 
+		"errorSamples", 4, "failed target fetches logged per category"));
 	dependency_tracker.enableTaintAt = panda_parse_uint64_opt(args, "taintAt",
 		1, "enable taint at instruction number");
+	dependency_tracker.matrixFile = panda_parse_string_opt(args, "matrix", 
+		"", "flow matrix output file name");
+	dependency_tracker.matrixFormat = panda_parse_string_opt(args, 
+		"matrixFormat", "csv", "flow matrix output format (csv, bin, dot or "
+		"adj)");
+	auto &matrixFormat = dependency_tracker.matrixFormat;
+	if (matrixFormat != "csv" && matrixFormat != "bin" && 
+			matrixFormat != "dot" && matrixFormat != "adj") {
+		std::cerr << "dependency_tracker: unknown flow matrix format \"" << 
+			matrixFormat << "\"." << std::endl;
+		return false;
+	}
+	dependency_tracker.mappingBudget = panda_parse_uint32_opt(args, 
+		"mmapBudget", 16, "mapped pages checked for residency per check");
+	dependency_tracker.mappingInterval = panda_parse_uint64_opt(args, 
+		"mmapInterval", 100000, "instructions between the residency checks "
+		"of mapped pages");
+	dependency_tracker.peers.setCapacity(panda_parse_uint32_opt(args, 
+		"peerCache", 4096, "classified socket peers cached"));
+	dependency_tracker.shadowWrites = panda_parse_bool_opt(args, 
+		"shadowWrites", "record the labels of data written to every file?");
+	dependency_tracker.shadowStore = panda_parse_string_opt(args, 
+		"shadowStore", "", "file shadows to load at start and save at end");
+	dependency_tracker.statsFile = panda_parse_string_opt(args, "stats", "",
+		"memory mapped file of the live source and sink counters");
+	dependency_tracker.seriesFile = panda_parse_string_opt(args, "series", 
+		"", "time series of the source and sink counters output file name");
+	uint64_t seriesInterval = panda_parse_uint64_opt(args, "seriesInterval",
+		100000000, "guest instructions per interval of the time series");
+	uint32_t logQueue = panda_parse_uint32_opt(args, "logQueue", 4096,
+		"event log queue size in records, or 0 to log synchronously");
+	dependency_tracker.traceFile = panda_parse_string_opt(args, "trace", "",
+		"binary trace of source reads and sink writes output file name");
+	dependency_tracker.traceWrites = panda_parse_bool_opt(args, 
+		"traceWrites", "trace the labels written to every target?");
+	dependency_tracker.traceShardSize = (uint64_t)panda_parse_uint32_opt(
+		args, "traceShard", 0, "event trace shard size in MiB, or 0 for a " 
+		"single file") << 20;
+	dependency_tracker.reportFile = panda_parse_string_opt(args, "report", 
+		"", "streaming report of reads and flows output file name");
+	std::string reportFormat = panda_parse_string_opt(args, "reportFormat",
+		"jsonl", "streaming report output format (jsonl or csv)");
+	uint32_t reportQueue = panda_parse_uint32_opt(args, "reportQueue", 65536,
+		"streaming report queue size in records, or 0 to write synchronously");
 
-	// Read the sources and sinks files, parse data into targets and add to
-	// plugin structure.
-	auto sourcesPtrs = parseTargets(sourcesFile);
-	for (size_t i = 0; i < sourcesPtrs.size(); ++i) {
-		TargetSource *t = new TargetSource(std::move(sourcesPtrs[i]), i);
-		dependency_tracker.sources.push_back(std::unique_ptr<TargetSource>(t));
+	// Read the configurations. If no configurations file is specified, the
+	// sources and sinks files make up the only configuration, which also
+	// discovers targets if requested. Otherwise, discovered targets are kept
+	// in a configuration of their own.
+	if (configsFile.empty()) {
+		addConfiguration("default", sourcesFile, sinksFile, discover);
+	} else {
+		parseConfigurations(configsFile);
+		if (discover) addConfiguration("discovered", "", "", true);
 	}
-	auto sinksPtrs = parseTargets(sinksFile);
-	for (size_t i = 0; i < sinksPtrs.size(); ++i) {
-		TargetSink *t = new TargetSink(std::move(sinksPtrs[i]), i);
-		dependency_tracker.sinks.push_back(std::unique_ptr<TargetSink>(t));
+	
+	// Load the file shadows saved by a previous replay, once the 
+	// configurations whose labels they carry exist.
+	if (!dependency_tracker.shadowStore.empty()) {
+		uint64_t ranges = loadShadowStore(dependency_tracker.shadowStore);
+		std::cout << "dependency_tracker: loaded " << ranges << " shadowed " <<
+			"ranges from \"" << dependency_tracker.shadowStore << "\"." << 
+			std::endl;
+	}
+	
+	// Move the counters into the stats file, if requested, once the sources
+	// and sinks of every configuration are known.
+	if (!dependency_tracker.statsFile.empty()) openStats();
+	
+	// Open the interval series, if requested. The replay goes on without it
+	// if it cannot be created.
+	auto &seriesFile = dependency_tracker.seriesFile;
+	if (!seriesFile.empty() && !dependency_tracker.series.open(seriesFile, 
+			seriesInterval, dependency_tracker.targets)) {
+		std::cerr << "dependency_tracker: failed to create interval " <<
+			"series \"" << seriesFile << "\"." << std::endl;
 	}
 	
-	// Register the Panda Block Functions
+	// Open the event trace, if requested. The replay goes on without it if it
+	// cannot be created.
+	if (!dependency_tracker.traceFile.empty()) openTrace();
+	
+	// Open the streaming report, if requested, the same way
+	if (!dependency_tracker.reportFile.empty()) 
+		openReport(reportFormat, reportQueue);
+	
+	// Start the logging thread, after the synchronous output of the setup
+	dependency_tracker.eventLog.start(logQueue);
+	
+	// Register the Panda Block Functions, in the variant which matches the
+	// debug option
 	panda_cb pcb;
-	pcb.before_block_translate = on_before_block_translate;
+	pcb.before_block_translate = dependency_tracker.debug ? 
+		on_before_block_translate<DebugPolicy> : 
+		on_before_block_translate<QuietPolicy>;
 	panda_register_callback(self, PANDA_CB_BEFORE_BLOCK_TRANSLATE, pcb);
 	pcb.before_block_exec = on_before_block_execution;
 	panda_register_callback(self, PANDA_CB_BEFORE_BLOCK_EXEC, pcb);
 
-	// Register SysCalls2 Callback Functions
-	PPP_REG_CB("syscalls2", on_sys_socketcall_return, on_socketcall_return);
-	PPP_REG_CB("syscalls2", on_sys_pread64_return, on_pread64_return);
-	PPP_REG_CB("syscalls2", on_sys_read_return, on_read_return);
-	PPP_REG_CB("syscalls2", on_sys_pwrite64_return, on_pwrite64_return);
-	PPP_REG_CB("syscalls2", on_sys_write_return, on_write_return);
+	// Register SysCalls2 Callback Functions. The reads, writes, socket calls
+	// and kernel copies are registered in the variant which matches the debug
+	// option.
+	if (dependency_tracker.debug) registerIOCallbacks<DebugPolicy>();
+	else registerIOCallbacks<QuietPolicy>();
+	PPP_REG_CB("syscalls2", on_sys_mmap_pgoff_return, on_mmap_pgoff_return);
+	PPP_REG_CB("syscalls2", on_sys_old_mmap_return, on_old_mmap_return);
+	PPP_REG_CB("syscalls2", on_sys_mremap_return, on_mremap_return);
+	PPP_REG_CB("syscalls2", on_sys_munmap_return, on_munmap_return);
+	PPP_REG_CB("syscalls2", on_sys_close_return, on_close_return);
+	PPP_REG_CB("syscalls2", on_sys_execve_enter, on_execve_enter);
+	PPP_REG_CB("syscalls2", on_sys_execve_return, on_execve_return);
+	PPP_REG_CB("syscalls2", on_sys_exit_group_enter, on_exit_group_enter);
 	
 	// Print debug info, if available
 	if (dependency_tracker.debug) {
 		uint64_t taintAt = dependency_tracker.enableTaintAt;
 
 		std::cout << "dependency_tracker: debug mode enabled. " << std::endl;
-		std::cout << "dependency_tracker: found " << sourcesPtrs.size() << 
-			" sources." << std::endl;
-		std::cout << "dependency_tracker: found " << sinksPtrs.size() << 
-			" sinks." << std::endl;
+		std::cout << "dependency_tracker: found " << 
+			dependency_tracker.configurations.size() << " configurations." <<
+			std::endl;
 		std::cout << "dependency_tracker: log errors? " << 
 			(dependency_tracker.logErrors ? "yes." : "no.") << std::endl;
+		std::cout << "dependency_tracker: discover targets? " << 
+			(dependency_tracker.discover ? "yes." : "no.") << std::endl;
 		std::cout << "dependency_tracker: enabling taint2 at instruction : " <<
 			((taintAt == (uint64_t)(-1)) ? "never" : std::to_string(taintAt)) 
 			<< "." << std::endl;
@@ -661,13 +2496,67 @@ bool init_plugin(void *self) {
 #endif
 }
 
-void uninit_plugin(void *self) {
+void printChannels() {
+	auto &channels = dependency_tracker.channelTraffic;
+	
+	// Foreach channel, output the name of the channel and how much data went
+	// through it in either direction.
+	for (uint32_t channel = 0; channel < channels.size(); ++channel) {
+		std::cout << "Channel: \"" << 
+			getTargetName(channels.getTarget(channel)) << "\": read " << 
+			channels.getBytesRead(channel) << " bytes in " << 
+			channels.getReads(channel) << " reads, wrote " << 
+			channels.getBytesWritten(channel) << " bytes in " << 
+			channels.getWrites(channel) << " writes" << std::endl;
+	}
+}
+
+void printDescriptors() {
+	const std::pair<const char*, const DescriptorTable<Target>*> tables[] = {
+		{ "networks", &dependency_tracker.networks },
+		{ "listeners", &dependency_tracker.listeners },
+		{ "channels", &dependency_tracker.channels }
+	};
+	
+	// Foreach table, output how many entries it still holds, and how many
+	// stale entries were dropped instead of being resolved.
+	for (auto &table : tables) {
+		std::cout << "Descriptors: " << table.first << ": " << 
+			table.second->size() << " entries, " << 
+			table.second->getStaleHits() << " stale hits avoided, " << 
+			table.second->getSweptEntries() << " stale entries swept" << 
+			std::endl;
+	}
+}
+
+void printLog() {
+	auto &log = dependency_tracker.eventLog;
+	std::cout << "Event Log: wrote " << log.getWritten() << " records in " << 
+		log.getBatches() << " batches, dropped " << log.getDropped() << 
+		" records, waited for room for " << log.getWaits() << " records, " <<
+		"queued at most " << log.getHighWater() << "/" << log.getCapacity() <<
+		" records" << std::endl;
+}
+
+void printReport(const Configuration &configuration) {
+	auto &sources = configuration.sources;
+	auto &sinks = configuration.sinks;
+	
 	// Foreach target source, output the name of the target and how many of its
 	// bytes were tainted.
-	for (auto &source : dependency_tracker.sources) {
-		std::cout << "Source: \"" << source->getTarget() << "\": labeled " <<
-			source->getLabeledBytes() << "/" << source->getTotalBytes() <<
-			std::endl;
+	for (uint32_t source = 0; source < sources.size(); ++source) {
+		std::cout << "Source: \"" << getTargetName(sources.getTarget(source)) 
+			<< "\": labeled " << sources.getLabeledBytes(source) << "/" << 
+			sources.getTotalBytes(source);
+		if (sources.getMappedBytes(source) > 0) {
+			std::cout << " (" << sources.getMappedBytes(source) << 
+				" bytes labeled through mmap)";
+		}
+		if (sources.getVectoredReads(source) > 0) {
+			std::cout << " (" << sources.getVectoredReads(source) << "/" << 
+				sources.getTotalReads(source) << " reads vectored)";
+		}
+		std::cout << std::endl;
 	}
 	
 	std::cout << std::endl;
@@ -675,32 +2564,150 @@ void uninit_plugin(void *self) {
 	// Foreach target sink, output the name of the target, and for each source
 	// which wrote to that sink, output the name of the source and the number 
 	// of tainted bytes written.
-	for (auto &sink : dependency_tracker.sinks) {
+	for (uint32_t sink = 0; sink < sinks.size(); ++sink) {
 		// Skip this sink if no tainted bytes were written to it.
-		if (sink->getTotalTaintBytes() < 1) continue;
+		if (sinks.getTotalTaintBytes(sink) < 1) continue;
 		
-		std::cout << "Sink: \"" << sink->getTarget() << "\":" << std::endl;
-		std::cout << "\t" << "Total Writes: " << sink->getTotalWrites() <<
+		std::cout << "Sink: \"" << getTargetName(sinks.getTarget(sink)) << 
+			"\":" << std::endl;
+		std::cout << "\t" << "Total Writes: " << sinks.getTotalWrites(sink) <<
 			std::endl;
+		if (sinks.getVectoredWrites(sink) > 0) {
+			std::cout << "\t" << "Vectored Writes: " << 
+				sinks.getVectoredWrites(sink) << std::endl;
+		}
 		std::cout << "\t" << "Total Bytes Written: " << 
-			sink->getTotalBytes() << std::endl;
-
-		auto &labeledBytes = sink->getLabeledBytes();
-		for (auto &it : labeledBytes) {
-			// Get the source which wrote to this sink, skip if nothing from 
-			// that source was written to the sink.
-			uint32_t source = it.first;
-			uint32_t numTainted = it.second;
-			if (numTainted <= 0) continue;
-			
-			// Get the source target and output how many of its tainted bytes
-			// ended up in this sink.
-			TargetSource &targetSource = *dependency_tracker.sources[source];
-			const Target &target = targetSource.getTarget();
+			sinks.getTotalBytes(sink) << std::endl;
+
+		// For each source which wrote to this sink, get the source target and
+		// output how many of its tainted bytes ended up in this sink.
+		configuration.flows.forEachInSink(sink, [&](uint32_t source,
+				const FlowCell &flow) {
+			const Target &target = sources.getTarget(source);
 			std::cout << "\t";
-			std::cout << "Source: " << "\"" << target << "\": " << 
-				numTainted << "/" << sink->getTotalBytes() << 
-				" tainted bytes written to this." << std::endl;
+			std::cout << "Source: " << "\"" << getTargetName(target) << 
+				"\": " << flow.taintedBytes << "/" << 
+				sinks.getTotalBytes(sink) << " tainted bytes written to this." 
+				<< std::endl;
+		});
+	}
+}
+
+void printSeries() {
+	auto &series = dependency_tracker.series;
+	std::cout << "Interval Series: wrote " << series.getRows() << 
+		" rows in " << series.getSnapshots() << " snapshots" << std::endl;
+}
+
+void printTrace() {
+	std::cout << "Event Trace: wrote " << dependency_tracker.traceRecords << 
+		" records in " << dependency_tracker.traceBytes << " bytes";
+	if (dependency_tracker.traceShardSize > 0) 
+		std::cout << " to " << dependency_tracker.traceShards << " shards";
+	std::cout << std::endl;
+}
+
+void uninit_plugin(void *self) {
+	auto &configurations = dependency_tracker.configurations;
+	
+	// Drain the event log, so that its records come before the reports
+	dependency_tracker.eventLog.stop();
+	
+	// Output the report of each configuration, and export its flow matrix if
+	// an output file was specified. The reports are only titled if there is
+	// more than one of them.
+	for (auto &configuration : configurations) {
+		if (configurations.size() > 1) {
+			std::cout << "Configuration: \"" << configuration->name << "\"" <<
+				std::endl;
+		}
+		
+		printReport(*configuration);
+		if (!dependency_tracker.matrixFile.empty()) 
+			exportFlowMatrix(*configuration);
+		
+		if (configurations.size() > 1) std::cout << std::endl;
+	}
+	
+	// Output the traffic of the channels, which is the same in every 
+	// configuration.
+	if (dependency_tracker.channelTraffic.size() > 0) {
+		printChannels();
+		std::cout << std::endl;
+	}
+	
+	// Output the usage of the file descriptor tables, if any was used
+	auto used = [](const DescriptorTable<Target> &table) {
+		return !table.empty() || table.getStaleHits() > 0 || 
+			table.getSweptEntries() > 0;
+	};
+	if (used(dependency_tracker.networks) || 
+		used(dependency_tracker.listeners) ||
+		used(dependency_tracker.channels)) {
+		printDescriptors();
+		std::cout << std::endl;
+	}
+	
+	// Close the event trace, once every record is in
+	if (dependency_tracker.trace.isOpen() && !closeTrace()) {
+		std::cerr << "dependency_tracker: failed to write event trace." << 
+			std::endl;
+	}
+	if (dependency_tracker.traceShards > 0) {
+		printTrace();
+		std::cout << std::endl;
+	}
+	
+	// Close the streaming report, with the totals and the summary. Records
+	// are only dropped if the queue was too small to keep up.
+	auto &reportFile = dependency_tracker.reportFile;
+	if (dependency_tracker.reportStream.is_open()) {
+		if (!closeReport()) {
+			std::cerr << "dependency_tracker: failed to write report to \"" <<
+				reportFile << "\"." << std::endl;
+		}
+		if (dependency_tracker.reportLog.getDropped() > 0) {
+			std::cerr << "dependency_tracker: dropped " << 
+				dependency_tracker.reportLog.getDropped() << " records of " <<
+				"report \"" << reportFile << "\"." << std::endl;
+		}
+	}
+	
+	// Close the interval series, with the interval which the replay ended in
+	auto &series = dependency_tracker.series;
+	if (series.isOpen()) {
+		if (!series.close(rr_get_guest_instr_count(), configurations)) {
+			std::cerr << "dependency_tracker: failed to write interval " <<
+				"series \"" << dependency_tracker.seriesFile << "\"." << 
+				std::endl;
 		}
+		printSeries();
+		std::cout << std::endl;
+	}
+	
+	// Output the tally of the errors, of which only the first were logged
+	if (dependency_tracker.errors.getTotal() > 0) {
+		dependency_tracker.errors.print(std::cout, "dependency_tracker");
+		std::cout << std::endl;
+	}
+	
+	// Output how the event log kept up with the replay
+	if (dependency_tracker.eventLog.getCapacity() > 0) {
+		printLog();
+		std::cout << std::endl;
+	}
+	
+	// Save the file shadows, so that the next replay can resume from them
+	auto &shadowStore = dependency_tracker.shadowStore;
+	if (!shadowStore.empty() && !saveShadowStore(shadowStore)) {
+		std::cerr << "dependency_tracker: failed to save file shadows to \"" <<
+			shadowStore << "\"." << std::endl;
+	}
+	
+	// Flush the stats file last, since the counters live in it
+	auto &stats = dependency_tracker.stats;
+	if (stats.isOpen() && !stats.close()) {
+		std::cerr << "dependency_tracker: failed to write stats file \"" << 
+			dependency_tracker.statsFile << "\"." << std::endl;
 	}
 }
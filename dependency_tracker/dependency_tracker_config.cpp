@@ -0,0 +1,24 @@
+#include "dependency_tracker_config.h"
+
+/***************************** LABEL  ALLOCATOR *****************************/
+uint32_t LabelAllocator::allocate(uint32_t configuration, uint32_t source) {
+	this->configurations.push_back(configuration);
+	this->sources.push_back(source);
+
+	return this->configurations.size() - 1;
+}
+
+uint32_t LabelAllocator::getConfiguration(uint32_t label) const {
+	if (label >= this->configurations.size()) return NO_INDEX;
+	return this->configurations[label];
+}
+
+uint32_t LabelAllocator::getSource(uint32_t label) const {
+	if (label >= this->sources.size()) return NO_INDEX;
+	return this->sources[label];
+}
+
+size_t LabelAllocator::size() const {
+	return this->configurations.size();
+}
+/***************************** LABEL  ALLOCATOR *****************************/
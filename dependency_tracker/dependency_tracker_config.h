@@ -0,0 +1,90 @@
+#ifndef DEPENDENCY_TRACKER_CONFIG
+#define DEPENDENCY_TRACKER_CONFIG
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "dependency_tracker_flows.h"
+#include "dependency_tracker_stats.h"
+#include "dependency_tracker_targets.h"
+
+/// <summary>
+/// Class which partitions the taint label space among configurations. Labels
+/// are handed out sequentially, on demand, and each label is owned by exactly
+/// one source of exactly one configuration.
+/// </summary>
+class LabelAllocator {
+public:
+	/// <summary>
+	/// Creates a new Label Allocator, with no labels allocated.
+	/// </summary>
+	LabelAllocator() = default;
+
+	/// <summary>
+	/// Allocates the next free label to the specified source of the specified
+	/// configuration.
+	/// </summary>
+	/// <param name="configuration">
+	/// The index of the configuration which owns the label.
+	/// </param>
+	/// <param name="source">
+	/// The index of the source, in the configuration, which owns the label.
+	/// </param>
+	/// <returns>
+	/// The label.
+	/// </returns>
+	uint32_t allocate(uint32_t configuration, uint32_t source);
+
+	/// <summary>
+	/// Returns the index of the configuration which owns the specified label.
+	/// </summary>
+	/// <param name="label">
+	/// The label.
+	/// </param>
+	/// <returns>
+	/// The index of the configuration, or <see cref="NO_INDEX"/> if the label
+	/// was never allocated.
+	/// </returns>
+	uint32_t getConfiguration(uint32_t label) const;
+
+	/// <summary>
+	/// Returns the index of the source which owns the specified label, in its
+	/// configuration.
+	/// </summary>
+	/// <param name="label">
+	/// The label.
+	/// </param>
+	/// <returns>
+	/// The index of the source, or <see cref="NO_INDEX"/> if the label was
+	/// never allocated.
+	/// </returns>
+	uint32_t getSource(uint32_t label) const;
+
+	/// <summary>
+	/// Returns the number of labels allocated.
+	/// </summary>
+	/// <returns>
+	/// The number of labels.
+	/// </returns>
+	size_t size() const;
+protected:
+	std::vector<uint32_t> configurations;      // { Label -> Configuration }
+	std::vector<uint32_t> sources;             // { Label -> Source }
+};
+
+/// <summary>
+/// Structure which represents a single named set of sources and sinks which
+/// is evaluated during the replay, together with its results.
+/// </summary>
+struct Configuration {
+	std::string name;                          // Name of the Configuration
+	uint32_t index = 0;                        // Index in Configurations
+	bool discover = false;                     // Discover sources/sinks?
+
+	TargetSources sources;                     // Source Targets
+	TargetSinks sinks;                         // Sink Targets
+	FlowMatrix flows;                          // Source x Sink Flows
+};
+
+#endif
@@ -1,15 +1,21 @@
 #ifndef DEPENDENCY_TRACKER_H
 #define DEPENDENCY_TRACKER_H
 
+#include <fstream>
 #include <map>
 #include <memory>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "panda/plugin.h"
 #include "panda/plugin_plugin.h"
 
+#include "../dependency_common/async_log.h"
+#include "../dependency_common/descriptor_table.h"
+#include "../dependency_common/error_counter.h"
+
 #include "taint2/taint2.h"
 
 extern "C" {
@@ -22,271 +28,1541 @@ extern "C" {
 	#include "taint2/taint2_ext.h"
 }
 
+#include "dependency_tracker_config.h"
+#include "dependency_tracker_flows.h"
+#include "dependency_tracker_mappings.h"
+#include "dependency_tracker_memory.h"
+#include "dependency_tracker_report.h"
+#include "dependency_tracker_series.h"
+#include "dependency_tracker_shadow.h"
+#include "dependency_tracker_sockets.h"
+#include "dependency_tracker_stats.h"
 #include "dependency_tracker_targets.h"
+#include "dependency_tracker_trace.h"
+
+// Position of a read or a write which happened at the position of the file
+const uint64_t CURRENT_POSITION = UINT64_MAX;
+
+// Number of low bits of the instruction count of a flow record of the report,
+// above which the index of the configuration of the flow is packed
+const uint32_t FLOW_INSTRUCTION_BITS = 48;
+
+/// <summary>
+/// Structure which describes a read from or a write to a target by userland.
+/// </summary>
+struct TargetIO {
+	uint32_t fd;                                         // File Descriptor
+	uint64_t position;                                   // Position of Data
+	const GuestIOVec *segments;                          // Buffer Segments
+	uint32_t count;                                      // # of Segments
+	uint32_t length;                                     // # of Bytes Moved
+	const char *event;                                   // Name of Event
+	bool vectored;                                       // Vectored Call?
+};
+
+/// <summary>
+/// Logging policy of the callbacks registered in debug mode, which log every
+/// target seen. The reads, writes and socket calls are instantiated for each
+/// policy, and only the variant which matches the debug option is 
+/// registered, so that the quiet variant carries no logging of the targets
+/// seen. Only that logging depends on the policy: the failures are still
+/// counted, and printed if the logFail option is set, by both variants.
+/// </summary>
+struct DebugPolicy {
+	static constexpr bool debug = true;                  // Log Targets Seen?
+};
+
+/// <summary>
+/// Logging policy of the callbacks registered outside of debug mode, which 
+/// only log the reads of sources and the writes to sinks. See 
+/// <see cref="DebugPolicy"/>.
+/// </summary>
+struct QuietPolicy {
+	static constexpr bool debug = false;                 // Log Targets Seen?
+};
+
+/// <summary>
+/// Enumeration of the types of the records of the event log. The target of a
+/// record is packed in its first value, see <see cref="packTarget"/>, and the
+/// rest of its values depend on its type.
+/// </summary>
+enum class LogType : uint16_t {
+	Seen,                                      // Target was Seen
+	Copy,                                      // Copy, to Target in Value 1
+	SourceRead,                                // Tainted, Length, Label
+	SinkWrite,                                 // Tainted, Length, Label
+	ShadowRead,                                // Reapplied Bytes
+	SourceMapping,                             // Labeled Pages, Pages
+	SourceConnection,                          // Source was Connected
+	SinkConnection,                            // Sink was Connected
+	Configuration,                             // Index, Sources, Sinks
+	TaintEnabled                               // Instruction
+};
+
+/// <summary>
+/// Appends the line of text of the specified record of the event log to the
+/// specified string. This is called from the logging thread.
+/// </summary>
+/// <param name="record">
+/// The record to be formatted.
+/// </param>
+/// <param name="text">
+/// The string to which the text is appended.
+/// </param>
+void formatLogRecord(const LogRecord &record, std::string &text);
 
-typedef std::pair<target_ulong, uint32_t> FD_ASID_Pair;
+/// <summary>
+/// Enumeration of the types of the records of the streaming report. The
+/// records share the log records of the event log, and their values depend
+/// on their type. The configuration index of a read is packed with its 32
+/// bit length, the index in the upper half, and the configuration index of a
+/// flow is packed with its instruction count, above the low
+/// <see cref="FLOW_INSTRUCTION_BITS"/> bits.
+/// </summary>
+enum class ReportType : uint16_t {
+	Read,                                      // Target, I#, Config|Len, Taint
+	Flow,                                      // Sink, Source, Config|I#, Taint
+	Source,                                    // Target, Config, Bytes, Labeled
+	Sink,                                      // Target, Config, Bytes, Tainted
+	Summary                                    // I#, Records, Dropped
+};
+
+/// <summary>
+/// Appends the line of the specified record of the streaming report to the
+/// specified string, in the format of the report. This is called from the
+/// thread of the report.
+/// </summary>
+/// <param name="record">
+/// The record to be formatted.
+/// </param>
+/// <param name="text">
+/// The string to which the line is appended.
+/// </param>
+void formatReportRecord(const LogRecord &record, std::string &text);
 
 struct Dependency_Tracker {
 	void *plugin_ptr = nullptr;                          // The plugin pointer
 	uint64_t enableTaintAt = 1;                          // I# to enable taint
 	bool debug = false;                                  // Print debug info?
 	bool logErrors = false;                              // Print errors?
+	ErrorCounter errors;                                 // Errors by Category
+	bool discover = false;                               // Any discovering?
+	uint32_t mappingBudget = 16;                         // Pages per Check
+	uint64_t mappingInterval = 100000;                   // I# per Check
+	uint64_t nextMappingCheck = 0;                       // I# of Next Check
+	target_ulong lastFault = 0;                          // Last CR2 Seen
+	bool shadowWrites = false;                           // Shadow all files?
 	
-	std::vector<std::unique_ptr<TargetSource>> sources;  // Source Targets
-	std::vector<std::unique_ptr<TargetSink>> sinks;      // Sink Targets
+	TargetTable targets;                                 // Interned Targets
+	LabelAllocator labels;                               // { Label -> Source }
+	
+	// The configurations evaluated during the replay, in order of creation
+	std::vector<std::unique_ptr<Configuration>> configurations;
+	
+	LabelHistogram histogram;                            // Query Scratch Space
+	std::vector<uint32_t> foundSinks;                    // { Config -> Sink # }
+	std::vector<uint32_t> labelSet;                      // Label Scratch Space
+	std::vector<uint32_t> byteLabelSet;                  // Byte Scratch Space
+	std::vector<GuestIOVec> iovecs;                      // iovec Scratch Space
+	PageRuns runs;                                       // Page Scratch Space
+	std::vector<uint32_t> copyLabels;                    // Copy Scratch Space
+	std::vector<ShadowSpan> spans;                       // Span Scratch Space
+	
+	// The labels occupying the contents of the files into which labeled data
+	// was written or copied, and of every stream which was used, see 
+	// getShadow()
+	std::unordered_map<Target, LabelShadow, TargetHash> shadows;
+	std::string shadowStore;                             // Shadow Store File
+	
+	std::string statsFile;                               // Stats File Name
+	StatsFile stats;                                     // Live Statistics
+	std::string seriesFile;                              // Series Output
+	IntervalSeries series;                               // Interval Series
+	
+	std::string matrixFile;                              // Flow Matrix Output
+	std::string matrixFormat;                            // csv/bin/dot/adj
+	EventTrace trace;                                    // Binary Event Trace
+	std::string traceFile;                               // Event Trace Output
+	bool traceWrites = false;                            // Trace all writes?
+	uint64_t traceShardSize = 0;                         // Bytes per Shard
+	uint32_t traceShards = 0;                            // # of Shards Opened
+	uint64_t traceRecords = 0;                           // # of Closed Records
+	uint64_t traceBytes = 0;                             // # of Closed Bytes
 	
 	std::map<target_ulong, OsiProc> processes;           // { ASID -> Process }
-	std::map<FD_ASID_Pair, TargetNetwork> networks;      // { ASID, FD -> Net }
+	std::map<target_ulong, target_ulong> execs;          // { PID -> Old ASID }
+	DescriptorTable<Target> networks;                    // { ASID, FD -> Net }
+	DescriptorTable<Target> listeners;                   // { ASID, FD -> *::P }
+	DescriptorTable<Target> channels;                    // { ASID, FD -> Chan }
+	TargetChannels channelTraffic;                       // Channel Statistics
+	PeerCache peers;                                     // Classified Peers
+	
+	// The peer of each connected UNIX socket, whose shadow holds the data 
+	// read from the socket, and the path which each UNIX socket is bound to
+	std::unordered_map<Target, Target, TargetHash> channelPeers;
+	std::unordered_map<Target, std::string, TargetHash> boundPaths;
+	std::map<std::string, PendingPeers> pendingPeers;    // { Path -> Ends }
+	
+	// The source mappings of each process with pages yet to be labeled
+	std::map<target_ulong, std::vector<SourceMapping>> mappings;
+	
+	AsyncLog eventLog{formatLogRecord};                  // Event Log
 	
+	std::string reportFile;                              // Report Output
+	std::ofstream reportStream;                          // Report Stream
+	ReportEncoder reportEncoder;                         // Report Format
+	AsyncLog reportLog{formatReportRecord};              // Streaming Report
 };
 
 Dependency_Tracker dependency_tracker;                   // Plugin Reference
 
 /// <summary>
-/// Returns a vector of size <paramref="size"/> containing the values of T read 
-/// from the virtual memory address <paramref="addr"/>. This method assumes 
-/// that the values in memory are adjacent to each other (in an array).
+/// Adds a new configuration with the specified name, whose sources and sinks
+/// are parsed from the specified files. A label is allocated to each of the
+/// sources of the configuration.
+/// </summary>
+/// <param name="name">
+/// The name of the configuration, which must be unique.
+/// </param>
+/// <param name="sourcesFile">
+/// The name of the CSV file from which to parse the sources.
+/// </param>
+/// <param name="sinksFile">
+/// The name of the CSV file from which to parse the sinks.
+/// </param>
+/// <param name="discover">
+/// Whether the configuration discovers its sources and sinks, by labeling
+/// every target read from and querying every target written to.
+/// </param>
+/// <returns>
+/// The index of the configuration, or <see cref="NO_INDEX"/> if a 
+/// configuration with the same name already exists, or if there are too many
+/// configurations for their indices to be packed into the report.
+/// </returns>
+uint32_t addConfiguration(const std::string &name, 
+		const std::string &sourcesFile, const std::string &sinksFile,
+		bool discover);
+
+/// <summary>
+/// Reapplies the labels which the shadow of the specified target holds for
+/// the data read from it, if the target is shadowed. The data of files is 
+/// looked up at its position, while the data of pipes is consumed from their 
+/// stream.
 /// </summary>
-/// <typeparam name="T">
-/// The type of values to be read from the memory address.
-/// </typeparam>
 /// <param name="cpu">
 /// The CPU State pointer.
 /// </param>
-/// <param name="addr">
-/// The virtual memory address to the start of the T values.
+/// <param name="target">
+/// The target which was read from.
+/// </param>
+/// <param name="io">
+/// The read.
+/// </param>
+void applyShadow(CPUState *cpu, const Target &target, const TargetIO &io);
+
+/// <summary>
+/// Classifies the specified peer of a socket as a network target, once per 
+/// peer and listening target. The peer itself is preferred, if it is a source
+/// or sink in any configuration. Otherwise, the peer falls under the listening
+/// target of the socket, if it has one. If targets are not being discovered, 
+/// only network targets which were already interned are returned.
+/// </summary>
+/// <param name="listener">
+/// The listening target of the socket, or an invalid target if it has none.
 /// </param>
-/// <param name="size">
-/// The number of arguments to be read in. This is equivalent to the number of
-/// elements returned in the vector.
+/// <param name="peer">
+/// The address of the peer.
 /// </param>
 /// <returns>
-/// The vector of size <paramref="size"/> containing the values fetched from
-/// <paramref="addr"/>.
+/// The target, which is invalid if the peer is not a target.
+/// </returns>
+Target classifyPeer(const Target &listener, const SocketAddress &peer);
+
+/// <summary>
+/// Writes the totals of the sources and sinks of each configuration and the
+/// summary record to the streaming report, once its queue is drained, and
+/// closes it.
+/// </summary>
+/// <returns>
+/// True if the report was written successfully, false otherwise.
+/// </returns>
+bool closeReport();
+
+/// <summary>
+/// Closes the event trace, writing the names of the targets and the owners of
+/// the labels which its records reference, and adds its records and bytes to
+/// the totals of the trace.
+/// </summary>
+/// <returns>
+/// True if the trace was written successfully, false otherwise.
 /// </returns>
-template<typename T>
-std::vector<T> getMemoryValues(CPUState *cpu, uint32_t addr, uint32_t size);
+bool closeTrace();
 
 /// <summary>
-/// Returns a TargetFile with the file name corresponding to the specified file
-/// descriptor and ASID. If no such file name is found, the TargetFile returned
-/// is invalid.
+/// Handles a copy between two file descriptors which is done inside the guest
+/// kernel (sendfile, splice, tee, copy_file_range). Both file descriptors are
+/// resolved, the offsets of the copied ranges are determined and the copy is
+/// modelled by <see cref="copyTargetContents"/>. The number of bytes copied is
+/// taken from the EAX register.
 /// </summary>
+/// <typeparam name="Policy">
+/// The logging policy of the calling callback, see <see cref="DebugPolicy"/>.
+/// </typeparam>
 /// <param name="cpu">
 /// The CPU State pointer.
 /// </param>
-/// <param name="asid">
-/// The ASID of the process which owns the file referenced by the file
-/// descriptor.
+/// <param name="inFd">
+/// The file descriptor from which the data was copied.
 /// </param>
-/// <param name="fd">
-/// The file descriptor for which the file name is to be fetched.
+/// <param name="inOffsetPtr">
+/// The virtual memory address of the input offset, or zero if the position of
+/// the input file was used.
+/// </param>
+/// <param name="outFd">
+/// The file descriptor to which the data was copied.
+/// </param>
+/// <param name="outOffsetPtr">
+/// The virtual memory address of the output offset, or zero if the position
+/// of the output file was used.
+/// </param>
+/// <param name="wideOffsets">
+/// True if the offsets are 64 bits wide (loff_t), false if they are 32 bits 
+/// wide (off_t).
+/// </param>
+/// <param name="event">
+/// The name of the system call, used for logging.
+/// </param>
+/// <param name="consume">
+/// Whether the data is consumed from the input, if it is a pipe.
+/// </param>
+template<typename Policy>
+void copyFileDescriptors(CPUState *cpu, int32_t inFd, uint32_t inOffsetPtr,
+		int32_t outFd, uint32_t outOffsetPtr, bool wideOffsets,
+		const char *event, bool consume);
+
+/// <summary>
+/// Models a copy of data between two targets inside the guest kernel, where
+/// taint2 cannot see it. The copied data carries the labels of the input, if
+/// it is a source, and the labels shadowing the copied range of the input. 
+/// These labels are recorded in the shadow of the output, unless it is a 
+/// network, and credited to the output in each configuration in which it is
+/// a sink. All of this is done with range arithmetic on the shadows.
+/// </summary>
+/// <param name="in">
+/// The target from which the data was copied.
+/// </param>
+/// <param name="inOffset">
+/// The offset of the copied range in the input. Ignored for pipes.
+/// </param>
+/// <param name="out">
+/// The target to which the data was copied.
+/// </param>
+/// <param name="outOffset">
+/// The offset of the copied range in the output. Ignored for pipes.
+/// </param>
+/// <param name="length">
+/// The number of bytes copied.
+/// </param>
+/// <param name="event">
+/// The name of the system call, used for logging.
+/// </param>
+/// <param name="consume">
+/// Whether the data is consumed from the input, if it is a pipe.
+/// </param>
+void copyTargetContents(const Target &in, uint64_t inOffset, 
+		const Target &out, uint64_t outOffset, uint32_t length, 
+		const char *event, bool consume);
+
+/// <summary>
+/// Credits the sources found in a buffer written to the specified sink of the
+/// specified configuration. Only the labels owned by the configuration are
+/// credited. The flow from each source to the sink is added to the flow 
+/// matrix of the configuration, and the statistics of the sink are updated.
+/// </summary>
+/// <param name="configuration">
+/// The configuration to which the sink belongs.
+/// </param>
+/// <param name="sink">
+/// The index of the sink to which the buffer was written.
+/// </param>
+/// <param name="length">
+/// The length of the written buffer, in bytes.
+/// </param>
+/// <param name="histogram">
+/// The histogram of the labels found in the buffer, as filled in by 
+/// <see cref="queryBufferContents"/>.
+/// </param>
+/// <param name="event">
+/// The name of the event which wrote to the sink, used for logging.
+/// </param>
+/// <param name="vectored">
+/// Whether the buffer was written with a vectored write.
 /// </param>
 /// <returns>
-/// The TargetFile containing the file name. If the file name could not be
-/// resolved, the TargetFile returned is invalid.
+/// The total number of tainted bytes credited to the sink.
 /// </returns>
-TargetFile getTargetFile(CPUState *cpu, target_ulong asid, uint32_t fd);
+uint64_t creditSink(Configuration &configuration, uint32_t sink, 
+		uint32_t length, const LabelHistogram &histogram, const char *event,
+		bool vectored);
 
 /// <summary>
-/// Returns a TargetNetwork with the IP address and port corresponding to the
-/// specified file descriptor and ASID. If no such network target is found, the
-/// TargetNetwork returned is invalid.
+/// Counts data which was read from or written to the specified target, if it
+/// is a channel.
 /// </summary>
-/// <param name="asid">
-/// The ASID of the process which owns the network target referenced by the
-/// socket file descriptor.
+/// <param name="target">
+/// The target which was read from or written to.
 /// </param>
-/// <param name="fd">
-/// The file descriptor for which the network target is to be fetched.
+/// <param name="length">
+/// The number of bytes read or written.
 /// </param>
-TargetNetwork getTargetNetwork(target_ulong asid, uint32_t fd);
+/// <param name="write">
+/// True if the data was written to the target, false if it was read.
+/// </param>
+void countChannel(const Target &target, uint32_t length, bool write);
 
 /// <summary>
-/// Gets the sink associated with the specified <param ref="target"/>.
+/// Counts an error of the specified category, and checks if its message is
+/// to be printed, which is only the case for the first errors of each 
+/// category, and only if errors are logged.
 /// </summary>
-/// <param name="target">
-/// The target for which the sink target is to be fetched.
+/// <param name="category">
+/// The category of the error.
 /// </param>
 /// <returns>
-/// The reference to the target sink.
+/// True if the message of the error is to be printed, false otherwise.
 /// </returns>
-/// <exception cref="std::invalid_argument">
-/// Thrown if no sink target is associated with the specified target.
-/// </exception>
-TargetSink& getTargetSink(const Target &target); 
+bool countError(ErrorCategory category);
 
 /// <summary>
-/// Gets the source associated with the specified <param ref="target"/>.
+/// Credits the labels found in a buffer to the sinks found by the last call
+/// to <see cref="findSinks"/>, in each configuration which has one.
 /// </summary>
-/// <param name="target">
-/// The target for which the source target is to be fetched.
+/// <param name="length">
+/// The length of the written buffer, in bytes.
+/// </param>
+/// <param name="histogram">
+/// The histogram of the labels found in the buffer.
+/// </param>
+/// <param name="event">
+/// The name of the event which wrote to the sinks, used for logging.
+/// </param>
+/// <param name="vectored">
+/// Whether the buffer was written with a vectored write.
+/// </param>
+void creditSinks(uint32_t length, const LabelHistogram &histogram,
+		const char *event, bool vectored);
+
+/// <summary>
+/// Decodes the message of a sendmsg or recvmsg socket call. The iovec array
+/// of the message is read into the plugin's iovecs, and the network target of
+/// the message is returned. The target is the network connected to the 
+/// socket, if there is one, or the address of the message otherwise.
+/// </summary>
+/// <typeparam name="Policy">
+/// The logging policy of the calling callback, see <see cref="DebugPolicy"/>.
+/// </typeparam>
+/// <param name="cpu">
+/// The CPU State pointer.
+/// </param>
+/// <param name="args">
+/// The virtual memory address to the start of the arguments for the 
+/// sendmsg() or recvmsg() system call.
+/// </param>
+/// <param name="event">
+/// The name of the socket call, used for logging.
+/// </param>
+/// <param name="sockfd">
+/// The file descriptor of the socket, which is set if the arguments could be
+/// read.
+/// </param>
+/// <returns>
+/// The network target. If the message could not be decoded or its target is
+/// unknown, the target returned is invalid.
+/// </returns>
+template<typename Policy>
+Target decodeMessage(CPUState *cpu, uint32_t args, const char *event,
+		uint32_t &sockfd);
+
+/// <summary>
+/// Exports the flow matrix of the specified configuration to the file 
+/// specified by the "matrix" argument, in the format specified by the 
+/// "matrixFormat" argument: "csv", "bin", or the flow graph with the totals
+/// of the sources and sinks in GraphViz "dot" or in "adj" adjacency list
+/// format. If there is more than one configuration, the name of the
+/// configuration is appended to the file name.
+/// </summary>
+/// <param name="configuration">
+/// The configuration whose flow matrix is to be exported.
 /// </param>
 /// <returns>
-/// The reference to the target source.
+/// True if the matrix was exported successfully, false otherwise.
 /// </returns>
-/// <exception cref="std::invalid_argument">
-/// Thrown if no source target is associated with the specified target.
-/// </exception>
-TargetSource& getTargetSource(const Target &target); 
+bool exportFlowMatrix(const Configuration &configuration);
 
 /// <summary>
-/// Checks if the specified <paramref="target"/> is a sink target.
+/// Finds the index of the sink associated with the specified target in each
+/// configuration, and stores them in the plugin's found sinks scratch space.
 /// </summary>
 /// <param name="target">
-/// The target to be checked.
+/// The target for which the sinks are to be found.
 /// </param>
 /// <returns>
-/// True if <paramref="target"/> is a sink, false otherwise.
+/// True if the target is a sink in any configuration, false otherwise.
 /// </returns>
-bool isSink(const Target &target);
+bool findSinks(const Target &target);
 
 /// <summary>
-/// Checks if the specified <paramref="target"/> is a source target.
+/// Returns the target whose shadow holds the data read from the specified 
+/// target. The two ends of a connected UNIX socket are separate channels, 
+/// and the data read from one end was written to the other end, its peer.
+/// Every other target holds the data read from it itself.
 /// </summary>
 /// <param name="target">
-/// The target to be checked.
+/// The target which is read from.
 /// </param>
 /// <returns>
-/// True if <paramref="target"/> is a source, false otherwise.
+/// The peer of the target if it is a connected UNIX socket, or the target.
 /// </returns>
-bool isSource(const Target &target);
+Target getChannelPeer(const Target &target);
 
 /// <summary>
-/// Taints the contents of the buffer at the specified virtual address and of 
-/// the specified length. This function does nothing if taint2 is not currently
-/// enabled.
+/// Finds the offset of a range of the specified number of bytes which was
+/// just copied from or to the specified target inside the guest kernel.
 /// </summary>
 /// <param name="cpu">
 /// The CPU State pointer.
 /// </param>
-/// <param name="vAddr">
-/// The virtual address of the buffer.
+/// <param name="asid">
+/// The ASID of the process which owns the file descriptor.
+/// </param>
+/// <param name="fd">
+/// The file descriptor of the target.
+/// </param>
+/// <param name="target">
+/// The target. Only files have offsets.
+/// </param>
+/// <param name="offsetPtr">
+/// The virtual memory address of the offset passed to the system call, which
+/// the kernel advanced past the copied range, or zero if the position of the
+/// file was used instead.
+/// </param>
+/// <param name="wide">
+/// True if the offset is 64 bits wide (loff_t), false if it is 32 bits wide
+/// (off_t).
 /// </param>
 /// <param name="length">
-/// The length of the buffer, in bytes.
+/// The number of bytes copied.
 /// </param>
-/// <param name="label">
-/// The label which should be applied to each address in the buffer.
+/// <param name="offset">
+/// The offset of the first byte of the copied range, or zero if the target 
+/// has no offsets.
 /// </param>
 /// <returns>
-/// The number of bytes labeled. Returns zero if taint2 is not enabled.
+/// True if the offset was found, false if the offset pointer could not be
+/// read or the position of the file could not be determined.
 /// </returns>
-int labelBufferContents(CPUState *cpu, target_ulong vAddr, uint32_t length,
-		uint32_t label);
-		
+bool getCopyOffset(CPUState *cpu, target_ulong asid, uint32_t fd, 
+		const Target &target, uint32_t offsetPtr, bool wide, 
+		uint32_t length, uint64_t &offset);
+
 /// <summary>
-/// Callback function which can be called before a PANDA block execution. This
-/// particular function gets the current process which is about to be executed
-/// and adds it to the processes map. If a process with the same ASID already
-/// exists, it is overwritten with the new process.
+/// Finds the offset in the target file of the first byte of the specified 
+/// read or write. If it happened at the position of the file, the position is
+/// looked up, which the call has already advanced past the data.
 /// </summary>
 /// <param name="cpu">
 /// The CPU State pointer.
 /// </param>
-/// <param name="tB">
-/// The Translation Block which is about to be run.
+/// <param name="io">
+/// The read or write.
+/// </param>
+/// <param name="offset">
+/// The offset of the first byte.
 /// </param>
 /// <returns>
-/// One if successful, zero otherwise.
+/// True if the offset was found, false if the position of the file could not
+/// be determined.
 /// </returns>
-int on_before_block_execution(CPUState *cpu, TranslationBlock *tB);
+bool getIOOffset(CPUState *cpu, const TargetIO &io, uint64_t &offset);
 
 /// <summary>
-/// Callback function which can be called before a PANDA block translation.
-/// This particular function is used to enable the taint2 plugin if the current
-/// instruction count exceeds the enable taint at property of the plugin.
+/// Returns the code of the specified target kind, as used by the target lists
+/// and the shadow store: "f" for files, "n" for networks and "c" for 
+/// channels.
+/// </summary>
+/// <param name="kind">
+/// The target kind.
+/// </param>
+/// <returns>
+/// The code of the target kind.
+/// </returns>
+const char* getKindCode(TargetKind kind);
+
+/// <summary>
+/// Returns the shadow of the specified target. The shadow of a stream is 
+/// created on its first use, even if no labeled data goes through it, so that
+/// its read and write offsets count every byte which went through it. The
+/// shadow of any other target is only created if requested.
+/// </summary>
+/// <param name="target">
+/// The target.
+/// </param>
+/// <param name="create">
+/// Whether the shadow is created if the target has none.
+/// </param>
+/// <returns>
+/// The pointer to the shadow, or a null pointer if the target has none.
+/// </returns>
+LabelShadow* getShadow(const Target &target, bool create);
+
+/// <summary>
+/// Returns the network target with the IP address and port of the specified
+/// socket address.
+/// </summary>
+/// <param name="address">
+/// The socket address.
+/// </param>
+/// <param name="intern">
+/// Whether the target is interned if it was not interned yet.
+/// </param>
+/// <returns>
+/// The network target, which is invalid if it was not interned and 
+/// <paramref="intern"/> is false.
+/// </returns>
+Target getTargetAddress(const SocketAddress &address, bool intern);
+
+/// <summary>
+/// Returns the interned file target with the file name corresponding to the
+/// specified file descriptor and ASID. If no such file name is found, or the 
+/// file name was never interned and no configuration discovers targets, the 
+/// target returned is invalid, unless <paramref="intern"/> is set. Pipes, 
+/// socketpairs and UNIX sockets, which the kernel names "pipe:[inode]" and 
+/// "socket:[inode]", are always interned as channel targets.
 /// </summary>
 /// <param name="cpu">
 /// The CPU State pointer.
 /// </param>
-/// <param name="pc">
-/// The program counter.
+/// <param name="asid">
+/// The ASID of the process which owns the file referenced by the file
+/// descriptor.
+/// </param>
+/// <param name="fd">
+/// The file descriptor for which the file name is to be fetched.
+/// </param>
+/// <param name="intern">
+/// Whether the file name is to be interned if it was not interned yet.
 /// </param>
 /// <returns>
-/// Zero always.
+/// The file target. If the file name could not be resolved or is not interned,
+/// the target returned is invalid.
 /// </returns>
-int on_before_block_translate(CPUState *cpu, target_ulong pc);
+Target getTargetFile(CPUState *cpu, target_ulong asid, uint32_t fd,
+		bool intern = false);
 
 /// <summary>
-/// Callback function for the syscalls2 "on_sys_pread64_return_t" event. This
-/// function taints the specified buffer, if the target associated with the
-/// specified file descriptor is a target source.
+/// Returns the name of the specified target, as stored in the plugin's target
+/// table.
 /// </summary>
-/// <param name="cpu">
-/// The CPU state pointer.
+/// <param name="target">
+/// The target whose name is to be fetched.
 /// </param>
-/// <param name="pc">
-/// The program counter.
+/// <returns>
+/// The name of the target.
+/// </returns>
+std::string getTargetName(const Target &target);
+
+/// <summary>
+/// Returns the wildcard network target which the specified socket listens on,
+/// if the socket was bound to a port whose wildcard target ("*::port") is 
+/// known.
+/// </summary>
+/// <param name="asid">
+/// The ASID of the process which owns the socket.
 /// </param>
 /// <param name="fd">
-/// The file descriptor.
+/// The file descriptor of the socket.
 /// </param>
-/// <param name="buffer">
-/// The virtual memory address of the read buffer.
+/// <returns>
+/// The wildcard network target, or an invalid target if there is none.
+/// </returns>
+Target getTargetListener(target_ulong asid, uint32_t fd);
+
+/// <summary>
+/// Returns the network target with the IP address and port corresponding to 
+/// the specified file descriptor and ASID. Sockets which were only bound fall
+/// back to their listening target. If no such network target is found, the 
+/// target returned is invalid.
+/// </summary>
+/// <param name="asid">
+/// The ASID of the process which owns the network target referenced by the
+/// socket file descriptor.
 /// </param>
-/// <param name="count">
-/// The length of the read buffer.
+/// <param name="fd">
+/// The file descriptor for which the network target is to be fetched.
 /// </param>
-/// <param name="pos">
-/// The position from which the file was read from.
+Target getTargetNetwork(target_ulong asid, uint32_t fd);
+
+/// <summary>
+/// Returns the network target which the specified socket exchanges data with.
+/// Connected and accepted sockets are known by their file descriptor. 
+/// Otherwise, the peer is classified from the specified socket address, or 
+/// the listening target of the socket is returned if there is no address.
+/// </summary>
+/// <param name="cpu">
+/// The CPU State pointer.
 /// </param>
-void on_pread64_return(CPUState *cpu, target_ulong pc, uint32_t fd,
-		uint32_t buffer, uint32_t count, uint64_t pos);
+/// <param name="asid">
+/// The ASID of the process which owns the socket.
+/// </param>
+/// <param name="fd">
+/// The file descriptor of the socket.
+/// </param>
+/// <param name="addr">
+/// The virtual memory address of the socket address passed to the call, may
+/// be zero.
+/// </param>
+/// <param name="length">
+/// The length of the socket address, in bytes.
+/// </param>
+/// <returns>
+/// The network target, or an invalid target if there is none.
+/// </returns>
+Target getTargetPeer(CPUState *cpu, target_ulong asid, uint32_t fd,
+		uint32_t addr, uint32_t length);
 
 /// <summary>
-/// Callback function for the syscalls2 "on_sys_pwrite64_return_t" event. This
-/// function queries the specified buffer, if the target associated with the
-/// specified file descriptor is a target sink.
+/// Returns the target which the peer at the socket address at the specified
+/// virtual memory address is classified as, for the specified socket. See
+/// <see cref="classifyPeer"/>.
 /// </summary>
 /// <param name="cpu">
-/// The CPU state pointer.
+/// The CPU State pointer.
 /// </param>
-/// <param name="pc">
-/// The program counter.
+/// <param name="asid">
+/// The ASID of the process which owns the socket.
 /// </param>
 /// <param name="fd">
-/// The file descriptor.
+/// The file descriptor of the socket.
 /// </param>
-/// <param name="buffer">
-/// The virtual memory address of the read buffer.
+/// <param name="addr">
+/// The virtual memory address of the socket address, may be zero.
 /// </param>
-/// <param name="count">
-/// The length of the read buffer.
+/// <param name="length">
+/// The length of the socket address, in bytes.
 /// </param>
-/// <param name="pos">
+/// <returns>
+/// The target. If the address could not be read or is of an unknown family,
+/// the target returned is invalid.
+/// </returns>
+Target getTargetSockaddr(CPUState *cpu, target_ulong asid, uint32_t fd,
+		uint32_t addr, uint32_t length);
+
+/// <summary>
+/// Gets the index of the sink associated with the specified 
+/// <param ref="target"/> in the specified configuration. If the configuration
+/// discovers targets, a valid target which is not a sink yet is added to its
+/// sinks.
+/// </summary>
+/// <param name="configuration">
+/// The configuration in which the sink is to be fetched.
+/// </param>
+/// <param name="target">
+/// The target for which the sink target is to be fetched.
+/// </param>
+/// <returns>
+/// The index of the sink in the configuration's sinks, or 
+/// <see cref="NO_INDEX"/> if no sink target is associated with the specified
+/// target.
+/// </returns>
+uint32_t getTargetSink(Configuration &configuration, const Target &target); 
+
+/// <summary>
+/// Gets the index of the source associated with the specified 
+/// <param ref="target"/> in the specified configuration. If the configuration
+/// discovers targets, or <paramref="add"/> is set, a valid target which is not
+/// a source yet is added to its sources, which allocates the next label to it.
+/// </summary>
+/// <param name="configuration">
+/// The configuration in which the source is to be fetched.
+/// </param>
+/// <param name="target">
+/// The target for which the source target is to be fetched.
+/// </param>
+/// <param name="add">
+/// Whether the target should be added to the sources if it is not one yet.
+/// </param>
+/// <returns>
+/// The index of the source in the configuration's sources, or 
+/// <see cref="NO_INDEX"/> if no source target is associated with the 
+/// specified target.
+/// </returns>
+uint32_t getTargetSource(Configuration &configuration, const Target &target,
+		bool add = false); 
+
+/// <summary>
+/// Interns the UNIX socket with the specified file descriptor as a channel 
+/// target, named after its inode, and caches it in the channels of the 
+/// process. Only sockets known to be UNIX sockets are interned as channels,
+/// so that Internet sockets which are not connected are not channels.
+/// </summary>
+/// <param name="cpu">
+/// The CPU State pointer.
+/// </param>
+/// <param name="asid">
+/// The ASID of the process which owns the file descriptor.
+/// </param>
+/// <param name="fd">
+/// The file descriptor of the UNIX socket.
+/// </param>
+/// <returns>
+/// The channel target of the socket, or an invalid target if its name could
+/// not be resolved.
+/// </returns>
+Target internUnixSocket(CPUState *cpu, target_ulong asid, uint32_t fd);
+
+/// <summary>
+/// Forgets all of the state of the file descriptors and of the mappings of
+/// the specified process, as happens when it exits or executes a new program.
+/// </summary>
+/// <param name="asid">
+/// The ASID of the process.
+/// </param>
+void invalidateProcess(target_ulong asid);
+
+/// <summary>
+/// Checks if the specified target is a stream, which has no offsets: data is
+/// appended to it and consumed from it in order. Channels are streams.
+/// </summary>
+/// <param name="target">
+/// The target to be checked.
+/// </param>
+/// <returns>
+/// True if the target is a stream, false otherwise.
+/// </returns>
+bool isStream(const Target &target);
+
+/// <summary>
+/// Checks if the specified <paramref="target"/> is a sink target in any of
+/// the configurations.
+/// </summary>
+/// <param name="target">
+/// The target to be checked.
+/// </param>
+/// <returns>
+/// True if <paramref="target"/> is a sink, false otherwise.
+/// </returns>
+bool isSink(const Target &target);
+
+/// <summary>
+/// Checks if the specified <paramref="target"/> is a source target in any of
+/// the configurations.
+/// </summary>
+/// <param name="target">
+/// The target to be checked.
+/// </param>
+/// <returns>
+/// True if <paramref="target"/> is a source, false otherwise.
+/// </returns>
+bool isSource(const Target &target);
+
+/// <summary>
+/// Taints the contents of the buffer covered by the specified page runs. This
+/// function does nothing if taint2 is not currently enabled.
+/// </summary>
+/// <param name="runs">
+/// The page runs of the buffer.
+/// </param>
+/// <param name="label">
+/// The label which should be applied to each address in the buffer.
+/// </param>
+/// <returns>
+/// The number of bytes labeled. Returns zero if taint2 is not enabled.
+/// </returns>
+int labelBufferContents(const PageRuns &runs, uint32_t label);
+
+/// <summary>
+/// Labels up to <paramref="budget"/> pages of the specified source mapping 
+/// which were not labeled yet, if they are resident, with the labels of the
+/// mapping, and adds the bytes labeled to the mapped bytes of the sources.
+/// </summary>
+/// <param name="cpu">
+/// The CPU State pointer, of the process which owns the mapping.
+/// </param>
+/// <param name="mapping">
+/// The source mapping.
+/// </param>
+/// <param name="budget">
+/// The maximum number of pages to be checked.
+/// </param>
+/// <returns>
+/// The number of pages labeled.
+/// </returns>
+uint32_t labelMapping(CPUState *cpu, SourceMapping &mapping, 
+		uint32_t budget);
+
+/// <summary>
+/// Labels the specified part of a page of the specified source mapping with
+/// the labels of the mapping, if the page is resident, and adds the bytes 
+/// labeled to the mapped bytes of the sources.
+/// </summary>
+/// <param name="cpu">
+/// The CPU State pointer, of the process which owns the mapping.
+/// </param>
+/// <param name="mapping">
+/// The source mapping.
+/// </param>
+/// <param name="vAddr">
+/// The virtual address of the part of the page.
+/// </param>
+/// <param name="length">
+/// The length of the part of the page, in bytes.
+/// </param>
+/// <returns>
+/// True if the page was labeled, false if it is not resident yet or taint2
+/// is not enabled.
+/// </returns>
+bool labelMappingPage(CPUState *cpu, const SourceMapping &mapping, 
+		target_ulong vAddr, uint32_t length);
+
+/// <summary>
+/// Labels the pages of the source mappings of the process with the specified
+/// ASID which overlap the specified range of virtual memory, since the range
+/// was just accessed. Mappings whose pages were all labeled are forgotten.
+/// </summary>
+/// <param name="cpu">
+/// The CPU State pointer.
+/// </param>
+/// <param name="asid">
+/// The ASID of the current process.
+/// </param>
+/// <param name="start">
+/// The virtual address of the range accessed.
+/// </param>
+/// <param name="length">
+/// The length of the range accessed, in bytes.
+/// </param>
+void labelMappingRange(CPUState *cpu, target_ulong asid, target_ulong start,
+		uint32_t length);
+
+/// <summary>
+/// Labels the pages of the source mappings of the process with the specified
+/// ASID which have become resident, checking no more pages than the budget
+/// specified by the "mmapBudget" argument. Mappings whose pages were all 
+/// labeled are forgotten. This is done once per "mmapInterval" instructions,
+/// the pages which are accessed are labeled on their page faults instead.
+/// </summary>
+/// <param name="cpu">
+/// The CPU State pointer.
+/// </param>
+/// <param name="asid">
+/// The ASID of the current process.
+/// </param>
+void labelMappings(CPUState *cpu, target_ulong asid);
+
+/// <summary>
+/// Labels the contents of the buffer read from the specified target, once for
+/// each configuration in which the target is a source, with the label of the
+/// source in that configuration, and updates the statistics of the sources.
+/// The buffer is translated to page runs only once, and only if the target is
+/// a source in some configuration. The labels which the shadow of the target
+/// holds for the data read are then reapplied to the buffer.
+/// </summary>
+/// <param name="cpu">
+/// The CPU State pointer.
+/// </param>
+/// <param name="target">
+/// The target from which the buffer was read.
+/// </param>
+/// <param name="io">
+/// The read, whose buffer is described by its segments.
+/// </param>
+void labelSources(CPUState *cpu, const Target &target, const TargetIO &io);
+		
+/// <summary>
+/// Loads the shadows of the files stored in the specified shadow store, which
+/// was saved by a previous replay. Each source named in the store is added to
+/// the configuration of the same name, if it is not already one of its 
+/// sources, so that the labels carried by the files are attributed to it.
+/// </summary>
+/// <param name="file">
+/// The name of the shadow store.
+/// </param>
+/// <returns>
+/// The number of ranges loaded.
+/// </returns>
+uint64_t loadShadowStore(const std::string &file);
+
+/// <summary>
+/// Pushes a record of the specified type into the event log. Records which
+/// are results of the replay wait for room in the log when it is full, only
+/// the debug records of seen targets and of copies may be dropped.
+/// </summary>
+/// <param name="type">
+/// The type of the record.
+/// </param>
+/// <param name="event">
+/// The name of the event, which must be a string literal, since it is only
+/// formatted later, by the logging thread.
+/// </param>
+/// <param name="target">
+/// The target of the event.
+/// </param>
+/// <param name="first">
+/// The first value of the record, which depends on its type.
+/// </param>
+/// <param name="second">
+/// The second value of the record, which depends on its type.
+/// </param>
+/// <param name="third">
+/// The third value of the record, which depends on its type.
+/// </param>
+void logEvent(LogType type, const char *event, const Target &target,
+		uint64_t first = 0, uint64_t second = 0, uint64_t third = 0);
+
+/// <summary>
+/// Handles a mapping of the target referenced by the specified file 
+/// descriptor into the memory of the current process. The source mappings 
+/// which the new mapping replaces are forgotten. If the target is a source in
+/// any configuration, the resident pages of the mapping are labeled right 
+/// away, and the mapping is remembered so that the other pages are labeled 
+/// once they become resident. The mapped address is taken from the EAX 
+/// register.
+/// </summary>
+/// <param name="cpu">
+/// The CPU State pointer.
+/// </param>
+/// <param name="fd">
+/// The file descriptor which was mapped.
+/// </param>
+/// <param name="flags">
+/// The flags of the mapping.
+/// </param>
+/// <param name="length">
+/// The length of the mapping, in bytes.
+/// </param>
+void mapSource(CPUState *cpu, uint32_t fd, uint32_t flags, uint32_t length);
+
+/// <summary>
+/// Matches the specified end of a UNIX socket connection to the path with the
+/// oldest unmatched end of the other side, and pairs the two ends. If there 
+/// is none, the end waits for the other side to be seen.
+/// </summary>
+/// <param name="path">
+/// The path which the connection was made to.
+/// </param>
+/// <param name="target">
+/// The channel target of the end of the connection.
+/// </param>
+/// <param name="accepted">
+/// True if the end was accepted on the path, false if it connected to it.
+/// </param>
+void matchPeer(const std::string &path, const Target &target, bool accepted);
+
+/// <summary>
+/// Callback function which can be called before a PANDA block execution. This
+/// particular function labels the page of the source mappings of the current
+/// process on which the last page fault happened, and once in a while, the 
+/// other pages which have become resident. In kernel mode, it also gets the 
+/// current process which is about to be executed and adds it to the processes
+/// map. If a process with the same ASID already exists, it is overwritten 
+/// with the new process.
+/// </summary>
+/// <param name="cpu">
+/// The CPU State pointer.
+/// </param>
+/// <param name="tB">
+/// The Translation Block which is about to be run.
+/// </param>
+/// <returns>
+/// One if successful, zero otherwise.
+/// </returns>
+int on_before_block_execution(CPUState *cpu, TranslationBlock *tB);
+
+/// <summary>
+/// Callback function which can be called before a PANDA block translation.
+/// This particular function is used to enable the taint2 plugin if the current
+/// instruction count exceeds the enable taint at property of the plugin.
+/// </summary>
+/// <typeparam name="Policy">
+/// The logging policy of the callback, see <see cref="DebugPolicy"/>.
+/// </typeparam>
+/// <param name="cpu">
+/// The CPU State pointer.
+/// </param>
+/// <param name="pc">
+/// The program counter.
+/// </param>
+/// <returns>
+/// Zero always.
+/// </returns>
+template<typename Policy>
+int on_before_block_translate(CPUState *cpu, target_ulong pc);
+
+/// <summary>
+/// Callback function for the syscalls2 "on_sys_close_return_t" event. This
+/// function forgets the target of the closed file descriptor, so that the
+/// next file descriptor with the same number is not taken for it.
+/// </summary>
+/// <param name="cpu">
+/// The CPU state pointer.
+/// </param>
+/// <param name="pc">
+/// The program counter.
+/// </param>
+/// <param name="fd">
+/// The file descriptor which was closed.
+/// </param>
+void on_close_return(CPUState *cpu, target_ulong pc, uint32_t fd);
+
+/// <summary>
+/// Callback function for the syscalls2 "on_sys_copy_file_range_return_t"
+/// event. This function models the copy between the two files with
+/// <see cref="copyFileDescriptors"/>.
+/// </summary>
+/// <typeparam name="Policy">
+/// The logging policy of the callback, see <see cref="DebugPolicy"/>.
+/// </typeparam>
+/// <param name="cpu">
+/// The CPU state pointer.
+/// </param>
+/// <param name="pc">
+/// The program counter.
+/// </param>
+/// <param name="fd_in">
+/// The file descriptor from which the data was copied.
+/// </param>
+/// <param name="off_in">
+/// The virtual memory address of the input offset, may be zero.
+/// </param>
+/// <param name="fd_out">
+/// The file descriptor to which the data was copied.
+/// </param>
+/// <param name="off_out">
+/// The virtual memory address of the output offset, may be zero.
+/// </param>
+/// <param name="len">
+/// The maximum number of bytes to be copied.
+/// </param>
+/// <param name="flags">
+/// The flags of the call.
+/// </param>
+template<typename Policy>
+void on_copy_file_range_return(CPUState *cpu, target_ulong pc, int32_t fd_in,
+		uint32_t off_in, int32_t fd_out, uint32_t off_out, uint32_t len,
+		uint32_t flags);
+
+/// <summary>
+/// Callback function for the syscalls2 "on_sys_execve_enter_t" event. This
+/// function remembers the ASID of the current process, so that its state can
+/// be forgotten if the new program is loaded, see
+/// <see cref="on_execve_return"/>.
+/// </summary>
+/// <param name="cpu">
+/// The CPU state pointer.
+/// </param>
+/// <param name="pc">
+/// The program counter.
+/// </param>
+/// <param name="filename">
+/// The virtual memory address of the name of the program.
+/// </param>
+/// <param name="argv">
+/// The virtual memory address of the arguments of the program.
+/// </param>
+/// <param name="envp">
+/// The virtual memory address of the environment of the program.
+/// </param>
+void on_execve_enter(CPUState *cpu, target_ulong pc, uint32_t filename,
+		uint32_t argv, uint32_t envp);
+
+/// <summary>
+/// Callback function for the syscalls2 "on_sys_execve_return_t" event. If the
+/// new program was loaded, this function invalidates the old process with 
+/// <see cref="invalidateProcess"/>, since the new program gets a new address
+/// space, under a new ASID. A failed execve keeps the old program and its 
+/// file descriptors.
+/// </summary>
+/// <param name="cpu">
+/// The CPU state pointer.
+/// </param>
+/// <param name="pc">
+/// The program counter.
+/// </param>
+/// <param name="filename">
+/// The virtual memory address of the name of the program.
+/// </param>
+/// <param name="argv">
+/// The virtual memory address of the arguments of the program.
+/// </param>
+/// <param name="envp">
+/// The virtual memory address of the environment of the program.
+/// </param>
+void on_execve_return(CPUState *cpu, target_ulong pc, uint32_t filename,
+		uint32_t argv, uint32_t envp);
+
+/// <summary>
+/// Callback function for the syscalls2 "on_sys_exit_group_enter_t" event. 
+/// This function invalidates the current process with
+/// <see cref="invalidateProcess"/>.
+/// </summary>
+/// <param name="cpu">
+/// The CPU state pointer.
+/// </param>
+/// <param name="pc">
+/// The program counter.
+/// </param>
+/// <param name="error_code">
+/// The exit code of the process.
+/// </param>
+void on_exit_group_enter(CPUState *cpu, target_ulong pc, int32_t error_code);
+
+/// <summary>
+/// Callback function for the syscalls2 "on_sys_mmap_pgoff_return_t" event,
+/// the mmap2 system call. This function handles the mapping with 
+/// <see cref="mapSource"/>.
+/// </summary>
+/// <param name="cpu">
+/// The CPU state pointer.
+/// </param>
+/// <param name="pc">
+/// The program counter.
+/// </param>
+/// <param name="addr">
+/// The requested address of the mapping.
+/// </param>
+/// <param name="len">
+/// The length of the mapping.
+/// </param>
+/// <param name="prot">
+/// The protection of the mapping.
+/// </param>
+/// <param name="flags">
+/// The flags of the mapping.
+/// </param>
+/// <param name="fd">
+/// The file descriptor which was mapped.
+/// </param>
+/// <param name="pgoff">
+/// The offset of the mapping in the file, in pages.
+/// </param>
+void on_mmap_pgoff_return(CPUState *cpu, target_ulong pc, uint32_t addr,
+		uint32_t len, uint32_t prot, uint32_t flags, uint32_t fd, 
+		uint32_t pgoff);
+
+/// <summary>
+/// Callback function for the syscalls2 "on_sys_mremap_return_t" event. This
+/// function forgets the source mappings of the current process which overlap
+/// the old or the new range of the remapped memory.
+/// </summary>
+/// <param name="cpu">
+/// The CPU state pointer.
+/// </param>
+/// <param name="pc">
+/// The program counter.
+/// </param>
+/// <param name="addr">
+/// The address of the old range.
+/// </param>
+/// <param name="old_len">
+/// The length of the old range.
+/// </param>
+/// <param name="new_len">
+/// The length of the new range.
+/// </param>
+/// <param name="flags">
+/// The flags of the call.
+/// </param>
+/// <param name="new_addr">
+/// The requested address of the new range, if it is fixed.
+/// </param>
+void on_mremap_return(CPUState *cpu, target_ulong pc, uint32_t addr,
+		uint32_t old_len, uint32_t new_len, uint32_t flags, uint32_t new_addr);
+
+/// <summary>
+/// Callback function for the syscalls2 "on_sys_munmap_return_t" event. This
+/// function forgets the source mappings of the current process which overlap
+/// the unmapped range, see <see cref="unmapSources"/>.
+/// </summary>
+/// <param name="cpu">
+/// The CPU state pointer.
+/// </param>
+/// <param name="pc">
+/// The program counter.
+/// </param>
+/// <param name="addr">
+/// The address of the unmapped range.
+/// </param>
+/// <param name="len">
+/// The length of the unmapped range.
+/// </param>
+void on_munmap_return(CPUState *cpu, target_ulong pc, uint32_t addr, 
+		uint32_t len);
+
+/// <summary>
+/// Callback function for the syscalls2 "on_sys_old_mmap_return_t" event, the
+/// mmap system call, which passes its arguments in a structure. This function
+/// reads the arguments and handles the mapping with <see cref="mapSource"/>.
+/// </summary>
+/// <param name="cpu">
+/// The CPU state pointer.
+/// </param>
+/// <param name="pc">
+/// The program counter.
+/// </param>
+/// <param name="arg">
+/// The virtual memory address of the arguments structure.
+/// </param>
+void on_old_mmap_return(CPUState *cpu, target_ulong pc, uint32_t arg);
+
+/// <summary>
+/// Callback function for the syscalls2 "on_sys_pread64_return_t" event. This
+/// function taints the specified buffer, if the target associated with the
+/// specified file descriptor is a target source.
+/// </summary>
+/// <typeparam name="Policy">
+/// The logging policy of the callback, see <see cref="DebugPolicy"/>.
+/// </typeparam>
+/// <param name="cpu">
+/// The CPU state pointer.
+/// </param>
+/// <param name="pc">
+/// The program counter.
+/// </param>
+/// <param name="fd">
+/// The file descriptor.
+/// </param>
+/// <param name="buffer">
+/// The virtual memory address of the read buffer.
+/// </param>
+/// <param name="count">
+/// The length of the read buffer.
+/// </param>
+/// <param name="pos">
+/// The position from which the file was read from.
+/// </param>
+template<typename Policy>
+void on_pread64_return(CPUState *cpu, target_ulong pc, uint32_t fd,
+		uint32_t buffer, uint32_t count, uint64_t pos);
+
+/// <summary>
+/// Callback function for the syscalls2 "on_sys_pwrite64_return_t" event. This
+/// function queries the specified buffer, if the target associated with the
+/// specified file descriptor is a target sink.
+/// </summary>
+/// <typeparam name="Policy">
+/// The logging policy of the callback, see <see cref="DebugPolicy"/>.
+/// </typeparam>
+/// <param name="cpu">
+/// The CPU state pointer.
+/// </param>
+/// <param name="pc">
+/// The program counter.
+/// </param>
+/// <param name="fd">
+/// The file descriptor.
+/// </param>
+/// <param name="buffer">
+/// The virtual memory address of the read buffer.
+/// </param>
+/// <param name="count">
+/// The length of the read buffer.
+/// </param>
+/// <param name="pos">
 /// The position from which the file was written to.
 /// </param>
-void on_pwrite64_return(CPUState *cpu, target_ulong pc, uint32_t fd,
-		uint32_t buffer, uint32_t count, uint64_t pos);
-		
+template<typename Policy>
+void on_pwrite64_return(CPUState *cpu, target_ulong pc, uint32_t fd,
+		uint32_t buffer, uint32_t count, uint64_t pos);
+		
+/// <summary>
+/// Callback function for the syscalls2 "on_sys_preadv_return_t" event. This
+/// function reads the iovec array of the call, and taints the segments which
+/// were filled in, if the target associated with the specified file 
+/// descriptor is a target source.
+/// </summary>
+/// <typeparam name="Policy">
+/// The logging policy of the callback, see <see cref="DebugPolicy"/>.
+/// </typeparam>
+/// <param name="cpu">
+/// The CPU state pointer.
+/// </param>
+/// <param name="pc">
+/// The program counter.
+/// </param>
+/// <param name="fd">
+/// The file descriptor.
+/// </param>
+/// <param name="vec">
+/// The virtual memory address of the iovec array.
+/// </param>
+/// <param name="vlen">
+/// The number of elements in the iovec array.
+/// </param>
+/// <param name="pos_l">
+/// The low 32 bits of the position from which the file was read from.
+/// </param>
+/// <param name="pos_h">
+/// The high 32 bits of the position from which the file was read from.
+/// </param>
+template<typename Policy>
+void on_preadv_return(CPUState *cpu, target_ulong pc, uint32_t fd,
+		uint32_t vec, uint32_t vlen, uint32_t pos_l, uint32_t pos_h);
+
+/// <summary>
+/// Callback function for the syscalls2 "on_sys_pwritev_return_t" event. This
+/// function reads the iovec array of the call, and queries the segments which
+/// were written out, if the target associated with the specified file 
+/// descriptor is a target sink.
+/// </summary>
+/// <typeparam name="Policy">
+/// The logging policy of the callback, see <see cref="DebugPolicy"/>.
+/// </typeparam>
+/// <param name="cpu">
+/// The CPU state pointer.
+/// </param>
+/// <param name="pc">
+/// The program counter.
+/// </param>
+/// <param name="fd">
+/// The file descriptor.
+/// </param>
+/// <param name="vec">
+/// The virtual memory address of the iovec array.
+/// </param>
+/// <param name="vlen">
+/// The number of elements in the iovec array.
+/// </param>
+/// <param name="pos_l">
+/// The low 32 bits of the position at which the file was written to.
+/// </param>
+/// <param name="pos_h">
+/// The high 32 bits of the position at which the file was written to.
+/// </param>
+template<typename Policy>
+void on_pwritev_return(CPUState *cpu, target_ulong pc, uint32_t fd,
+		uint32_t vec, uint32_t vlen, uint32_t pos_l, uint32_t pos_h);
+
+/// <summary>
+/// Callback function for the syscalls2 "on_sys_read_return_t" event. This
+/// function calls the <see cref="on_pread64_return"/> function with the
+/// <see cref="CURRENT_POSITION"/> position.
+/// </summary>
+/// <typeparam name="Policy">
+/// The logging policy of the callback, see <see cref="DebugPolicy"/>.
+/// </typeparam>
+/// <param name="cpu">
+/// The CPU state pointer.
+/// </param>
+/// <param name="pc">
+/// The program counter.
+/// </param>
+/// <param name="fd">
+/// The file descriptor.
+/// </param>
+/// <param name="buffer">
+/// The virtual memory address of the read buffer.
+/// </param>
+/// <param name="count">
+/// The length of the read buffer.
+/// </param>
+template<typename Policy>
+void on_read_return(CPUState *cpu, target_ulong pc, uint32_t fd, 
+		uint32_t buffer, uint32_t count);
+
+/// <summary>
+/// Callback function for the syscalls2 "on_sys_readv_return_t" event. This
+/// function calls the <see cref="on_preadv_return"/> function with the
+/// <see cref="CURRENT_POSITION"/> position.
+/// </summary>
+/// <typeparam name="Policy">
+/// The logging policy of the callback, see <see cref="DebugPolicy"/>.
+/// </typeparam>
+/// <param name="cpu">
+/// The CPU state pointer.
+/// </param>
+/// <param name="pc">
+/// The program counter.
+/// </param>
+/// <param name="fd">
+/// The file descriptor.
+/// </param>
+/// <param name="vec">
+/// The virtual memory address of the iovec array.
+/// </param>
+/// <param name="vlen">
+/// The number of elements in the iovec array.
+/// </param>
+template<typename Policy>
+void on_readv_return(CPUState *cpu, target_ulong pc, uint32_t fd, 
+		uint32_t vec, uint32_t vlen);
+
+/// <summary>
+/// Callback function for the syscalls2 "on_sys_sendfile_return_t" event. This
+/// function models the copy from the input file descriptor to the output file
+/// descriptor with <see cref="copyFileDescriptors"/>.
+/// </summary>
+/// <typeparam name="Policy">
+/// The logging policy of the callback, see <see cref="DebugPolicy"/>.
+/// </typeparam>
+/// <param name="cpu">
+/// The CPU state pointer.
+/// </param>
+/// <param name="pc">
+/// The program counter.
+/// </param>
+/// <param name="out_fd">
+/// The file descriptor to which the data was copied.
+/// </param>
+/// <param name="in_fd">
+/// The file descriptor from which the data was copied.
+/// </param>
+/// <param name="offset">
+/// The virtual memory address of the 32 bit input offset, may be zero.
+/// </param>
+/// <param name="count">
+/// The maximum number of bytes to be copied.
+/// </param>
+template<typename Policy>
+void on_sendfile_return(CPUState *cpu, target_ulong pc, int32_t out_fd,
+		int32_t in_fd, uint32_t offset, uint32_t count);
+
 /// <summary>
-/// Callback function for the syscalls2 "on_sys_read_return_t" event. This
-/// function calls the <see cref="on_pread64_return"/> function with a zero
-/// argument for the position parameter.
+/// Callback function for the syscalls2 "on_sys_sendfile64_return_t" event.
+/// This function is identical to <see cref="on_sendfile_return"/>, except 
+/// that the input offset is 64 bits wide.
 /// </summary>
+/// <typeparam name="Policy">
+/// The logging policy of the callback, see <see cref="DebugPolicy"/>.
+/// </typeparam>
 /// <param name="cpu">
 /// The CPU state pointer.
 /// </param>
 /// <param name="pc">
 /// The program counter.
 /// </param>
-/// <param name="fd">
-/// The file descriptor.
+/// <param name="out_fd">
+/// The file descriptor to which the data was copied.
 /// </param>
-/// <param name="buffer">
-/// The virtual memory address of the read buffer.
+/// <param name="in_fd">
+/// The file descriptor from which the data was copied.
+/// </param>
+/// <param name="offset">
+/// The virtual memory address of the 64 bit input offset, may be zero.
 /// </param>
 /// <param name="count">
-/// The length of the read buffer.
+/// The maximum number of bytes to be copied.
 /// </param>
-void on_read_return(CPUState *cpu, target_ulong pc, uint32_t fd, 
-		uint32_t buffer, uint32_t count);
+template<typename Policy>
+void on_sendfile64_return(CPUState *cpu, target_ulong pc, int32_t out_fd,
+		int32_t in_fd, uint32_t offset, uint32_t count);
 
 /// <summary>
 /// Callback function for the "on_sys_socketcall_return_t" system call. This
 /// function calls the appropriate socket function to handle the socket call.
 /// </summary>
+/// <typeparam name="Policy">
+/// The logging policy of the callback, see <see cref="DebugPolicy"/>.
+/// </typeparam>
 /// <param name="cpu">
 /// The CPU State pointer.
 /// </param>
@@ -299,15 +1575,56 @@ void on_read_return(CPUState *cpu, target_ulong pc, uint32_t fd,
 /// <param name="args">
 /// The virtual memory address to the start of the arguments.
 /// </param>
+template<typename Policy>
 void on_socketcall_return(CPUState *cpu, target_ulong pc, int32_t call,
 		uint32_t args);
 		
+/// <summary>
+/// Callback function for the "SYS_ACCEPT" and "SYS_ACCEPT4" socket calls. 
+/// This function classifies the peer of the accepted socket, falling back to
+/// the listening target of the listening socket, and maps the accepted socket
+/// to the resulting network target.
+/// </summary>
+/// <typeparam name="Policy">
+/// The logging policy of the callback, see <see cref="DebugPolicy"/>.
+/// </typeparam>
+/// <param name="cpu">
+/// The CPU State pointer.
+/// </param>
+/// <param name="args">
+/// The virtual memory address to the start of the arguments for the 
+/// accept() system call.
+/// </param>
+template<typename Policy>
+void on_socketcall_accept_return(CPUState *cpu, uint32_t args);
+
+/// <summary>
+/// Callback function for the "SYS_BIND" socket call. This function maps the
+/// bound socket to the wildcard network target of the bound port, if it is 
+/// known, so that the socket and the sockets it accepts listen on it.
+/// </summary>
+/// <typeparam name="Policy">
+/// The logging policy of the callback, see <see cref="DebugPolicy"/>.
+/// </typeparam>
+/// <param name="cpu">
+/// The CPU State pointer.
+/// </param>
+/// <param name="args">
+/// The virtual memory address to the start of the arguments for the bind()
+/// system call.
+/// </param>
+template<typename Policy>
+void on_socketcall_bind_return(CPUState *cpu, uint32_t args);
+
 /// <summary>
 /// Callback function for the syscalls2 "on_sys_connect_return_t" event. This
 /// function gets the Network Target associated with the socket file descriptor
 /// argument and current ASID, and inserts the ASID, FD pair into the networks
 /// vector, mapped to the corresponding Network Target.
 /// </summary>
+/// <typeparam name="Policy">
+/// The logging policy of the callback, see <see cref="DebugPolicy"/>.
+/// </typeparam>
 /// <param name="cpu">
 /// The CPU State pointer.
 /// </param>
@@ -315,14 +1632,18 @@ void on_socketcall_return(CPUState *cpu, target_ulong pc, int32_t call,
 /// The virtual memory address to the start of the arguments for the connect()
 /// system call.
 /// </param>
+template<typename Policy>
 void on_socketcall_connect_return(CPUState *cpu, uint32_t args);
 
 /// <summary>
 /// Callback function for the syscalls2 "on_sys_recv_return_t" event. This
 /// function gets the IP and port associated with the receive command and if
 /// this is a source target, it taints the buffer of this call, and adds the
-/// number of tainted bytes to the TargetSource.
+/// number of tainted bytes to the source statistics.
 /// </summary>
+/// <typeparam name="Policy">
+/// The logging policy of the callback, see <see cref="DebugPolicy"/>.
+/// </typeparam>
 /// <param name="cpu">
 /// The CPU State pointer.
 /// </param>
@@ -330,14 +1651,54 @@ void on_socketcall_connect_return(CPUState *cpu, uint32_t args);
 /// The virtual memory address to the start of the arguments for the recv()
 /// system call.
 /// </param>
+template<typename Policy>
 void on_socketcall_recv_return(CPUState *cpu, uint32_t args);
 
+/// <summary>
+/// Callback function for the "SYS_RECVFROM" socket call. This function 
+/// classifies the sender of the datagram, unless the socket is connected, and
+/// if it is a source target, it taints the buffer of this call.
+/// </summary>
+/// <typeparam name="Policy">
+/// The logging policy of the callback, see <see cref="DebugPolicy"/>.
+/// </typeparam>
+/// <param name="cpu">
+/// The CPU State pointer.
+/// </param>
+/// <param name="args">
+/// The virtual memory address to the start of the arguments for the 
+/// recvfrom() system call.
+/// </param>
+template<typename Policy>
+void on_socketcall_recvfrom_return(CPUState *cpu, uint32_t args);
+
+/// <summary>
+/// Callback function for the "SYS_RECVMSG" socket call. This function decodes
+/// the message header and its iovec array, and if the network target of the
+/// message is a source target, it taints the segments which were filled in.
+/// </summary>
+/// <typeparam name="Policy">
+/// The logging policy of the callback, see <see cref="DebugPolicy"/>.
+/// </typeparam>
+/// <param name="cpu">
+/// The CPU State pointer.
+/// </param>
+/// <param name="args">
+/// The virtual memory address to the start of the arguments for the 
+/// recvmsg() system call.
+/// </param>
+template<typename Policy>
+void on_socketcall_recvmsg_return(CPUState *cpu, uint32_t args);
+
 /// <summary>
 /// Callback function for the syscalls2 "on_sys_send_return_t" event. This
 /// function gets the IP and port associated with the send command and if this
 /// is a sink target, it queries the buffer of this call for taint and adds
-/// the number of tainted bytes to the TargetSink.
+/// the number of tainted bytes to the sink statistics.
 /// </summary>
+/// <typeparam name="Policy">
+/// The logging policy of the callback, see <see cref="DebugPolicy"/>.
+/// </typeparam>
 /// <param name="cpu">
 /// The CPU State pointer.
 /// </param>
@@ -345,13 +1706,155 @@ void on_socketcall_recv_return(CPUState *cpu, uint32_t args);
 /// The virtual memory address to the start of the arguments for the recv()
 /// system call.
 /// </param>
+template<typename Policy>
 void on_socketcall_send_return(CPUState *cpu, uint32_t args);
 
+/// <summary>
+/// Callback function for the "SYS_SENDTO" socket call. This function 
+/// classifies the destination of the datagram, unless the socket is 
+/// connected, and if it is a sink target, it queries the buffer of this call.
+/// </summary>
+/// <typeparam name="Policy">
+/// The logging policy of the callback, see <see cref="DebugPolicy"/>.
+/// </typeparam>
+/// <param name="cpu">
+/// The CPU State pointer.
+/// </param>
+/// <param name="args">
+/// The virtual memory address to the start of the arguments for the sendto()
+/// system call.
+/// </param>
+template<typename Policy>
+void on_socketcall_sendto_return(CPUState *cpu, uint32_t args);
+
+/// <summary>
+/// Callback function for the "SYS_SENDMSG" socket call. This function decodes
+/// the message header and its iovec array, and if the network target of the
+/// message is a sink target, it queries the segments which were sent.
+/// </summary>
+/// <typeparam name="Policy">
+/// The logging policy of the callback, see <see cref="DebugPolicy"/>.
+/// </typeparam>
+/// <param name="cpu">
+/// The CPU State pointer.
+/// </param>
+/// <param name="args">
+/// The virtual memory address to the start of the arguments for the 
+/// sendmsg() system call.
+/// </param>
+template<typename Policy>
+void on_socketcall_sendmsg_return(CPUState *cpu, uint32_t args);
+
+/// <summary>
+/// Callback function for the "SYS_SOCKET" socket call. This function interns
+/// new UNIX sockets as channel targets.
+/// </summary>
+/// <typeparam name="Policy">
+/// The logging policy of the callback, see <see cref="DebugPolicy"/>.
+/// </typeparam>
+/// <param name="cpu">
+/// The CPU State pointer.
+/// </param>
+/// <param name="args">
+/// The virtual memory address to the start of the arguments for the 
+/// socket() system call.
+/// </param>
+template<typename Policy>
+void on_socketcall_socket_return(CPUState *cpu, uint32_t args);
+
+/// <summary>
+/// Callback function for the "SYS_SOCKETPAIR" socket call. This function 
+/// interns both ends of the new socket pair as channel targets, and pairs 
+/// them.
+/// </summary>
+/// <typeparam name="Policy">
+/// The logging policy of the callback, see <see cref="DebugPolicy"/>.
+/// </typeparam>
+/// <param name="cpu">
+/// The CPU State pointer.
+/// </param>
+/// <param name="args">
+/// The virtual memory address to the start of the arguments for the 
+/// socketpair() system call.
+/// </param>
+template<typename Policy>
+void on_socketcall_socketpair_return(CPUState *cpu, uint32_t args);
+
+/// <summary>
+/// Callback function for the syscalls2 "on_sys_splice_return_t" event. This
+/// function models the move of data between the two file descriptors, at 
+/// least one of which is a pipe, with <see cref="copyFileDescriptors"/>.
+/// </summary>
+/// <typeparam name="Policy">
+/// The logging policy of the callback, see <see cref="DebugPolicy"/>.
+/// </typeparam>
+/// <param name="cpu">
+/// The CPU state pointer.
+/// </param>
+/// <param name="pc">
+/// The program counter.
+/// </param>
+/// <param name="fd_in">
+/// The file descriptor from which the data was moved.
+/// </param>
+/// <param name="off_in">
+/// The virtual memory address of the input offset, may be zero.
+/// </param>
+/// <param name="fd_out">
+/// The file descriptor to which the data was moved.
+/// </param>
+/// <param name="off_out">
+/// The virtual memory address of the output offset, may be zero.
+/// </param>
+/// <param name="len">
+/// The maximum number of bytes to be moved.
+/// </param>
+/// <param name="flags">
+/// The flags of the call.
+/// </param>
+template<typename Policy>
+void on_splice_return(CPUState *cpu, target_ulong pc, int32_t fd_in,
+		uint32_t off_in, int32_t fd_out, uint32_t off_out, uint32_t len,
+		uint32_t flags);
+
+/// <summary>
+/// Callback function for the syscalls2 "on_sys_tee_return_t" event. This 
+/// function models the duplication of the data of one pipe into another with
+/// <see cref="copyFileDescriptors"/>, without consuming it.
+/// </summary>
+/// <typeparam name="Policy">
+/// The logging policy of the callback, see <see cref="DebugPolicy"/>.
+/// </typeparam>
+/// <param name="cpu">
+/// The CPU state pointer.
+/// </param>
+/// <param name="pc">
+/// The program counter.
+/// </param>
+/// <param name="fdin">
+/// The file descriptor of the pipe from which the data was duplicated.
+/// </param>
+/// <param name="fdout">
+/// The file descriptor of the pipe to which the data was duplicated.
+/// </param>
+/// <param name="len">
+/// The maximum number of bytes to be duplicated.
+/// </param>
+/// <param name="flags">
+/// The flags of the call.
+/// </param>
+template<typename Policy>
+void on_tee_return(CPUState *cpu, target_ulong pc, int32_t fdin, 
+		int32_t fdout, uint32_t len, uint32_t flags);
+
 /// <summary>
 /// Callback function for the syscalls2 "on_sys_write_return_t" event. This
-/// function calls the <see cref="on_pwrite64_return"/> function with a zero
-/// argument for the position parameter.
+/// function calls the <see cref="on_pwrite64_return"/> function with the
+/// <see cref="CURRENT_POSITION"/> position.
 /// </summary>
+/// <typeparam name="Policy">
+/// The logging policy of the callback, see <see cref="DebugPolicy"/>.
+/// </typeparam>
 /// <param name="cpu">
 /// The CPU state pointer.
 /// </param>
@@ -367,12 +1870,104 @@ void on_socketcall_send_return(CPUState *cpu, uint32_t args);
 /// <param name="count">
 /// The length of the write buffer.
 /// </param>
+template<typename Policy>
 void on_write_return(CPUState *cpu, target_ulong pc, uint32_t fd, 
 		uint32_t buffer, uint32_t count);
 
+/// <summary>
+/// Callback function for the syscalls2 "on_sys_writev_return_t" event. This
+/// function calls the <see cref="on_pwritev_return"/> function with the
+/// <see cref="CURRENT_POSITION"/> position.
+/// </summary>
+/// <typeparam name="Policy">
+/// The logging policy of the callback, see <see cref="DebugPolicy"/>.
+/// </typeparam>
+/// <param name="cpu">
+/// The CPU state pointer.
+/// </param>
+/// <param name="pc">
+/// The program counter.
+/// </param>
+/// <param name="fd">
+/// The file descriptor.
+/// </param>
+/// <param name="vec">
+/// The virtual memory address of the iovec array.
+/// </param>
+/// <param name="vlen">
+/// The number of elements in the iovec array.
+/// </param>
+template<typename Policy>
+void on_writev_return(CPUState *cpu, target_ulong pc, uint32_t fd, 
+		uint32_t vec, uint32_t vlen);
+
+/// <summary>
+/// Opens the streaming report, writes its header, if its format has one, and
+/// starts its thread.
+/// </summary>
+/// <param name="format">
+/// The format of the report, "jsonl" or "csv".
+/// </param>
+/// <param name="queue">
+/// The size of the queue of the report, in records, or 0 to write each 
+/// record synchronously.
+/// </param>
+/// <returns>
+/// True if the report was opened, false if its format is unknown or if it
+/// could not be created.
+/// </returns>
+bool openReport(const std::string &format, uint32_t queue);
+
+/// <summary>
+/// Opens the stats file, and moves the counters of the sources and sinks of
+/// every configuration into it, so that they are updated in the file from 
+/// then on.
+/// </summary>
+/// <returns>
+/// True if the counters of every configuration were moved into the stats
+/// file, false otherwise.
+/// </returns>
+bool openStats();
+
+/// <summary>
+/// Opens the event trace, or its next shard if the trace is split into 
+/// shards. Shards are named after the trace file, followed by a dot and the
+/// index of the shard.
+/// </summary>
+/// <returns>
+/// True if the trace was opened, false otherwise.
+/// </returns>
+bool openTrace();
+
+/// <summary>
+/// Packs the specified target into a single value, so that it can be stored
+/// in a record of the event log. See <see cref="unpackTarget"/>.
+/// </summary>
+/// <param name="target">
+/// The target to be packed.
+/// </param>
+/// <returns>
+/// The packed target.
+/// </returns>
+uint64_t packTarget(const Target &target);
+
+/// <summary>
+/// Pairs the two specified ends of a UNIX socket connection, so that the data
+/// written to each end is read from the other end.
+/// </summary>
+/// <param name="first">
+/// The channel target of the first end.
+/// </param>
+/// <param name="second">
+/// The channel target of the second end.
+/// </param>
+void pairChannels(const Target &first, const Target &second);
+
 /// <summary>
 /// Parses the specified file, which is assumed to be in CSV format. Returns
-/// a vector containing the vectors of the strings parsed on each line.
+/// a vector containing the vectors of the strings parsed on each line. Tokens
+/// may be quoted, in which case they may hold commas, and quotes written as
+/// two quotes.
 /// </summary>
 /// <param name="fileName">
 /// The name of the file which is to be processed.
@@ -384,8 +1979,70 @@ void on_write_return(CPUState *cpu, target_ulong pc, uint32_t fd,
 std::vector<std::vector<std::string>> parseCSV(const std::string &fileName);
 
 /// <summary>
-/// Parses the targets from the specified CSV file and returns a vector of the
-/// targets parsed.
+/// Parses the configurations from the specified CSV file, and adds each of
+/// them to the plugin. Each line of the file holds the name of a 
+/// configuration, the name of its sources file and the name of its sinks 
+/// file.
+/// </summary>
+/// <param name="file">
+/// The name of the CSV file from which to parse the configurations.
+/// </param>
+void parseConfigurations(const std::string &file);
+
+/// <summary>
+/// Prints the number of bytes read from and written to each of the channels
+/// which were seen.
+/// </summary>
+void printChannels();
+
+/// <summary>
+/// Prints the size of each of the file descriptor tables, and the number of
+/// stale entries which each of them looked up or swept instead of resolving
+/// a file descriptor to a target which it no longer refers to.
+/// </summary>
+void printDescriptors();
+
+/// <summary>
+/// Prints the number of records which the event log wrote and dropped, and
+/// the high water mark of its queue.
+/// </summary>
+void printLog();
+
+/// <summary>
+/// Prints the number of rows and snapshots which were appended to the 
+/// interval series.
+/// </summary>
+void printSeries();
+
+/// <summary>
+/// Prints the number of records and bytes which were written to the event
+/// trace, and the number of shards it was split into.
+/// </summary>
+void printTrace();
+
+/// <summary>
+/// Outputs the statistics of the sources and sinks of the specified 
+/// configuration, and the flows from its sources into its sinks.
+/// </summary>
+/// <param name="configuration">
+/// The configuration to be reported.
+/// </param>
+void printReport(const Configuration &configuration);
+
+/// <summary>
+/// Parses the specified target kind code. See <see cref="getKindCode"/>.
+/// </summary>
+/// <param name="code">
+/// The code of the target kind.
+/// </param>
+/// <returns>
+/// The target kind. Unknown codes are parsed as files.
+/// </returns>
+TargetKind parseKindCode(const std::string &code);
+
+/// <summary>
+/// Parses the targets from the specified CSV file, interns them into the 
+/// plugin's target table and returns a vector of the targets parsed.
 /// </summary>
 /// <param name="file">
 /// The name of the CSV file from which to parse the targets.
@@ -394,27 +2051,113 @@ std::vector<std::vector<std::string>> parseCSV(const std::string &fileName);
 /// The vector containing all valid targets which were successfully read in
 /// from the file.
 /// </returns>
-std::vector<std::unique_ptr<Target>> parseTargets(const std::string &file);
+std::vector<Target> parseTargets(const std::string &file);
 		
 /// <summary>
-/// Queries the contents of the buffer at the specified virtual address and of
-/// the specified length for taint. This function does nothing if taint2 is not
-/// currently enabled, and returns an empty map if taint2 is not enabled.
+/// Queries the contents of the buffer covered by the specified page runs for
+/// taint. This function does nothing if taint2 is not currently enabled, in 
+/// which case the histogram is left empty.
+/// </summary>
+/// <param name="runs">
+/// The page runs of the buffer.
+/// </param>
+/// <param name="histogram">
+/// The histogram which is cleared and then filled with the number of bytes
+/// tainted by each label found, with the labels sorted in ascending order.
+/// </param>
+/// <param name="spans">
+/// The vector to which the spans of bytes carrying the same labels are
+/// appended, with offsets relative to the start of the buffer, or null if the
+/// spans are not needed.
+/// </param>
+void queryBufferContents(const PageRuns &runs, LabelHistogram &histogram,
+		std::vector<ShadowSpan> *spans = nullptr);
+
+/// <summary>
+/// Queries the contents of the buffer written to the specified target, if the
+/// target is a sink in any configuration, and credits the labels found in it 
+/// to the sink of each configuration which owns them. The buffer is queried
+/// only once, regardless of the number of configurations. The labels found 
+/// are also recorded in the shadow of the target, if it is a shadowed file or
+/// pipe, or if it is a file and all file writes are shadowed.
 /// </summary>
 /// <param name="cpu">
 /// The CPU State pointer.
 /// </param>
-/// <param name="vAddr">
-/// The virtual address of the buffer.
+/// <param name="target">
+/// The target to which the buffer was written.
 /// </param>
-/// <param name="length">
-/// The length of the buffer, in bytes.
+/// <param name="io">
+/// The write, whose buffer is described by its segments.
+/// </param>
+void querySinks(CPUState *cpu, const Target &target, const TargetIO &io);
+
+/// <summary>
+/// Queues a record of the specified type into the streaming report, if the
+/// report is open. See <see cref="ReportType"/> for the values of each type.
+/// </summary>
+/// <param name="type">
+/// The type of the record.
+/// </param>
+/// <param name="event">
+/// The name of the event, which must be a string literal, or null if the
+/// record is not of an event.
+/// </param>
+/// <param name="first">
+/// The first value of the record.
+/// </param>
+/// <param name="second">
+/// The second value of the record.
+/// </param>
+/// <param name="third">
+/// The third value of the record.
+/// </param>
+/// <param name="fourth">
+/// The fourth value of the record.
+/// </param>
+void reportEvent(ReportType type, const char *event, uint64_t first, 
+		uint64_t second, uint64_t third = 0, uint64_t fourth = 0);
+
+/// <summary>
+/// Registers the syscalls2 callbacks of the reads, writes, socket calls and
+/// kernel copies, instantiated for the specified logging policy.
+/// </summary>
+/// <typeparam name="Policy">
+/// The logging policy of the callbacks, see <see cref="DebugPolicy"/>.
+/// </typeparam>
+template<typename Policy>
+void registerIOCallbacks();
+
+/// <summary>
+/// Resolves the specified file descriptor and ASID to a network target, if a
+/// socket was connected with them, or to a file or channel target otherwise.
+/// Channels are cached per file descriptor and ASID once resolved.
+/// </summary>
+/// <param name="cpu">
+/// The CPU State pointer.
+/// </param>
+/// <param name="asid">
+/// The ASID of the process which owns the file descriptor.
+/// </param>
+/// <param name="fd">
+/// The file descriptor which is to be resolved.
+/// </param>
+/// <param name="intern">
+/// Whether the file name is to be interned if it was not interned yet, see
+/// <see cref="getTargetFile"/>.
 /// </param>
 /// <returns>
-/// A map of each label found to the number of bytes tainted by that label.
+/// The target. If the file descriptor could not be resolved, the target 
+/// returned is invalid.
 /// </returns>
-std::map<uint32_t, uint32_t> queryBufferContents(
-		CPUState *cpu, target_ulong vAddr, uint32_t length);
+Target resolveTarget(CPUState *cpu, target_ulong asid, uint32_t fd,
+		bool intern = false);
+
+/// <summary>
+/// Closes the current shard of the event trace and opens the next one, if 
+/// the trace is split into shards and the current shard is full.
+/// </summary>
+void rotateTrace();
 
 /// <summary>
 /// Initializes this plugin using the specified plugin pointer.
@@ -425,11 +2168,55 @@ std::map<uint32_t, uint32_t> queryBufferContents(
 /// <returns>
 /// True if the plugin was successfully loaded, false otherwise.
 /// </returns>
+/// <summary>
+/// Saves the shadows of the files to the specified shadow store, so that a 
+/// later replay can resume tracking the labeled data stored in them. Each 
+/// label is saved as the names of its configuration and its source, since
+/// labels are not stable across replays.
+/// </summary>
+/// <param name="file">
+/// The name of the shadow store.
+/// </param>
+/// <returns>
+/// True if the shadow store could be written, false otherwise.
+/// </returns>
+bool saveShadowStore(const std::string &file);
+
+/// <summary>
+/// Forgets the source mappings of the process with the specified ASID which
+/// overlap the specified range, even partially, since the range was unmapped
+/// or mapped again, so that their pages are not labeled once something else
+/// is mapped there.
+/// </summary>
+/// <param name="asid">
+/// The ASID of the process.
+/// </param>
+/// <param name="start">
+/// The virtual address of the range.
+/// </param>
+/// <param name="length">
+/// The length of the range, in bytes.
+/// </param>
+void unmapSources(target_ulong asid, target_ulong start, uint32_t length);
+
+/// <summary>
+/// Unpacks the specified target, which was packed by 
+/// <see cref="packTarget"/>.
+/// </summary>
+/// <param name="packed">
+/// The packed target.
+/// </param>
+/// <returns>
+/// The target.
+/// </returns>
+Target unpackTarget(uint64_t packed);
+
 extern "C" bool init_plugin(void *self);
 
 /// <summary>
-/// Destroys this plugin. Outputs information about which sources were tainted
-/// and the dependencies between any source and sink targets.
+/// Destroys this plugin. Outputs, for each configuration, information about 
+/// which sources were tainted and the dependencies between any source and 
+/// sink targets.
 /// </summary>
 /// <param name="self">
 /// The plugin pointer passed in from PANDA.
@@ -0,0 +1,329 @@
+#include "dependency_tracker_flows.h"
+
+#include <algorithm>
+#include <fstream>
+
+/***************************** LABEL  HISTOGRAM *****************************/
+void LabelHistogram::add(uint32_t label, uint64_t count) {
+	if (label >= this->counts.size()) this->counts.resize(label + 1, 0);
+
+	// Remember the label the first time it is seen, so clear() can find it
+	if (this->counts[label] == 0) this->labels.push_back(label);
+	this->counts[label] += count;
+}
+
+void LabelHistogram::clear() {
+	for (auto label : this->labels) this->counts[label] = 0;
+	this->labels.clear();
+}
+
+uint64_t LabelHistogram::getCount(uint32_t label) const {
+	if (label >= this->counts.size()) return 0;
+	return this->counts[label];
+}
+
+const std::vector<uint32_t>& LabelHistogram::getLabels() const {
+	return this->labels;
+}
+
+void LabelHistogram::sort() {
+	std::sort(this->labels.begin(), this->labels.end());
+}
+/***************************** LABEL  HISTOGRAM *****************************/
+
+/******************************* FLOW  MATRIX *******************************/
+const uint32_t FlowMatrix::BLOCK_SIZE;
+const uint32_t FlowMatrix::NO_BLOCK;
+
+FlowMatrix::FlowMatrix() {
+	this->sources = 0;
+	this->sinks = 0;
+	this->blockColumns = 0;
+}
+
+void FlowMatrix::add(uint32_t source, uint32_t sink, uint64_t taintedBytes) {
+	if (source >= this->sources || sink >= this->sinks) {
+		this->resize(std::max(this->sources, source + 1),
+			std::max(this->sinks, sink + 1));
+	}
+
+	// Find the block of the cell, allocate it if no flow was recorded in it
+	uint32_t &block = this->blockIndices[(source / BLOCK_SIZE) *
+		this->blockColumns + (sink / BLOCK_SIZE)];
+	if (block == NO_BLOCK) {
+		block = this->cells.size() / (BLOCK_SIZE * BLOCK_SIZE);
+		this->cells.resize(this->cells.size() + BLOCK_SIZE * BLOCK_SIZE,
+			FlowCell{ 0, 0 });
+	}
+
+	FlowCell &cell = this->cells[block * BLOCK_SIZE * BLOCK_SIZE +
+		(source % BLOCK_SIZE) * BLOCK_SIZE + (sink % BLOCK_SIZE)];
+	cell.taintedBytes += taintedBytes;
+	cell.writes++;
+}
+
+bool FlowMatrix::exportAdjacency(const std::string &file,
+		const std::vector<FlowNode> &sourceNodes,
+		const std::vector<FlowNode> &sinkNodes) const {
+	std::ofstream ofs(file);
+	if (!ofs.is_open()) return false;
+
+	auto writeNodes = [&ofs](const char *type,
+			const std::vector<FlowNode> &nodes) {
+		ofs << type << " " << nodes.size() << "\n";
+		for (size_t i = 0; i < nodes.size(); ++i) {
+			ofs << i << " " << nodes[i].kind << " " << nodes[i].totalBytes <<
+				" " << nodes[i].taintBytes << " " << nodes[i].name << "\n";
+		}
+	};
+	writeNodes("sources", sourceNodes);
+	writeNodes("sinks", sinkNodes);
+
+	// The flows of a source are visited together, so each source with flows
+	// gets a single line. The lines are buffered, so that the number of them
+	// can precede them.
+	std::string flows;
+	uint64_t lines = 0;
+	uint32_t last = UINT32_MAX;
+	this->forEachBySource([&](uint32_t source, uint32_t sink,
+			const FlowCell &cell) {
+		if (source != last) {
+			if (last != UINT32_MAX) flows += '\n';
+			flows += std::to_string(source);
+			last = source;
+			++lines;
+		}
+		flows += ' ' + std::to_string(sink) + ':' +
+			std::to_string(cell.taintedBytes) + ':' +
+			std::to_string(cell.writes);
+	});
+	if (lines > 0) flows += '\n';
+
+	ofs << "flows " << lines << "\n" << flows;
+	return ofs.good();
+}
+
+bool FlowMatrix::exportBinary(const std::string &file) const {
+	std::ofstream ofs(file, std::ios::binary);
+	if (!ofs.is_open()) return false;
+
+	// Count the flows first, so the header can be written before them
+	uint64_t flows = 0;
+	this->forEach([&flows](uint32_t, uint32_t, const FlowCell&) { ++flows; });
+
+	const uint32_t version = 1;
+	ofs.write("FDTFLOWS", 8);
+	ofs.write(reinterpret_cast<const char*>(&version), sizeof(version));
+	ofs.write(reinterpret_cast<const char*>(&this->sources),
+		sizeof(this->sources));
+	ofs.write(reinterpret_cast<const char*>(&this->sinks),
+		sizeof(this->sinks));
+	ofs.write(reinterpret_cast<const char*>(&flows), sizeof(flows));
+
+	this->forEach([&ofs](uint32_t source, uint32_t sink,
+			const FlowCell &cell) {
+		ofs.write(reinterpret_cast<const char*>(&source), sizeof(source));
+		ofs.write(reinterpret_cast<const char*>(&sink), sizeof(sink));
+		ofs.write(reinterpret_cast<const char*>(&cell.taintedBytes),
+			sizeof(cell.taintedBytes));
+		ofs.write(reinterpret_cast<const char*>(&cell.writes),
+			sizeof(cell.writes));
+	});
+
+	return ofs.good();
+}
+
+bool FlowMatrix::exportCSV(const std::string &file,
+		const std::vector<std::string> &sourceNames,
+		const std::vector<std::string> &sinkNames) const {
+	std::ofstream ofs(file);
+	if (!ofs.is_open()) return false;
+
+	// Names are quoted, since file names may contain commas, so quotes in
+	// them are doubled
+	auto quote = [](const std::string &value) {
+		std::string text = "\"";
+		for (char c : value) {
+			if (c == '"') text += '"';
+			text += c;
+		}
+		return text + "\"";
+	};
+
+	ofs << "source,sink,source_name,sink_name,tainted_bytes,writes\n";
+	this->forEach([&](uint32_t source, uint32_t sink, const FlowCell &cell) {
+		ofs << source << "," << sink << "," << quote(sourceNames.at(source)) <<
+			"," << quote(sinkNames.at(sink)) << "," << cell.taintedBytes <<
+			"," << cell.writes << "\n";
+	});
+
+	return ofs.good();
+}
+
+bool FlowMatrix::exportDOT(const std::string &file, const std::string &name,
+		const std::vector<FlowNode> &sourceNodes,
+		const std::vector<FlowNode> &sinkNodes) const {
+	std::ofstream ofs(file);
+	if (!ofs.is_open()) return false;
+
+	// Names are quoted, so quotes and backslashes in them are escaped
+	auto quote = [](const std::string &value) {
+		std::string text = "\"";
+		for (char c : value) {
+			if (c == '"' || c == '\\') text += '\\';
+			text += c;
+		}
+		return text + "\"";
+	};
+
+	ofs << "digraph " << quote(name) << " {\n\trankdir=LR;\n";
+	for (size_t i = 0; i < sourceNodes.size(); ++i) {
+		const FlowNode &node = sourceNodes[i];
+		ofs << "\tsource" << i << " [label=" << quote(node.name) <<
+			", shape=box, kind=\"" << node.kind << "\", total_bytes=" <<
+			node.totalBytes << ", labeled_bytes=" << node.taintBytes <<
+			"];\n";
+	}
+	for (size_t i = 0; i < sinkNodes.size(); ++i) {
+		const FlowNode &node = sinkNodes[i];
+		ofs << "\tsink" << i << " [label=" << quote(node.name) <<
+			", shape=ellipse, kind=\"" << node.kind << "\", total_bytes=" <<
+			node.totalBytes << ", tainted_bytes=" << node.taintBytes <<
+			"];\n";
+	}
+
+	this->forEachBySource([&](uint32_t source, uint32_t sink,
+			const FlowCell &cell) {
+		ofs << "\tsource" << source << " -> sink" << sink << " [label=\"" <<
+			cell.taintedBytes << " B / " << cell.writes << " writes\", " <<
+			"tainted_bytes=" << cell.taintedBytes << ", writes=" <<
+			cell.writes << "];\n";
+	});
+
+	ofs << "}\n";
+	return ofs.good();
+}
+
+void FlowMatrix::forEach(const std::function<void(uint32_t, uint32_t,
+		const FlowCell&)> &function) const {
+	for (size_t i = 0; i < this->blockIndices.size(); ++i) {
+		uint32_t block = this->blockIndices[i];
+		if (block == NO_BLOCK) continue;
+
+		// Visit each non-zero cell of the block, in row major order
+		uint32_t firstSource = (i / this->blockColumns) * BLOCK_SIZE;
+		uint32_t firstSink = (i % this->blockColumns) * BLOCK_SIZE;
+		const FlowCell *cells = &this->cells[block * BLOCK_SIZE * BLOCK_SIZE];
+		for (uint32_t j = 0; j < BLOCK_SIZE * BLOCK_SIZE; ++j) {
+			if (cells[j].writes == 0) continue;
+
+			function(firstSource + j / BLOCK_SIZE, firstSink + j % BLOCK_SIZE,
+				cells[j]);
+		}
+	}
+}
+
+void FlowMatrix::forEachBySource(const std::function<void(uint32_t,
+		uint32_t, const FlowCell&)> &function) const {
+	// Walk each block row one row at a time, through every block in it
+	uint32_t blockRows = this->blockIndices.size() /
+		std::max<uint32_t>(this->blockColumns, 1);
+	for (uint32_t blockRow = 0; blockRow < blockRows; ++blockRow) {
+		for (uint32_t row = 0; row < BLOCK_SIZE; ++row) {
+			uint32_t source = blockRow * BLOCK_SIZE + row;
+			if (source >= this->sources) break;
+
+			for (uint32_t column = 0; column < this->blockColumns; ++column) {
+				uint32_t block = this->getBlock(blockRow, column);
+				if (block == NO_BLOCK) continue;
+
+				const FlowCell *cells = &this->cells[(block * BLOCK_SIZE +
+					row) * BLOCK_SIZE];
+				for (uint32_t i = 0; i < BLOCK_SIZE; ++i) {
+					if (cells[i].writes == 0) continue;
+
+					function(source, column * BLOCK_SIZE + i, cells[i]);
+				}
+			}
+		}
+	}
+}
+
+void FlowMatrix::forEachInSink(uint32_t sink, const std::function<void(
+		uint32_t, const FlowCell&)> &function) const {
+	if (sink >= this->sinks) return;
+
+	// Walk down the column of blocks which contains the sink
+	uint32_t blockRows = this->blockIndices.size() /
+		std::max<uint32_t>(this->blockColumns, 1);
+	for (uint32_t blockRow = 0; blockRow < blockRows; ++blockRow) {
+		uint32_t block = this->getBlock(blockRow, sink / BLOCK_SIZE);
+		if (block == NO_BLOCK) continue;
+
+		const FlowCell *cells = &this->cells[block * BLOCK_SIZE * BLOCK_SIZE];
+		for (uint32_t row = 0; row < BLOCK_SIZE; ++row) {
+			const FlowCell &cell = cells[row * BLOCK_SIZE + sink % BLOCK_SIZE];
+			if (cell.writes == 0) continue;
+
+			function(blockRow * BLOCK_SIZE + row, cell);
+		}
+	}
+}
+
+FlowCell FlowMatrix::get(uint32_t source, uint32_t sink) const {
+	if (source >= this->sources || sink >= this->sinks)
+		return FlowCell{ 0, 0 };
+
+	uint32_t block = this->getBlock(source / BLOCK_SIZE, sink / BLOCK_SIZE);
+	if (block == NO_BLOCK) return FlowCell{ 0, 0 };
+
+	return this->cells[block * BLOCK_SIZE * BLOCK_SIZE +
+		(source % BLOCK_SIZE) * BLOCK_SIZE + (sink % BLOCK_SIZE)];
+}
+
+uint32_t FlowMatrix::getSources() const {
+	return this->sources;
+}
+
+uint32_t FlowMatrix::getSinks() const {
+	return this->sinks;
+}
+
+void FlowMatrix::resize(uint32_t sources, uint32_t sinks) {
+	sources = std::max(sources, this->sources);
+	sinks = std::max(sinks, this->sinks);
+
+	// Compute the new number of block rows and columns. The block indices
+	// only have to be rebuilt if the number of block columns changes, since
+	// otherwise new block rows are simply appended.
+	uint32_t oldBlockRows = this->blockIndices.size() /
+		std::max<uint32_t>(this->blockColumns, 1);
+	uint32_t blockRows = (sources + BLOCK_SIZE - 1) / BLOCK_SIZE;
+	uint32_t blockColumns = (sinks + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+	if (blockColumns != this->blockColumns) {
+		std::vector<uint32_t> indices(blockRows * blockColumns, NO_BLOCK);
+		for (uint32_t row = 0; row < oldBlockRows; ++row) {
+			for (uint32_t column = 0; column < this->blockColumns; ++column) {
+				indices[row * blockColumns + column] =
+					this->blockIndices[row * this->blockColumns + column];
+			}
+		}
+
+		this->blockIndices.swap(indices);
+		this->blockColumns = blockColumns;
+	} else {
+		this->blockIndices.resize(blockRows * blockColumns, NO_BLOCK);
+	}
+
+	this->sources = sources;
+	this->sinks = sinks;
+}
+
+uint32_t FlowMatrix::getBlock(uint32_t blockRow, uint32_t blockColumn) const {
+	size_t index = blockRow * this->blockColumns + blockColumn;
+	if (index >= this->blockIndices.size()) return NO_BLOCK;
+
+	return this->blockIndices[index];
+}
+/******************************* FLOW  MATRIX *******************************/
@@ -0,0 +1,315 @@
+#ifndef DEPENDENCY_TRACKER_FLOWS
+#define DEPENDENCY_TRACKER_FLOWS
+
+#include <functional>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Class which counts how many bytes of a buffer were tainted by each label.
+/// The counts are stored densely by label, and the labels which were seen are
+/// remembered so that clearing the histogram only touches those labels. An
+/// instance is meant to be reused for every query, so that querying a buffer
+/// does not allocate once the histogram has grown to the number of labels.
+/// </summary>
+class LabelHistogram {
+public:
+	/// <summary>
+	/// Creates a new, empty Label Histogram.
+	/// </summary>
+	LabelHistogram() = default;
+
+	/// <summary>
+	/// Adds the specified number of bytes to the count of the label.
+	/// </summary>
+	/// <param name="label">
+	/// The label.
+	/// </param>
+	/// <param name="count">
+	/// The number of bytes tainted by the label.
+	/// </param>
+	void add(uint32_t label, uint64_t count);
+
+	/// <summary>
+	/// Resets the count of each label which was seen to zero.
+	/// </summary>
+	void clear();
+
+	/// <summary>
+	/// Returns the number of bytes tainted by the specified label.
+	/// </summary>
+	/// <param name="label">
+	/// The label.
+	/// </param>
+	/// <returns>
+	/// The number of bytes, zero if the label was not seen.
+	/// </returns>
+	uint64_t getCount(uint32_t label) const;
+
+	/// <summary>
+	/// Returns the labels which were seen since the last clear, in the order
+	/// in which they were first seen.
+	/// </summary>
+	/// <returns>
+	/// The constant reference to the labels.
+	/// </returns>
+	const std::vector<uint32_t>& getLabels() const;
+
+	/// <summary>
+	/// Sorts the labels which were seen in ascending order.
+	/// </summary>
+	void sort();
+protected:
+	std::vector<uint64_t> counts;              // { Label -> # of Bytes }
+	std::vector<uint32_t> labels;              // Labels seen since clear
+};
+
+/// <summary>
+/// Structure which stores the flows from a single source to a single sink.
+/// </summary>
+struct FlowCell {
+	uint64_t taintedBytes;                     // # of tainted bytes written
+	uint64_t writes;                           // # of writes carrying taint
+};
+
+/// <summary>
+/// Structure which describes a source or a sink, as a node of the exported
+/// flow graph.
+/// </summary>
+struct FlowNode {
+	std::string name;                          // Name of the Target
+	const char *kind;                          // Kind Code of the Target
+	uint64_t totalBytes;                       // # of bytes read or written
+	uint64_t taintBytes;                       // # of bytes labeled/tainted
+};
+
+/// <summary>
+/// Class which stores the source by sink matrix of flows. The matrix is split
+/// into square blocks, which are only allocated once any of their cells is
+/// written to. Small matrices therefore behave as dense matrices, while huge
+/// and sparse matrices only use memory for the blocks with flows in them.
+/// </summary>
+class FlowMatrix {
+public:
+	/// <summary>
+	/// The number of rows and columns of each block of the matrix.
+	/// </summary>
+	static const uint32_t BLOCK_SIZE = 64;
+
+	/// <summary>
+	/// Creates a new, empty Flow Matrix with no sources and no sinks.
+	/// </summary>
+	FlowMatrix();
+
+	/// <summary>
+	/// Copying of Flow Matrix instances is forbidden.
+	/// </summary>
+	FlowMatrix(const FlowMatrix&) = delete;
+
+	/// <summary>
+	/// Adds the specified number of tainted bytes and a single write to the
+	/// flow from the specified source to the specified sink. The matrix grows
+	/// if the source or the sink are out of its bounds.
+	/// </summary>
+	/// <param name="source">
+	/// The index of the source.
+	/// </param>
+	/// <param name="sink">
+	/// The index of the sink.
+	/// </param>
+	/// <param name="taintedBytes">
+	/// The number of tainted bytes of the source written to the sink.
+	/// </param>
+	void add(uint32_t source, uint32_t sink, uint64_t taintedBytes);
+
+	/// <summary>
+	/// Exports the flow graph of this matrix to the specified file, as a
+	/// compact adjacency list. The file starts with the line "sources N",
+	/// followed by one line per source: its index, kind code, total bytes,
+	/// labeled bytes and name, separated by spaces. The sinks follow in the
+	/// same way, after the line "sinks N", with their tainted bytes instead
+	/// of their labeled bytes. The line "flows N" then precedes one line per
+	/// source with flows: its index, followed by a "sink:tainted_bytes:writes"
+	/// entry for each sink it flows into. Names are last on their line, so
+	/// that they may hold spaces.
+	/// </summary>
+	/// <param name="file">
+	/// The name of the file to which the graph is to be written.
+	/// </param>
+	/// <param name="sourceNodes">
+	/// The sources, indexed by source.
+	/// </param>
+	/// <param name="sinkNodes">
+	/// The sinks, indexed by sink.
+	/// </param>
+	/// <returns>
+	/// True if the file was written successfully, false otherwise.
+	/// </returns>
+	bool exportAdjacency(const std::string &file,
+		const std::vector<FlowNode> &sourceNodes,
+		const std::vector<FlowNode> &sinkNodes) const;
+
+	/// <summary>
+	/// Exports all of the non-zero flows of this matrix to the specified file
+	/// in binary format. The file starts with the header: the magic string
+	/// "FDTFLOWS", followed by the format version, the number of sources and
+	/// the number of sinks as little endian 32 bit integers, and the number of
+	/// flows as a 64 bit integer. Each flow is then stored as the 32 bit source
+	/// index, the 32 bit sink index and the 64 bit tainted bytes and writes.
+	/// </summary>
+	/// <param name="file">
+	/// The name of the file to which the matrix is to be written.
+	/// </param>
+	/// <returns>
+	/// True if the file was written successfully, false otherwise.
+	/// </returns>
+	bool exportBinary(const std::string &file) const;
+
+	/// <summary>
+	/// Exports all of the non-zero flows of this matrix to the specified file
+	/// in CSV format, with the header line:
+	/// "source,sink,source_name,sink_name,tainted_bytes,writes".
+	/// </summary>
+	/// <param name="file">
+	/// The name of the file to which the matrix is to be written.
+	/// </param>
+	/// <param name="sourceNames">
+	/// The names of the sources, indexed by source.
+	/// </param>
+	/// <param name="sinkNames">
+	/// The names of the sinks, indexed by sink.
+	/// </param>
+	/// <returns>
+	/// True if the file was written successfully, false otherwise.
+	/// </returns>
+	bool exportCSV(const std::string &file,
+		const std::vector<std::string> &sourceNames,
+		const std::vector<std::string> &sinkNames) const;
+
+	/// <summary>
+	/// Exports the flow graph of this matrix to the specified file in
+	/// GraphViz DOT format. Every source and sink is a node, labeled with its
+	/// name and with its kind and totals as attributes, and every non-zero
+	/// flow is an edge weighted by its tainted bytes and writes.
+	/// </summary>
+	/// <param name="file">
+	/// The name of the file to which the graph is to be written.
+	/// </param>
+	/// <param name="name">
+	/// The name of the graph.
+	/// </param>
+	/// <param name="sourceNodes">
+	/// The sources, indexed by source.
+	/// </param>
+	/// <param name="sinkNodes">
+	/// The sinks, indexed by sink.
+	/// </param>
+	/// <returns>
+	/// True if the file was written successfully, false otherwise.
+	/// </returns>
+	bool exportDOT(const std::string &file, const std::string &name,
+		const std::vector<FlowNode> &sourceNodes,
+		const std::vector<FlowNode> &sinkNodes) const;
+
+	/// <summary>
+	/// Calls the specified function for each non-zero flow of the matrix. The
+	/// flows are visited block by block.
+	/// </summary>
+	/// <param name="function">
+	/// The function, which is passed the source index, the sink index and the
+	/// flow.
+	/// </param>
+	void forEach(const std::function<void(uint32_t, uint32_t,
+		const FlowCell&)> &function) const;
+
+	/// <summary>
+	/// Calls the specified function for each non-zero flow of the matrix, in
+	/// ascending order of the source index, and then of the sink index. Each
+	/// allocated block is still only visited once per row of it.
+	/// </summary>
+	/// <param name="function">
+	/// The function, which is passed the source index, the sink index and the
+	/// flow.
+	/// </param>
+	void forEachBySource(const std::function<void(uint32_t, uint32_t,
+		const FlowCell&)> &function) const;
+
+	/// <summary>
+	/// Calls the specified function for each non-zero flow into the specified
+	/// sink, in ascending order of the source index.
+	/// </summary>
+	/// <param name="sink">
+	/// The index of the sink.
+	/// </param>
+	/// <param name="function">
+	/// The function, which is passed the source index and the flow.
+	/// </param>
+	void forEachInSink(uint32_t sink, const std::function<void(uint32_t,
+		const FlowCell&)> &function) const;
+
+	/// <summary>
+	/// Returns the flow from the specified source to the specified sink.
+	/// </summary>
+	/// <param name="source">
+	/// The index of the source.
+	/// </param>
+	/// <param name="sink">
+	/// The index of the sink.
+	/// </param>
+	/// <returns>
+	/// The flow. If no flow was recorded, both of its counters are zero.
+	/// </returns>
+	FlowCell get(uint32_t source, uint32_t sink) const;
+
+	/// <summary>
+	/// Returns the number of sources (rows) of this matrix.
+	/// </summary>
+	/// <returns>
+	/// The number of sources.
+	/// </returns>
+	uint32_t getSources() const;
+
+	/// <summary>
+	/// Returns the number of sinks (columns) of this matrix.
+	/// </summary>
+	/// <returns>
+	/// The number of sinks.
+	/// </returns>
+	uint32_t getSinks() const;
+
+	/// <summary>
+	/// Grows this matrix so that it has at least the specified number of
+	/// sources and sinks. The matrix never shrinks.
+	/// </summary>
+	/// <param name="sources">
+	/// The minimum number of sources.
+	/// </param>
+	/// <param name="sinks">
+	/// The minimum number of sinks.
+	/// </param>
+	void resize(uint32_t sources, uint32_t sinks);
+
+	/// <summary>
+	/// Assignment of Flow Matrix instances is forbidden.
+	/// </summary>
+	FlowMatrix& operator=(const FlowMatrix&) = delete;
+protected:
+	/// <summary>
+	/// Returns the index of the block in the blocks vector which holds the
+	/// specified block row and column, or <see cref="NO_BLOCK"/>.
+	/// </summary>
+	uint32_t getBlock(uint32_t blockRow, uint32_t blockColumn) const;
+
+	static const uint32_t NO_BLOCK = UINT32_MAX;
+
+	uint32_t sources;                          // # of Rows
+	uint32_t sinks;                            // # of Columns
+	uint32_t blockColumns;                     // # of Columns of Blocks
+
+	std::vector<uint32_t> blockIndices;        // { Block Row, Column ->
+	                                           //   Block # in cells }
+	std::vector<FlowCell> cells;               // Cells of allocated blocks
+};
+
+#endif
@@ -0,0 +1,87 @@
+#include "dependency_tracker_mappings.h"
+
+#include <algorithm>
+
+/****************************** SOURCE MAPPING ******************************/
+SourceMapping::SourceMapping(target_ulong start, uint32_t length,
+		const std::vector<uint32_t> &labels) {
+	this->start = start;
+	this->length = length;
+	this->labels = labels;
+
+	// Count the pages touched by the mapping, which need not be page aligned
+	target_ulong firstPage = start & TARGET_PAGE_MASK;
+	target_ulong lastPage = (start + length - 1) & TARGET_PAGE_MASK;
+	this->remaining = (length == 0) ? 0 :
+		(lastPage - firstPage) / TARGET_PAGE_SIZE + 1;
+	this->labeled.resize(this->remaining, false);
+	this->cursor = 0;
+}
+
+const std::vector<uint32_t>& SourceMapping::getLabels() const {
+	return this->labels;
+}
+
+uint32_t SourceMapping::getRemainingPages() const {
+	return this->remaining;
+}
+
+bool SourceMapping::overlaps(target_ulong start, uint32_t length) const {
+	return start < this->start + this->length &&
+		this->start < start + length;
+}
+
+uint32_t SourceMapping::visit(uint32_t budget,
+		const std::function<bool(target_ulong, uint32_t)> &label) {
+	uint32_t pages = this->labeled.size();
+	uint32_t labeledPages = 0;
+
+	for (uint32_t i = 0; i < pages && budget > 0 && this->remaining > 0; ++i) {
+		uint32_t page = this->cursor;
+		this->cursor = (this->cursor + 1) % pages;
+		if (this->labeled[page]) continue;
+		--budget;
+
+		if (this->visitPage(page, label)) ++labeledPages;
+	}
+
+	return labeledPages;
+}
+
+uint32_t SourceMapping::visitRange(target_ulong start, uint32_t length,
+		const std::function<bool(target_ulong, uint32_t)> &label) {
+	if (length == 0 || this->remaining == 0 || !this->overlaps(start, length))
+		return 0;
+
+	// Find the pages of the mapping which the range touches
+	target_ulong base = this->start & TARGET_PAGE_MASK;
+	target_ulong from = std::max(start, this->start);
+	target_ulong to = std::min<target_ulong>(start + length,
+		this->start + this->length);
+	uint32_t first = ((from & TARGET_PAGE_MASK) - base) / TARGET_PAGE_SIZE;
+	uint32_t last = (((to - 1) & TARGET_PAGE_MASK) - base) / TARGET_PAGE_SIZE;
+
+	uint32_t labeledPages = 0;
+	for (uint32_t page = first; page <= last; ++page) {
+		if (this->labeled[page]) continue;
+		if (this->visitPage(page, label)) ++labeledPages;
+	}
+
+	return labeledPages;
+}
+
+bool SourceMapping::visitPage(uint32_t page,
+		const std::function<bool(target_ulong, uint32_t)> &label) {
+	// Clip the page to the mapping, for the first and the last page
+	target_ulong pageStart = (this->start & TARGET_PAGE_MASK) +
+		page * TARGET_PAGE_SIZE;
+	target_ulong from = std::max(pageStart, this->start);
+	target_ulong to = std::min<target_ulong>(pageStart + TARGET_PAGE_SIZE,
+		this->start + this->length);
+	if (!label(from, to - from)) return false;
+
+	this->labeled[page] = true;
+	--this->remaining;
+	return true;
+}
+/****************************** SOURCE MAPPING ******************************/
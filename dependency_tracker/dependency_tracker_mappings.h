@@ -0,0 +1,128 @@
+#ifndef DEPENDENCY_TRACKER_MAPPINGS
+#define DEPENDENCY_TRACKER_MAPPINGS
+
+#include <functional>
+#include <stdint.h>
+#include <vector>
+
+#include "panda/plugin.h"
+
+/// <summary>
+/// Class which represents a mapping of a source into the memory of a process,
+/// whose pages are yet to be labeled. Pages of a mapping only become resident
+/// once they are touched, so the pages are labeled one at a time as they are
+/// found resident, and the mapping remembers which pages were labeled.
+/// </summary>
+class SourceMapping {
+public:
+	/// <summary>
+	/// Creates a new Source Mapping, with none of its pages labeled.
+	/// </summary>
+	/// <param name="start">
+	/// The virtual address at which the source is mapped.
+	/// </param>
+	/// <param name="length">
+	/// The length of the mapping, in bytes.
+	/// </param>
+	/// <param name="labels">
+	/// The labels with which the mapped data is to be labeled, one per
+	/// configuration in which the mapped target is a source.
+	/// </param>
+	SourceMapping(target_ulong start, uint32_t length,
+		const std::vector<uint32_t> &labels);
+
+	/// <summary>
+	/// Returns the labels with which the mapped data is to be labeled.
+	/// </summary>
+	/// <returns>
+	/// The constant reference to the labels.
+	/// </returns>
+	const std::vector<uint32_t>& getLabels() const;
+
+	/// <summary>
+	/// Returns the number of pages which were not labeled yet.
+	/// </summary>
+	/// <returns>
+	/// The number of pages.
+	/// </returns>
+	uint32_t getRemainingPages() const;
+
+	/// <summary>
+	/// Checks if the mapping overlaps the specified range of virtual memory.
+	/// </summary>
+	/// <param name="start">
+	/// The virtual address of the range.
+	/// </param>
+	/// <param name="length">
+	/// The length of the range, in bytes.
+	/// </param>
+	/// <returns>
+	/// True if the mapping overlaps the range, false otherwise.
+	/// </returns>
+	bool overlaps(target_ulong start, uint32_t length) const;
+
+	/// <summary>
+	/// Visits up to <paramref="budget"/> pages which were not labeled yet, in
+	/// a round robin fashion, so that every page is eventually visited. The 
+	/// pages for which the label function succeeds are marked as labeled.
+	/// </summary>
+	/// <param name="budget">
+	/// The maximum number of pages to be visited.
+	/// </param>
+	/// <param name="label">
+	/// The function which labels the part of the page covered by the mapping,
+	/// given its virtual address and its length. It returns true if the page
+	/// was labeled, or false if it should be visited again later.
+	/// </param>
+	/// <returns>
+	/// The number of pages labeled.
+	/// </returns>
+	uint32_t visit(uint32_t budget,
+		const std::function<bool(target_ulong, uint32_t)> &label);
+
+	/// <summary>
+	/// Visits every page which was not labeled yet and overlaps the specified
+	/// range of virtual memory, regardless of any budget. This labels pages 
+	/// on their first access, when the address of the access is known. The 
+	/// pages for which the label function succeeds are marked as labeled.
+	/// </summary>
+	/// <param name="start">
+	/// The virtual address of the range.
+	/// </param>
+	/// <param name="length">
+	/// The length of the range, in bytes.
+	/// </param>
+	/// <param name="label">
+	/// The function which labels the part of the page covered by the mapping,
+	/// see <see cref="visit"/>.
+	/// </param>
+	/// <returns>
+	/// The number of pages labeled.
+	/// </returns>
+	uint32_t visitRange(target_ulong start, uint32_t length,
+		const std::function<bool(target_ulong, uint32_t)> &label);
+protected:
+	/// <summary>
+	/// Visits the specified page of the mapping, which was not labeled yet.
+	/// </summary>
+	/// <param name="page">
+	/// The index of the page, from the first page of the mapping.
+	/// </param>
+	/// <param name="label">
+	/// The function which labels the part of the page covered by the mapping.
+	/// </param>
+	/// <returns>
+	/// True if the page was labeled, false otherwise.
+	/// </returns>
+	bool visitPage(uint32_t page,
+		const std::function<bool(target_ulong, uint32_t)> &label);
+
+	target_ulong start;                        // Start of Mapping
+	uint32_t length;                           // Length of Mapping, in bytes
+	std::vector<uint32_t> labels;              // Labels of Mapped Data
+	std::vector<bool> labeled;                 // { Page -> Labeled? }
+	uint32_t remaining;                        // # of pages not labeled
+	uint32_t cursor;                           // Next page to be visited
+};
+
+#endif
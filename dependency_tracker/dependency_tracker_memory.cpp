@@ -0,0 +1,78 @@
+#include "dependency_tracker_memory.h"
+
+#include <algorithm>
+
+/******************************** PAGE  RUNS ********************************/
+PageRuns::PageRuns() {
+	this->mappedBytes = 0;
+	this->position = 0;
+	this->contiguous = false;
+}
+
+void PageRuns::add(CPUState *cpu, target_ulong vAddr, uint32_t length) {
+	while (length > 0) {
+		// Translate the page once, and cover as much of it as possible
+		uint32_t offset = vAddr & ~TARGET_PAGE_MASK;
+		uint32_t chunk = std::min<uint32_t>(length, TARGET_PAGE_SIZE - offset);
+		hwaddr pAddr = panda_virt_to_phys(cpu, vAddr);
+
+		if (pAddr == (hwaddr)(-1)) {
+			// The page is not mapped, so the next run cannot be merged with
+			// the last run.
+			this->contiguous = false;
+		} else if (this->contiguous &&
+				this->runs.back().pAddr + this->runs.back().length == pAddr) {
+			this->runs.back().length += chunk;
+			this->mappedBytes += chunk;
+		} else {
+			this->runs.push_back(PageRun{ pAddr, this->position, chunk });
+			this->mappedBytes += chunk;
+			this->contiguous = true;
+		}
+
+		vAddr += chunk;
+		length -= chunk;
+		this->position += chunk;
+	}
+}
+
+void PageRuns::add(CPUState *cpu, const GuestIOVec *segments, uint32_t count,
+		uint32_t length) {
+	this->add(cpu, segments, count, 0, length);
+}
+
+void PageRuns::add(CPUState *cpu, const GuestIOVec *segments, uint32_t count,
+		uint32_t offset, uint32_t length) {
+	for (uint32_t i = 0; i < count && length > 0; ++i) {
+		// Skip the segments, and the part of the segment, before the offset
+		if (offset >= segments[i].length) {
+			offset -= segments[i].length;
+			this->position += segments[i].length;
+			this->contiguous = false;
+			continue;
+		}
+
+		uint32_t segmentLength = std::min(segments[i].length - offset, length);
+		this->position += offset;
+		this->contiguous = this->contiguous && offset == 0;
+		this->add(cpu, segments[i].base + offset, segmentLength);
+		length -= segmentLength;
+		offset = 0;
+	}
+}
+
+void PageRuns::clear() {
+	this->runs.clear();
+	this->mappedBytes = 0;
+	this->position = 0;
+	this->contiguous = false;
+}
+
+uint64_t PageRuns::getMappedBytes() const {
+	return this->mappedBytes;
+}
+
+const std::vector<PageRun>& PageRuns::getRuns() const {
+	return this->runs;
+}
+/******************************** PAGE  RUNS ********************************/
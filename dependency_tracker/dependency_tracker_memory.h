@@ -0,0 +1,123 @@
+#ifndef DEPENDENCY_TRACKER_MEMORY
+#define DEPENDENCY_TRACKER_MEMORY
+
+#include <stdint.h>
+#include <vector>
+
+#include "panda/plugin.h"
+
+#include "../dependency_common/guest_memory.h"
+
+/// <summary>
+/// Structure which represents a run of physically contiguous guest memory.
+/// </summary>
+struct PageRun {
+	hwaddr pAddr;                              // Physical Address of Run
+	uint32_t offset;                           // Offset of Run in Buffers
+	uint32_t length;                           // Length of Run, in bytes
+};
+
+/// <summary>
+/// Class which translates guest buffers into runs of physically contiguous
+/// memory. Each page of a buffer is translated only once, and pages which are
+/// adjacent in physical memory are merged into a single run, also across the
+/// segments of a vectored buffer. Pages which are not mapped are skipped. An
+/// instance is meant to be reused for every buffer, so that translating a
+/// buffer does not allocate once the runs have grown to their largest size.
+/// </summary>
+class PageRuns {
+public:
+	/// <summary>
+	/// Creates a new, empty set of Page Runs.
+	/// </summary>
+	PageRuns();
+
+	/// <summary>
+	/// Translates the buffer at the specified virtual address and of the
+	/// specified length, and appends its runs to these runs.
+	/// </summary>
+	/// <param name="cpu">
+	/// The CPU State pointer.
+	/// </param>
+	/// <param name="vAddr">
+	/// The virtual address of the buffer.
+	/// </param>
+	/// <param name="length">
+	/// The length of the buffer, in bytes.
+	/// </param>
+	void add(CPUState *cpu, target_ulong vAddr, uint32_t length);
+
+	/// <summary>
+	/// Translates the first <paramref="length"/> bytes of the buffer described
+	/// by the specified segments, and appends their runs to these runs.
+	/// </summary>
+	/// <param name="cpu">
+	/// The CPU State pointer.
+	/// </param>
+	/// <param name="segments">
+	/// The segments of the buffer, in order.
+	/// </param>
+	/// <param name="count">
+	/// The number of segments.
+	/// </param>
+	/// <param name="length">
+	/// The number of bytes of the buffer to be translated. Segments past this
+	/// length are ignored.
+	/// </param>
+	void add(CPUState *cpu, const GuestIOVec *segments, uint32_t count,
+		uint32_t length);
+
+	/// <summary>
+	/// Translates <paramref="length"/> bytes of the buffer described by the
+	/// specified segments, starting <paramref="offset"/> bytes into the 
+	/// buffer, and appends their runs to these runs.
+	/// </summary>
+	/// <param name="cpu">
+	/// The CPU State pointer.
+	/// </param>
+	/// <param name="segments">
+	/// The segments of the buffer, in order.
+	/// </param>
+	/// <param name="count">
+	/// The number of segments.
+	/// </param>
+	/// <param name="offset">
+	/// The number of bytes at the start of the buffer which are skipped.
+	/// </param>
+	/// <param name="length">
+	/// The number of bytes of the buffer to be translated.
+	/// </param>
+	void add(CPUState *cpu, const GuestIOVec *segments, uint32_t count,
+		uint32_t offset, uint32_t length);
+
+	/// <summary>
+	/// Removes all of the runs.
+	/// </summary>
+	void clear();
+
+	/// <summary>
+	/// Returns the number of bytes which are covered by the runs, that is the
+	/// number of bytes of the buffers which are mapped.
+	/// </summary>
+	/// <returns>
+	/// The number of bytes.
+	/// </returns>
+	uint64_t getMappedBytes() const;
+
+	/// <summary>
+	/// Returns the runs, in the order of the buffers which were added. The 
+	/// offset of each run counts the bytes of all of the buffers added before
+	/// it, mapped or not, since the runs were last cleared.
+	/// </summary>
+	/// <returns>
+	/// The constant reference to the runs.
+	/// </returns>
+	const std::vector<PageRun>& getRuns() const;
+protected:
+	std::vector<PageRun> runs;                 // Physically Contiguous Runs
+	uint64_t mappedBytes;                      // # of bytes covered by runs
+	uint32_t position;                         // # of bytes added
+	bool contiguous;                           // Can the last run be merged?
+};
+
+#endif
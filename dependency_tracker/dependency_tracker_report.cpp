@@ -0,0 +1,99 @@
+#include "dependency_tracker_report.h"
+
+#include <stdio.h>
+
+// Names of the fields, which are the keys of the JSON Lines format and the
+// columns of the CSV format, by field.
+static const char *FIELD_NAMES[] = {
+	"event", "configuration", "instruction", "target", "source", "bytes",
+	"tainted", "records", "dropped"
+};
+
+/****************************** REPORT ENCODER ******************************/
+ReportEncoder::ReportEncoder() {
+	this->format = ReportFormat::JSONLines;
+	this->type = "";
+	for (size_t i = 0; i < FIELDS; ++i) this->isSet[i] = false;
+}
+
+void ReportEncoder::begin(const char *type) {
+	this->type = type;
+	for (size_t i = 0; i < FIELDS; ++i) this->isSet[i] = false;
+}
+
+void ReportEncoder::end(std::string &text) {
+	if (this->format == ReportFormat::CSV) {
+		text += this->type;
+		for (size_t i = 0; i < FIELDS; ++i) {
+			text += ',';
+			if (this->isSet[i]) text += this->values[i];
+		}
+	} else {
+		text += "{\"record\":\"";
+		text += this->type;
+		text += '"';
+		for (size_t i = 0; i < FIELDS; ++i) {
+			if (!this->isSet[i]) continue;
+
+			text += ",\"";
+			text += FIELD_NAMES[i];
+			text += "\":";
+			text += this->values[i];
+		}
+		text += '}';
+	}
+
+	text += '\n';
+}
+
+std::string ReportEncoder::getHeader() const {
+	if (this->format != ReportFormat::CSV) return "";
+
+	std::string header = "record";
+	for (size_t i = 0; i < FIELDS; ++i) {
+		header += ',';
+		header += FIELD_NAMES[i];
+	}
+
+	return header + "\n";
+}
+
+void ReportEncoder::set(ReportField field, const std::string &value) {
+	size_t i = static_cast<size_t>(field);
+	this->values[i].clear();
+	this->quote(value, this->values[i]);
+	this->isSet[i] = true;
+}
+
+void ReportEncoder::set(ReportField field, uint64_t value) {
+	size_t i = static_cast<size_t>(field);
+	this->values[i] = std::to_string(value);
+	this->isSet[i] = true;
+}
+
+void ReportEncoder::setFormat(ReportFormat format) {
+	this->format = format;
+}
+
+void ReportEncoder::quote(const std::string &value, std::string &text) const {
+	text += '"';
+	for (char c : value) {
+		if (this->format == ReportFormat::CSV) {
+			// Quotes are escaped by doubling them, and nothing else is
+			if (c == '"') text += '"';
+			text += c;
+		} else if (c == '"' || c == '\\') {
+			text += '\\';
+			text += c;
+		} else if (static_cast<unsigned char>(c) < 0x20) {
+			// Control characters, which file names may hold, are escaped
+			char escaped[8];
+			snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+			text += escaped;
+		} else {
+			text += c;
+		}
+	}
+	text += '"';
+}
+/****************************** REPORT ENCODER ******************************/
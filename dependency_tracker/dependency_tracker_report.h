@@ -0,0 +1,116 @@
+#ifndef DEPENDENCY_TRACKER_REPORT
+#define DEPENDENCY_TRACKER_REPORT
+
+#include <stdint.h>
+#include <string>
+
+/// <summary>
+/// Enumeration of the formats of the streaming report.
+/// </summary>
+enum class ReportFormat : uint8_t {
+	JSONLines,                                 // One JSON Object per Line
+	CSV                                        // One Row per Line
+};
+
+/// <summary>
+/// Enumeration of the fields of the records of the streaming report, in the
+/// order of the columns of the CSV format.
+/// </summary>
+enum class ReportField : uint8_t {
+	Event,                                     // Name of the Event
+	Configuration,                             // Name of the Configuration
+	Instruction,                               // Instruction Count
+	Target,                                    // Name of the Target
+	Source,                                    // Name of the Source Target
+	Bytes,                                     // # of Bytes Moved
+	Tainted,                                   // # of Bytes Tainted
+	Records,                                   // # of Records Written
+	Dropped,                                   // # of Records Dropped
+	Count                                      // # of Fields
+};
+
+/// <summary>
+/// Class which encodes the records of the streaming report as lines of text.
+/// Every record has a type, and any subset of the <see cref="ReportField"/>
+/// fields. In JSON Lines format, a record is an object which only holds the
+/// fields which were set. In CSV format, a record is a row which holds every
+/// field, with the fields which were not set left empty.
+/// </summary>
+class ReportEncoder {
+public:
+	/// <summary>
+	/// Creates a new Report Encoder, which encodes records as JSON Lines.
+	/// </summary>
+	ReportEncoder();
+
+	/// <summary>
+	/// Starts a new record of the specified type, clearing every field.
+	/// </summary>
+	/// <param name="type">
+	/// The static name of the type of the record.
+	/// </param>
+	void begin(const char *type);
+
+	/// <summary>
+	/// Appends the line of text of the current record, including its trailing
+	/// newline, to the specified string.
+	/// </summary>
+	/// <param name="text">
+	/// The string to which the line is appended.
+	/// </param>
+	void end(std::string &text);
+
+	/// <summary>
+	/// Returns the line which must precede the records, which is the header
+	/// row of the CSV format, and empty for the JSON Lines format.
+	/// </summary>
+	/// <returns>
+	/// The header line, including its trailing newline, if any.
+	/// </returns>
+	std::string getHeader() const;
+
+	/// <summary>
+	/// Sets the specified field of the current record to a string.
+	/// </summary>
+	/// <param name="field">
+	/// The field.
+	/// </param>
+	/// <param name="value">
+	/// The value of the field, which is quoted and escaped as needed.
+	/// </param>
+	void set(ReportField field, const std::string &value);
+
+	/// <summary>
+	/// Sets the specified field of the current record to a number.
+	/// </summary>
+	/// <param name="field">
+	/// The field.
+	/// </param>
+	/// <param name="value">
+	/// The value of the field.
+	/// </param>
+	void set(ReportField field, uint64_t value);
+
+	/// <summary>
+	/// Sets the format in which records are encoded.
+	/// </summary>
+	/// <param name="format">
+	/// The format.
+	/// </param>
+	void setFormat(ReportFormat format);
+protected:
+	/// <summary>
+	/// Appends the specified string to the specified text, quoted and escaped
+	/// for the format of this encoder.
+	/// </summary>
+	void quote(const std::string &value, std::string &text) const;
+
+	static const size_t FIELDS = static_cast<size_t>(ReportField::Count);
+
+	ReportFormat format;                       // Format of the Records
+	const char *type;                          // Type of Current Record
+	std::string values[FIELDS];                // Encoded Values of Fields
+	bool isSet[FIELDS];                        // Was the Field Set?
+};
+
+#endif
@@ -0,0 +1,140 @@
+#include "dependency_tracker_series.h"
+
+// Number of counters of each target which are kept in the series: bytes,
+// tainted bytes, operations and mapped bytes
+static const size_t SERIES_COUNTERS = 4;
+
+/***************************** INTERVAL SERIES ******************************/
+IntervalSeries::IntervalSeries() {
+	this->interval = 0;
+	this->start = 0;
+	this->next = UINT64_MAX;
+	this->targets = nullptr;
+	this->rows = 0;
+	this->snapshots = 0;
+}
+
+bool IntervalSeries::close(uint64_t instruction,
+		const std::vector<std::unique_ptr<Configuration>> &configurations) {
+	if (!this->isOpen()) return true;
+
+	bool written = this->snapshot(instruction, configurations);
+	this->ofs.close();
+	this->next = UINT64_MAX;
+	return written && !this->ofs.fail();
+}
+
+uint64_t IntervalSeries::getRows() const {
+	return this->rows;
+}
+
+uint64_t IntervalSeries::getSnapshots() const {
+	return this->snapshots;
+}
+
+bool IntervalSeries::isDue(uint64_t instruction) const {
+	return instruction >= this->next;
+}
+
+bool IntervalSeries::isOpen() const {
+	return this->ofs.is_open();
+}
+
+bool IntervalSeries::open(const std::string &file, uint64_t interval,
+		const TargetTable &targets) {
+	if (interval == 0) return false;
+
+	this->ofs.open(file, std::ios::out | std::ios::trunc);
+	if (!this->ofs.is_open()) return false;
+
+	this->ofs << "start,end,configuration,type,target,bytes,tainted_bytes," <<
+		"operations,mapped_bytes\n";
+	this->interval = interval;
+	this->start = 0;
+	this->next = interval;
+	this->targets = &targets;
+	return this->ofs.good();
+}
+
+bool IntervalSeries::snapshot(uint64_t instruction,
+		const std::vector<std::unique_ptr<Configuration>> &configurations) {
+	if (!this->isOpen()) return false;
+
+	for (auto &dirtyRow : this->dirtyRows) {
+		uint32_t table = dirtyRow.first, row = dirtyRow.second;
+		const Configuration &configuration = *configurations[table / 2];
+		bool isSink = (table % 2) != 0;
+
+		// Fetch the counters of the target as of now, in the order of the
+		// columns of the series
+		uint64_t counters[SERIES_COUNTERS];
+		Target target;
+		if (isSink) {
+			const TargetSinks &sinks = configuration.sinks;
+			target = sinks.getTarget(row);
+			counters[0] = sinks.getTotalBytes(row);
+			counters[1] = sinks.getTotalTaintBytes(row);
+			counters[2] = sinks.getTotalWrites(row);
+			counters[3] = 0;
+		} else {
+			const TargetSources &sources = configuration.sources;
+			target = sources.getTarget(row);
+			counters[0] = sources.getTotalBytes(row);
+			counters[1] = sources.getLabeledBytes(row);
+			counters[2] = sources.getTotalReads(row);
+			counters[3] = sources.getMappedBytes(row);
+		}
+
+		uint64_t *totals = &this->totals[table][row * SERIES_COUNTERS];
+		this->ofs << this->start << "," << instruction << ",\"" <<
+			configuration.name << "\"," << (isSink ? "sink" : "source") <<
+			",\"" << this->targets->getName(target) << "\"";
+		for (size_t i = 0; i < SERIES_COUNTERS; ++i) {
+			this->ofs << ",";
+			if (!isSink || i + 1 < SERIES_COUNTERS)
+				this->ofs << counters[i] - totals[i];
+			totals[i] = counters[i];
+		}
+		this->ofs << "\n";
+
+		this->dirty[table][row] = 0;
+		++this->rows;
+	}
+
+	// The next interval ends on the next multiple of the interval length, so
+	// that late snapshots do not shift the boundaries of later intervals.
+	this->dirtyRows.clear();
+	this->start = instruction;
+	this->next = (instruction / this->interval + 1) * this->interval;
+	++this->snapshots;
+
+	this->ofs.flush();
+	return this->ofs.good();
+}
+
+void IntervalSeries::touchSink(uint32_t configuration, uint32_t sink) {
+	this->touch(configuration * 2 + 1, sink);
+}
+
+void IntervalSeries::touchSource(uint32_t configuration, uint32_t source) {
+	this->touch(configuration * 2, source);
+}
+
+void IntervalSeries::touch(uint32_t table, uint32_t row) {
+	if (!this->isOpen()) return;
+
+	// The tables grow lazily, as targets are discovered during the replay
+	if (table >= this->dirty.size()) {
+		this->dirty.resize(table + 1);
+		this->totals.resize(table + 1);
+	}
+	if (row >= this->dirty[table].size()) {
+		this->dirty[table].resize(row + 1, 0);
+		this->totals[table].resize((row + 1) * SERIES_COUNTERS, 0);
+	}
+
+	if (this->dirty[table][row]) return;
+	this->dirty[table][row] = 1;
+	this->dirtyRows.emplace_back(table, row);
+}
+/***************************** INTERVAL SERIES ******************************/
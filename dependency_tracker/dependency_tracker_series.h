@@ -0,0 +1,183 @@
+#ifndef DEPENDENCY_TRACKER_SERIES
+#define DEPENDENCY_TRACKER_SERIES
+
+#include <fstream>
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "dependency_tracker_config.h"
+#include "dependency_tracker_targets.h"
+
+/// <summary>
+/// Class which appends the changes of the counters of the sources and sinks
+/// of every configuration to a time series file, once per interval of guest
+/// instructions, so that it is known when data flowed and not only how much.
+///
+/// Each source and sink is touched when its counters change, which adds it to
+/// a list of dirty targets the first time in an interval. A snapshot only
+/// visits the dirty targets, so its cost is proportional to the number of
+/// targets touched in the interval rather than to the number of targets.
+///
+/// The file is in CSV format, with the header line:
+/// "start,end,configuration,type,target,bytes,tainted_bytes,operations,
+/// mapped_bytes". Each snapshot appends one row per dirty target, with the
+/// instruction counts at which the interval started and ended, and the
+/// change of its number of bytes read or written, of tainted bytes read or
+/// written, of reads or writes and, for sources, of bytes labeled through
+/// mappings.
+/// </summary>
+class IntervalSeries {
+public:
+	/// <summary>
+	/// Creates a new Interval Series, which is not open.
+	/// </summary>
+	IntervalSeries();
+
+	/// <summary>
+	/// Copying of Interval Series instances is forbidden.
+	/// </summary>
+	IntervalSeries(const IntervalSeries&) = delete;
+
+	/// <summary>
+	/// Takes the last snapshot, of the interval which ends at the specified
+	/// instruction count, and closes the file.
+	/// </summary>
+	/// <param name="instruction">
+	/// The instruction count at which the replay ended.
+	/// </param>
+	/// <param name="configurations">
+	/// The configurations whose counters are snapshotted.
+	/// </param>
+	/// <returns>
+	/// True if the series was written successfully, false otherwise.
+	/// </returns>
+	bool close(uint64_t instruction,
+		const std::vector<std::unique_ptr<Configuration>> &configurations);
+
+	/// <summary>
+	/// Returns the number of rows appended to the series.
+	/// </summary>
+	/// <returns>
+	/// The number of rows.
+	/// </returns>
+	uint64_t getRows() const;
+
+	/// <summary>
+	/// Returns the number of snapshots taken.
+	/// </summary>
+	/// <returns>
+	/// The number of snapshots.
+	/// </returns>
+	uint64_t getSnapshots() const;
+
+	/// <summary>
+	/// Checks if the current interval has ended at the specified instruction
+	/// count, so that a snapshot is due.
+	/// </summary>
+	/// <param name="instruction">
+	/// The current instruction count.
+	/// </param>
+	/// <returns>
+	/// True if the series is open and a snapshot is due, false otherwise.
+	/// </returns>
+	bool isDue(uint64_t instruction) const;
+
+	/// <summary>
+	/// Checks if the series file is open.
+	/// </summary>
+	/// <returns>
+	/// True if the series is open, false otherwise.
+	/// </returns>
+	bool isOpen() const;
+
+	/// <summary>
+	/// Creates the specified series file, and writes its header.
+	/// </summary>
+	/// <param name="file">
+	/// The name of the series file.
+	/// </param>
+	/// <param name="interval">
+	/// The length of an interval, in instructions, which must not be zero.
+	/// </param>
+	/// <param name="targets">
+	/// The table from which the names of targets are fetched, which must
+	/// outlive the series.
+	/// </param>
+	/// <returns>
+	/// True if the series was opened, false otherwise.
+	/// </returns>
+	bool open(const std::string &file, uint64_t interval,
+		const TargetTable &targets);
+
+	/// <summary>
+	/// Appends the changes of the counters of the targets touched since the
+	/// last snapshot, and starts the next interval.
+	/// </summary>
+	/// <param name="instruction">
+	/// The instruction count at which the interval ended.
+	/// </param>
+	/// <param name="configurations">
+	/// The configurations whose counters are snapshotted.
+	/// </param>
+	/// <returns>
+	/// True if the snapshot was written successfully, false otherwise.
+	/// </returns>
+	bool snapshot(uint64_t instruction,
+		const std::vector<std::unique_ptr<Configuration>> &configurations);
+
+	/// <summary>
+	/// Marks the counters of the specified sink as changed in the current
+	/// interval.
+	/// </summary>
+	/// <param name="configuration">
+	/// The index of the configuration of the sink.
+	/// </param>
+	/// <param name="sink">
+	/// The index of the sink in its configuration.
+	/// </param>
+	void touchSink(uint32_t configuration, uint32_t sink);
+
+	/// <summary>
+	/// Marks the counters of the specified source as changed in the current
+	/// interval.
+	/// </summary>
+	/// <param name="configuration">
+	/// The index of the configuration of the source.
+	/// </param>
+	/// <param name="source">
+	/// The index of the source in its configuration.
+	/// </param>
+	void touchSource(uint32_t configuration, uint32_t source);
+
+	/// <summary>
+	/// Assignment of Interval Series instances is forbidden.
+	/// </summary>
+	IntervalSeries& operator=(const IntervalSeries&) = delete;
+protected:
+	/// <summary>
+	/// Marks the specified row of the specified table as dirty, if it is not
+	/// already. The sources of a configuration are in the table at twice its
+	/// index, and its sinks in the next table.
+	/// </summary>
+	void touch(uint32_t table, uint32_t row);
+
+	std::ofstream ofs;                         // Series File
+	uint64_t interval;                         // Instructions per Interval
+	uint64_t start;                            // Start of Current Interval
+	uint64_t next;                             // End of Current Interval
+	const TargetTable *targets;                // Names of the Targets
+
+	std::vector<std::vector<uint8_t>> dirty;   // { Table -> Row -> Dirty? }
+	std::vector<std::vector<uint64_t>> totals; // Counters at Last Snapshot
+
+	// The table and the row of each dirty target, in the order touched
+	std::vector<std::pair<uint32_t, uint32_t>> dirtyRows;
+
+	uint64_t rows;                             // # of Rows Appended
+	uint64_t snapshots;                        // # of Snapshots Taken
+};
+
+#endif
@@ -0,0 +1,124 @@
+#include "dependency_tracker_shadow.h"
+
+#include <algorithm>
+#include <iterator>
+
+/******************************* LABEL SHADOW *******************************/
+LabelShadow::LabelShadow() {
+	this->readOffset = 0;
+	this->writeOffset = 0;
+}
+
+uint64_t LabelShadow::consume(uint64_t length) {
+	uint64_t offset = this->readOffset;
+	this->erase(offset, length);
+	this->readOffset += length;
+
+	return offset;
+}
+
+bool LabelShadow::empty() const {
+	return this->ranges.empty();
+}
+
+void LabelShadow::erase(uint64_t start, uint64_t length) {
+	if (length == 0) return;
+	uint64_t end = start + length;
+
+	// Split the ranges at both ends, so that the range to be erased is made
+	// of whole ranges.
+	this->split(start);
+	this->split(end);
+	this->ranges.erase(this->ranges.lower_bound(start),
+		this->ranges.lower_bound(end));
+}
+
+void LabelShadow::forEach(const std::function<void(uint64_t, uint64_t,
+		const std::vector<uint32_t>&)> &function) const {
+	for (auto &range : this->ranges)
+		function(range.first, range.second.end, range.second.labels);
+}
+
+uint64_t LabelShadow::getReadOffset() const {
+	return this->readOffset;
+}
+
+uint64_t LabelShadow::produce(uint64_t length) {
+	uint64_t offset = this->writeOffset;
+	this->writeOffset += length;
+
+	return offset;
+}
+
+void LabelShadow::slice(uint64_t start, uint64_t length,
+		const std::vector<uint32_t> &extra,
+		std::vector<ShadowSpan> &spans) const {
+	uint64_t end = start + length;
+	uint64_t position = start;
+
+	// Start at the last range which starts before the slice, since it may
+	// overlap the slice.
+	auto it = this->ranges.upper_bound(start);
+	if (it != this->ranges.begin()) --it;
+
+	for (; it != this->ranges.end() && it->first < end; ++it) {
+		uint64_t rangeStart = std::max(it->first, start);
+		uint64_t rangeEnd = std::min(it->second.end, end);
+		if (rangeStart >= rangeEnd) continue;
+
+		// Fill the gap before this range with the extra labels
+		if (position < rangeStart && !extra.empty()) {
+			spans.push_back(ShadowSpan{ position - start, rangeStart - start,
+				extra });
+		}
+
+		ShadowSpan span{ rangeStart - start, rangeEnd - start, {} };
+		std::set_union(it->second.labels.begin(), it->second.labels.end(),
+			extra.begin(), extra.end(), std::back_inserter(span.labels));
+		spans.push_back(std::move(span));
+		position = rangeEnd;
+	}
+
+	// Fill the gap after the last range with the extra labels
+	if (position < end && !extra.empty())
+		spans.push_back(ShadowSpan{ position - start, end - start, extra });
+}
+
+void LabelShadow::write(uint64_t start, uint64_t length,
+		const std::vector<ShadowSpan> &spans) {
+	this->erase(start, length);
+
+	for (auto &span : spans) {
+		if (span.start >= length || span.labels.empty()) continue;
+		uint64_t spanStart = start + span.start;
+		uint64_t spanEnd = start + std::min(span.end, length);
+
+		// Extend the previous range instead, if it ends where this span
+		// starts and carries the same labels.
+		auto previous = this->ranges.lower_bound(spanStart);
+		if (previous != this->ranges.begin()) {
+			--previous;
+			if (previous->second.end == spanStart &&
+					previous->second.labels == span.labels) {
+				previous->second.end = spanEnd;
+				continue;
+			}
+		}
+
+		this->ranges[spanStart] = Range{ spanEnd, span.labels };
+	}
+}
+
+void LabelShadow::split(uint64_t offset) {
+	auto it = this->ranges.upper_bound(offset);
+	if (it == this->ranges.begin()) return;
+	--it;
+
+	// Nothing to split if the range starts at the offset, or ends before it
+	if (it->first == offset || it->second.end <= offset) return;
+
+	Range tail{ it->second.end, it->second.labels };
+	it->second.end = offset;
+	this->ranges.emplace(offset, std::move(tail));
+}
+/******************************* LABEL SHADOW *******************************/
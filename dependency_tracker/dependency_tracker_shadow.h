@@ -0,0 +1,163 @@
+#ifndef DEPENDENCY_TRACKER_SHADOW
+#define DEPENDENCY_TRACKER_SHADOW
+
+#include <functional>
+#include <map>
+#include <stdint.h>
+#include <vector>
+
+/// <summary>
+/// Structure which represents a range of bytes which is occupied by the same
+/// set of labels.
+/// </summary>
+struct ShadowSpan {
+	uint64_t start;                            // First Byte of Span
+	uint64_t end;                              // One Past Last Byte of Span
+	std::vector<uint32_t> labels;              // Sorted Labels of Span
+};
+
+/// <summary>
+/// Class which shadows the contents of a file or of a pipe inside the guest
+/// kernel with the labels that occupy each of its byte ranges. The ranges are
+/// stored in an interval map, so data can be copied between shadows and
+/// counted with range arithmetic, without any per-byte work. Bytes which are
+/// not covered by any range carry no labels.
+///
+/// Pipes have no offsets, so their shadow is a stream: data is appended at
+/// the write offset and consumed from the read offset.
+/// </summary>
+class LabelShadow {
+public:
+	/// <summary>
+	/// Creates a new, empty Label Shadow.
+	/// </summary>
+	LabelShadow();
+
+	/// <summary>
+	/// Advances the read offset of the stream by the specified number of
+	/// bytes, and erases the ranges which were consumed.
+	/// </summary>
+	/// <param name="length">
+	/// The number of bytes consumed.
+	/// </param>
+	/// <returns>
+	/// The read offset before it was advanced.
+	/// </returns>
+	uint64_t consume(uint64_t length);
+
+	/// <summary>
+	/// Checks if no range of this shadow carries any label.
+	/// </summary>
+	/// <returns>
+	/// True if this shadow is empty, false otherwise.
+	/// </returns>
+	bool empty() const;
+
+	/// <summary>
+	/// Erases the labels of the specified range, as happens when it is
+	/// overwritten with data which is not shadowed.
+	/// </summary>
+	/// <param name="start">
+	/// The first byte of the range.
+	/// </param>
+	/// <param name="length">
+	/// The length of the range, in bytes.
+	/// </param>
+	void erase(uint64_t start, uint64_t length);
+
+	/// <summary>
+	/// Calls the specified function for each range of this shadow, in 
+	/// ascending order.
+	/// </summary>
+	/// <param name="function">
+	/// The function, which is passed the first byte of the range, one past the
+	/// last byte of the range and the sorted labels of the range.
+	/// </param>
+	void forEach(const std::function<void(uint64_t, uint64_t,
+		const std::vector<uint32_t>&)> &function) const;
+
+	/// <summary>
+	/// Returns the read offset of the stream.
+	/// </summary>
+	/// <returns>
+	/// The read offset.
+	/// </returns>
+	uint64_t getReadOffset() const;
+
+	/// <summary>
+	/// Advances the write offset of the stream by the specified number of
+	/// bytes.
+	/// </summary>
+	/// <param name="length">
+	/// The number of bytes appended.
+	/// </param>
+	/// <returns>
+	/// The write offset before it was advanced.
+	/// </returns>
+	uint64_t produce(uint64_t length);
+
+	/// <summary>
+	/// Appends the spans occupying the specified range to the specified vector,
+	/// with offsets relative to the start of the range. Each span also carries
+	/// the specified extra labels, and the gaps between the ranges of this
+	/// shadow are filled with spans carrying only the extra labels, if there
+	/// are any.
+	/// </summary>
+	/// <param name="start">
+	/// The first byte of the range.
+	/// </param>
+	/// <param name="length">
+	/// The length of the range, in bytes.
+	/// </param>
+	/// <param name="extra">
+	/// The sorted labels which occupy every byte of the range, in addition to
+	/// the labels stored in this shadow.
+	/// </param>
+	/// <param name="spans">
+	/// The vector to which the spans are appended, in ascending order.
+	/// </param>
+	void slice(uint64_t start, uint64_t length,
+		const std::vector<uint32_t> &extra,
+		std::vector<ShadowSpan> &spans) const;
+
+	/// <summary>
+	/// Overwrites the range starting at the specified offset with the
+	/// specified spans, whose offsets are relative to that offset. Bytes of
+	/// the range which are not covered by any span lose their labels.
+	/// </summary>
+	/// <param name="start">
+	/// The first byte of the range.
+	/// </param>
+	/// <param name="length">
+	/// The length of the range, in bytes.
+	/// </param>
+	/// <param name="spans">
+	/// The spans to be written, in ascending order.
+	/// </param>
+	void write(uint64_t start, uint64_t length,
+		const std::vector<ShadowSpan> &spans);
+protected:
+	/// <summary>
+	/// Splits the range which contains the specified offset, if any, so that
+	/// a range starts at the offset.
+	/// </summary>
+	/// <param name="offset">
+	/// The offset at which to split.
+	/// </param>
+	void split(uint64_t offset);
+
+	/// <summary>
+	/// Structure which represents the end and the labels of a range. The start
+	/// of the range is its key in the interval map.
+	/// </summary>
+	struct Range {
+		uint64_t end;                          // One Past Last Byte of Range
+		std::vector<uint32_t> labels;          // Sorted Labels of Range
+	};
+
+	std::map<uint64_t, Range> ranges;          // { Start -> Range }
+	uint64_t readOffset;                       // Stream Read Offset
+	uint64_t writeOffset;                      // Stream Write Offset
+};
+
+#endif
@@ -0,0 +1,50 @@
+#include "dependency_tracker_sockets.h"
+
+/******************************** PEER CACHE ********************************/
+PeerCache::PeerCache(size_t capacity) {
+	this->capacity = (capacity == 0) ? 1 : capacity;
+}
+
+bool PeerCache::find(const Target &listener, const SocketAddress &peer,
+		Target &target) {
+	auto it = this->peers.find(std::make_pair(
+		listener ? listener.id + 1 : 0, peer));
+	if (it == this->peers.end()) return false;
+
+	// Move the peer to the front of the order, as the most recently used
+	this->order.splice(this->order.begin(), this->order, it->second);
+	target = it->second->second;
+	return true;
+}
+
+void PeerCache::insert(const Target &listener, const SocketAddress &peer,
+		const Target &target) {
+	Key key = std::make_pair(listener ? listener.id + 1 : 0, peer);
+	auto it = this->peers.find(key);
+	if (it != this->peers.end()) {
+		this->order.splice(this->order.begin(), this->order, it->second);
+		it->second->second = target;
+		return;
+	}
+
+	this->order.emplace_front(key, target);
+	this->peers[key] = this->order.begin();
+	this->evict();
+}
+
+size_t PeerCache::size() const {
+	return this->peers.size();
+}
+
+void PeerCache::setCapacity(size_t capacity) {
+	this->capacity = (capacity == 0) ? 1 : capacity;
+	this->evict();
+}
+
+void PeerCache::evict() {
+	while (this->peers.size() > this->capacity) {
+		this->peers.erase(this->order.back().first);
+		this->order.pop_back();
+	}
+}
+/******************************** PEER CACHE ********************************/
@@ -0,0 +1,110 @@
+#ifndef DEPENDENCY_TRACKER_SOCKETS
+#define DEPENDENCY_TRACKER_SOCKETS
+
+#include <deque>
+#include <list>
+#include <map>
+#include <stddef.h>
+#include <stdint.h>
+#include <utility>
+
+#include "../dependency_common/guest_memory.h"
+#include "dependency_tracker_targets.h"
+
+/// <summary>
+/// Structure which holds the UNIX sockets which connected to a path, and the
+/// sockets accepted on the path, which were not matched with each other yet.
+/// Either end of a connection may be seen first, and the ends are matched in
+/// the order in which they were seen.
+/// </summary>
+struct PendingPeers {
+	std::deque<Target> connected;              // Connected, Not Accepted
+	std::deque<Target> accepted;               // Accepted, Not Connected
+};
+
+/// <summary>
+/// Class which caches the network target which each peer is classified as, so
+/// that the peer of every datagram need not be formatted and looked up in the
+/// target table again. A peer is classified separately for each listening
+/// target of the local socket, since it may fall back to it. The cache holds
+/// a bounded number of peers, and evicts the least recently used peer once it
+/// is full.
+/// </summary>
+class PeerCache {
+public:
+	/// <summary>
+	/// Creates a new, empty Peer Cache.
+	/// </summary>
+	/// <param name="capacity">
+	/// The maximum number of peers cached.
+	/// </param>
+	PeerCache(size_t capacity = 4096);
+
+	/// <summary>
+	/// Looks up the cached classification of the specified peer, which makes
+	/// it the most recently used peer.
+	/// </summary>
+	/// <param name="listener">
+	/// The listening target of the local socket, or an invalid target if the
+	/// socket has none.
+	/// </param>
+	/// <param name="peer">
+	/// The address of the peer.
+	/// </param>
+	/// <param name="target">
+	/// The target which the peer was classified as, possibly invalid.
+	/// </param>
+	/// <returns>
+	/// True if the peer was already classified, false otherwise.
+	/// </returns>
+	bool find(const Target &listener, const SocketAddress &peer,
+		Target &target);
+
+	/// <summary>
+	/// Caches the classification of the specified peer, evicting the least 
+	/// recently used peer if the cache is full.
+	/// </summary>
+	/// <param name="listener">
+	/// The listening target of the local socket, or an invalid target if the
+	/// socket has none.
+	/// </param>
+	/// <param name="peer">
+	/// The address of the peer.
+	/// </param>
+	/// <param name="target">
+	/// The target which the peer was classified as, possibly invalid.
+	/// </param>
+	void insert(const Target &listener, const SocketAddress &peer,
+		const Target &target);
+
+	/// <summary>
+	/// Returns the number of peers classified.
+	/// </summary>
+	/// <returns>
+	/// The number of peers.
+	/// </returns>
+	size_t size() const;
+
+	/// <summary>
+	/// Sets the maximum number of peers cached, evicting the least recently
+	/// used peers which no longer fit.
+	/// </summary>
+	/// <param name="capacity">
+	/// The maximum number of peers, at least one.
+	/// </param>
+	void setCapacity(size_t capacity);
+protected:
+	typedef std::pair<uint32_t, SocketAddress> Key;
+	typedef std::list<std::pair<Key, Target>> Order;
+
+	/// <summary>
+	/// Evicts the least recently used peers until the cache fits.
+	/// </summary>
+	void evict();
+
+	size_t capacity;                           // Max # of Peers Cached
+	Order order;                               // Peers, Most Recent First
+	std::map<Key, Order::iterator> peers;      // { Listener ID+1, Peer -> T }
+};
+
+#endif
@@ -0,0 +1,500 @@
+#include "dependency_tracker_stats.h"
+
+#include <algorithm>
+#include <atomic>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// Columns of the sources, after the columns which describe their targets
+enum SourceColumn : uint32_t {
+	SOURCE_LABEL = TARGET_COLUMNS,
+	SOURCE_LABELED_BYTES,
+	SOURCE_MAPPED_BYTES,
+	SOURCE_TOTAL_BYTES,
+	SOURCE_TOTAL_READS,
+	SOURCE_VECTORED_READS,
+	SOURCE_COLUMNS
+};
+
+// Columns of the sinks, after the columns which describe their targets
+enum SinkColumn : uint32_t {
+	SINK_TOTAL_BYTES = TARGET_COLUMNS,
+	SINK_TOTAL_TAINT_BYTES,
+	SINK_TOTAL_WRITES,
+	SINK_VECTORED_WRITES,
+	SINK_COLUMNS
+};
+
+// Number of rows which counter columns have room for at first
+static const size_t MIN_ROWS = 16;
+
+// Address space reserved for the mapping of a stats file, which bounds its
+// size, and the size by which the file is grown at least
+static const size_t STATS_RESERVE = static_cast<size_t>(1) << 30;
+static const size_t STATS_CHUNK_SIZE = 1 << 20;
+
+/***************************** COUNTER  COLUMNS *****************************/
+CounterColumns::CounterColumns(uint32_t columns) {
+	this->columns = columns;
+	this->rows = 0;
+	this->capacity = 0;
+	this->data = nullptr;
+	this->file = nullptr;
+	this->table = NO_INDEX;
+}
+
+void CounterColumns::add(const Target &target) {
+	if (this->rows == this->capacity)
+		this->grow(std::max(MIN_ROWS, this->capacity * 2));
+
+	// The room past the last row is always zeroed, so only the target needs
+	// to be described.
+	this->describe(this->rows, target);
+	++this->rows;
+	if (this->file) this->file->setRows(this->table, this->rows);
+}
+
+bool CounterColumns::attach(StatsFile &file, uint32_t table,
+		const std::vector<Target> &targets) {
+	this->file = &file;
+	this->table = table;
+	this->grow(std::max(MIN_ROWS, this->capacity));
+	if (!this->file) return false;
+
+	for (uint32_t row = 0; row < this->rows; ++row)
+		this->describe(row, targets[row]);
+	file.setRows(table, this->rows);
+	return true;
+}
+
+uint64_t& CounterColumns::get(uint32_t row, uint32_t column) {
+	return this->data[column * this->capacity + row];
+}
+
+const uint64_t& CounterColumns::get(uint32_t row, uint32_t column) const {
+	return this->data[column * this->capacity + row];
+}
+
+void CounterColumns::grow(size_t capacity) {
+	// Allocate the new columns in the stats file, if attached to one. If the
+	// file is full, the columns are kept on the heap from then on, and the
+	// table of the file is no longer updated.
+	std::vector<uint64_t> heap;
+	uint64_t *data = this->file ?
+		this->file->allocate(this->columns * capacity) : nullptr;
+	if (!data) {
+		heap.resize(this->columns * capacity, 0);
+		data = heap.data();
+	}
+
+	for (uint32_t column = 0; this->data && column < this->columns;
+			++column) {
+		memcpy(data + column * capacity, this->data + column * this->capacity,
+			this->rows * sizeof(uint64_t));
+	}
+	this->data = data;
+	this->capacity = capacity;
+
+	if (heap.empty()) {
+		std::vector<uint64_t>().swap(this->heap);
+		this->file->moveTable(this->table, data, capacity);
+	} else {
+		this->heap.swap(heap);
+		this->file = nullptr;
+	}
+}
+
+void CounterColumns::describe(uint32_t row, const Target &target) {
+	uint64_t name = 0;
+	uint64_t kind = static_cast<uint64_t>(target.kind) << 32;
+	if (this->file) this->file->describe(target, name, kind);
+
+	this->get(row, 0) = name;
+	this->get(row, 1) = kind;
+}
+/***************************** COUNTER  COLUMNS *****************************/
+
+
+/**************************** TARGET  STATISTICS ****************************/
+uint32_t TargetStatistics::find(const Target &target) const {
+	// Targets beyond the end of the indices vector were interned after the
+	// last target was added, so they cannot be in this set.
+	if (!target || target.id >= this->indices.size()) return NO_INDEX;
+
+	uint32_t index = this->indices[target.id];
+	if (index == NO_INDEX || this->targets[index] != target) return NO_INDEX;
+	return index;
+}
+
+const Target& TargetStatistics::getTarget(uint32_t index) const {
+	return this->targets[index];
+}
+
+size_t TargetStatistics::size() const {
+	return this->targets.size();
+}
+
+std::pair<uint32_t, bool> TargetStatistics::insert(const Target &target) {
+	uint32_t existing = this->find(target);
+	if (existing != NO_INDEX) return std::make_pair(existing, false);
+
+	// Grow the indices vector so that it covers the target's ID. The IDs are
+	// dense, so this vector is never much larger than the target table.
+	if (target.id >= this->indices.size())
+		this->indices.resize(target.id + 1, NO_INDEX);
+
+	uint32_t index = this->targets.size();
+	this->targets.push_back(target);
+	this->indices[target.id] = index;
+	return std::make_pair(index, true);
+}
+/**************************** TARGET  STATISTICS ****************************/
+
+/****************************** TARGET SOURCES ******************************/
+TargetSources::TargetSources() : counters(SOURCE_COLUMNS) {
+
+}
+
+uint32_t TargetSources::add(const Target &target, uint32_t label) {
+	auto inserted = this->insert(target);
+	if (inserted.second) {
+		this->counters.add(target);
+		this->counters.get(inserted.first, SOURCE_LABEL) = label;
+	}
+
+	return inserted.first;
+}
+
+bool TargetSources::attach(StatsFile &file, uint32_t configuration,
+		const std::string &name) {
+	uint32_t table = file.addTable(StatsTable::Sources, configuration, name,
+		SOURCE_COLUMNS);
+	if (table == NO_INDEX) return false;
+
+	return this->counters.attach(file, table, this->targets);
+}
+
+uint32_t TargetSources::getLabel(uint32_t index) const {
+	return static_cast<uint32_t>(this->counters.get(index, SOURCE_LABEL));
+}
+
+uint64_t& TargetSources::getLabeledBytes(uint32_t index) {
+	return this->counters.get(index, SOURCE_LABELED_BYTES);
+}
+
+const uint64_t& TargetSources::getLabeledBytes(uint32_t index) const {
+	return this->counters.get(index, SOURCE_LABELED_BYTES);
+}
+
+uint64_t& TargetSources::getMappedBytes(uint32_t index) {
+	return this->counters.get(index, SOURCE_MAPPED_BYTES);
+}
+
+const uint64_t& TargetSources::getMappedBytes(uint32_t index) const {
+	return this->counters.get(index, SOURCE_MAPPED_BYTES);
+}
+
+uint64_t& TargetSources::getTotalBytes(uint32_t index) {
+	return this->counters.get(index, SOURCE_TOTAL_BYTES);
+}
+
+const uint64_t& TargetSources::getTotalBytes(uint32_t index) const {
+	return this->counters.get(index, SOURCE_TOTAL_BYTES);
+}
+
+uint64_t& TargetSources::getTotalReads(uint32_t index) {
+	return this->counters.get(index, SOURCE_TOTAL_READS);
+}
+
+const uint64_t& TargetSources::getTotalReads(uint32_t index) const {
+	return this->counters.get(index, SOURCE_TOTAL_READS);
+}
+
+uint64_t& TargetSources::getVectoredReads(uint32_t index) {
+	return this->counters.get(index, SOURCE_VECTORED_READS);
+}
+
+const uint64_t& TargetSources::getVectoredReads(uint32_t index) const {
+	return this->counters.get(index, SOURCE_VECTORED_READS);
+}
+/****************************** TARGET SOURCES ******************************/
+
+/******************************* TARGET SINKS *******************************/
+TargetSinks::TargetSinks() : counters(SINK_COLUMNS) {
+
+}
+
+uint32_t TargetSinks::add(const Target &target) {
+	auto inserted = this->insert(target);
+	if (inserted.second) this->counters.add(target);
+
+	return inserted.first;
+}
+
+bool TargetSinks::attach(StatsFile &file, uint32_t configuration,
+		const std::string &name) {
+	uint32_t table = file.addTable(StatsTable::Sinks, configuration, name,
+		SINK_COLUMNS);
+	if (table == NO_INDEX) return false;
+
+	return this->counters.attach(file, table, this->targets);
+}
+
+uint64_t& TargetSinks::getTotalBytes(uint32_t index) {
+	return this->counters.get(index, SINK_TOTAL_BYTES);
+}
+
+const uint64_t& TargetSinks::getTotalBytes(uint32_t index) const {
+	return this->counters.get(index, SINK_TOTAL_BYTES);
+}
+
+uint64_t& TargetSinks::getTotalTaintBytes(uint32_t index) {
+	return this->counters.get(index, SINK_TOTAL_TAINT_BYTES);
+}
+
+const uint64_t& TargetSinks::getTotalTaintBytes(uint32_t index) const {
+	return this->counters.get(index, SINK_TOTAL_TAINT_BYTES);
+}
+
+uint64_t& TargetSinks::getTotalWrites(uint32_t index) {
+	return this->counters.get(index, SINK_TOTAL_WRITES);
+}
+
+const uint64_t& TargetSinks::getTotalWrites(uint32_t index) const {
+	return this->counters.get(index, SINK_TOTAL_WRITES);
+}
+
+uint64_t& TargetSinks::getVectoredWrites(uint32_t index) {
+	return this->counters.get(index, SINK_VECTORED_WRITES);
+}
+
+const uint64_t& TargetSinks::getVectoredWrites(uint32_t index) const {
+	return this->counters.get(index, SINK_VECTORED_WRITES);
+}
+/******************************* TARGET SINKS *******************************/
+
+/***************************** TARGET  CHANNELS *****************************/
+uint32_t TargetChannels::add(const Target &target) {
+	auto inserted = this->insert(target);
+	if (inserted.second) {
+		this->bytesRead.push_back(0);
+		this->bytesWritten.push_back(0);
+		this->reads.push_back(0);
+		this->writes.push_back(0);
+	}
+
+	return inserted.first;
+}
+
+uint64_t& TargetChannels::getBytesRead(uint32_t index) {
+	return this->bytesRead[index];
+}
+
+const uint64_t& TargetChannels::getBytesRead(uint32_t index) const {
+	return this->bytesRead[index];
+}
+
+uint64_t& TargetChannels::getBytesWritten(uint32_t index) {
+	return this->bytesWritten[index];
+}
+
+const uint64_t& TargetChannels::getBytesWritten(uint32_t index) const {
+	return this->bytesWritten[index];
+}
+
+uint64_t& TargetChannels::getReads(uint32_t index) {
+	return this->reads[index];
+}
+
+const uint64_t& TargetChannels::getReads(uint32_t index) const {
+	return this->reads[index];
+}
+
+uint64_t& TargetChannels::getWrites(uint32_t index) {
+	return this->writes[index];
+}
+
+const uint64_t& TargetChannels::getWrites(uint32_t index) const {
+	return this->writes[index];
+}
+/***************************** TARGET  CHANNELS *****************************/
+
+/******************************** STATS FILE ********************************/
+StatsFile::StatsFile() {
+	this->fd = -1;
+	this->data = nullptr;
+	this->reserved = 0;
+	this->size = 0;
+	this->position = 0;
+	this->tables = 0;
+	this->usedTables = 0;
+	this->targets = nullptr;
+}
+
+StatsFile::~StatsFile() {
+	this->release();
+}
+
+uint32_t StatsFile::addTable(StatsTable type, uint32_t configuration,
+		const std::string &name, uint32_t columns) {
+	if (!this->isOpen() || this->usedTables >= this->tables) return NO_INDEX;
+
+	uint64_t offset = this->reserve(name.size());
+	if (offset == 0) return NO_INDEX;
+	memcpy(this->data + offset, name.data(), name.size());
+
+	uint32_t table = this->usedTables++;
+	const uint32_t fields[] = { static_cast<uint32_t>(type), columns,
+		configuration, static_cast<uint32_t>(name.size()) };
+	memcpy(this->getEntry(table, 0), fields, sizeof(fields));
+	*this->getEntry(table, 16) = offset;
+
+	// Count the table in the header last, so that readers never see an
+	// entry which is only partially written.
+	memcpy(this->data + 12, &this->usedTables, sizeof(this->usedTables));
+	return table;
+}
+
+uint64_t* StatsFile::allocate(size_t counters) {
+	uint64_t offset = this->reserve(counters * sizeof(uint64_t));
+	if (offset == 0) return nullptr;
+
+	return reinterpret_cast<uint64_t*>(this->data + offset);
+}
+
+bool StatsFile::close() {
+	if (!this->isOpen()) {
+		this->release();
+		return false;
+	}
+
+	// Drop the room which was never allocated, once the counters are flushed
+	bool written = msync(this->data, this->size, MS_SYNC) == 0;
+	size_t size = this->position;
+	int file = this->fd;
+	munmap(this->data, this->reserved);
+	this->data = nullptr;
+	this->fd = -1;
+
+	if (ftruncate(file, size) != 0) written = false;
+	if (::close(file) != 0) written = false;
+	return written;
+}
+
+void StatsFile::describe(const Target &target, uint64_t &name,
+		uint64_t &kind) {
+	std::string text = this->targets->getName(target);
+	kind = (static_cast<uint64_t>(target.kind) << 32) |
+		static_cast<uint32_t>(text.size());
+
+	name = this->reserve(text.size());
+	if (name != 0) memcpy(this->data + name, text.data(), text.size());
+}
+
+bool StatsFile::isOpen() const {
+	return this->data != nullptr;
+}
+
+void StatsFile::moveTable(uint32_t table, const uint64_t *data,
+		size_t capacity) {
+	// The generation is odd while the entry is being updated, so that readers
+	// can tell that they read it halfway. The fences keep the stores to the
+	// entry from being reordered before the odd generation or after the even
+	// one.
+	uint64_t generation;
+	memcpy(&generation, this->data + 32, sizeof(generation));
+	++generation;
+	memcpy(this->data + 32, &generation, sizeof(generation));
+	std::atomic_thread_fence(std::memory_order_release);
+
+	*this->getEntry(table, 32) = capacity;
+	*this->getEntry(table, 40) = reinterpret_cast<const uint8_t*>(data) -
+		this->data;
+
+	std::atomic_thread_fence(std::memory_order_release);
+	++generation;
+	memcpy(this->data + 32, &generation, sizeof(generation));
+}
+
+bool StatsFile::open(const std::string &file, const TargetTable &targets,
+		uint32_t tables) {
+	this->release();
+
+	this->fd = ::open(file.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (this->fd < 0) return false;
+
+	// Reserve the address space of the whole file at once. Only the part of
+	// it which the file was grown to may be touched.
+	void *data = mmap(nullptr, STATS_RESERVE, PROT_READ | PROT_WRITE,
+		MAP_SHARED, this->fd, 0);
+	if (data == MAP_FAILED) {
+		this->release();
+		return false;
+	}
+
+	this->data = static_cast<uint8_t*>(data);
+	this->reserved = STATS_RESERVE;
+	this->tables = tables;
+	this->targets = &targets;
+
+	// Grow the file past the header and the directory, which come first
+	this->position = HEADER_SIZE + tables * ENTRY_SIZE;
+	if (this->reserve(0) == 0) {
+		this->release();
+		return false;
+	}
+
+	const uint32_t version = 1;
+	memcpy(this->data, "FDTSTATS", 8);
+	memcpy(this->data + 8, &version, sizeof(version));
+	return true;
+}
+
+void StatsFile::setInstruction(uint64_t instruction) {
+	memcpy(this->data + 16, &instruction, sizeof(instruction));
+}
+
+void StatsFile::setRows(uint32_t table, size_t rows) {
+	*this->getEntry(table, 24) = rows;
+}
+
+uint64_t StatsFile::reserve(size_t bytes) {
+	if (!this->isOpen()) return 0;
+
+	size_t offset = (this->position + 7) & ~static_cast<size_t>(7);
+	if (bytes > this->reserved - offset) return 0;
+
+	// Grow the file by whole chunks, so that it is seldom truncated
+	size_t end = offset + bytes;
+	if (end > this->size) {
+		size_t size = std::min(this->reserved, (end + STATS_CHUNK_SIZE - 1) /
+			STATS_CHUNK_SIZE * STATS_CHUNK_SIZE);
+		if (ftruncate(this->fd, size) != 0) return 0;
+		this->size = size;
+	}
+
+	this->position = end;
+	memcpy(this->data + 24, &this->position, sizeof(uint64_t));
+	return offset;
+}
+
+uint64_t* StatsFile::getEntry(uint32_t table, size_t offset) {
+	return reinterpret_cast<uint64_t*>(this->data + HEADER_SIZE +
+		table * ENTRY_SIZE + offset);
+}
+
+void StatsFile::release() {
+	if (this->data) munmap(this->data, this->reserved);
+	if (this->fd >= 0) ::close(this->fd);
+
+	this->data = nullptr;
+	this->fd = -1;
+	this->reserved = 0;
+	this->size = 0;
+	this->position = 0;
+	this->tables = 0;
+	this->usedTables = 0;
+}
+/******************************** STATS FILE ********************************/
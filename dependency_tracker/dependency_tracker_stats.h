@@ -0,0 +1,864 @@
+#ifndef DEPENDENCY_TRACKER_STATS
+#define DEPENDENCY_TRACKER_STATS
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "dependency_tracker_targets.h"
+
+const uint32_t NO_INDEX = UINT32_MAX;          // Not a Source/Sink
+const uint32_t TARGET_COLUMNS = 2;             // Columns Describing Targets
+
+class StatsFile;
+
+/// <summary>
+/// Class which stores the counters of a set of targets column by column, as
+/// one contiguous array per counter, indexed by the index of the target. The
+/// first <see cref="TARGET_COLUMNS"/> columns describe the target of each 
+/// row, see <see cref="StatsFile"/>. The arrays are kept on the heap until
+/// they are attached to a table of a <see cref="StatsFile"/>, from then on
+/// they are kept in the mapped file, so updating a counter writes the file.
+/// </summary>
+class CounterColumns {
+public:
+	/// <summary>
+	/// Creates a new set of counter columns, with no rows.
+	/// </summary>
+	/// <param name="columns">
+	/// The number of columns, including the columns which describe targets.
+	/// </param>
+	CounterColumns(uint32_t columns);
+
+	/// <summary>
+	/// Copying of Counter Columns instances is forbidden.
+	/// </summary>
+	CounterColumns(const CounterColumns&) = delete;
+
+	/// <summary>
+	/// Appends a row for the specified target, with all of its counters set to
+	/// zero.
+	/// </summary>
+	/// <param name="target">
+	/// The target of the row.
+	/// </param>
+	void add(const Target &target);
+
+	/// <summary>
+	/// Moves the columns into the specified table of the specified stats 
+	/// file, and describes the target of each row in it. If the file has no
+	/// room for the columns, they are kept where they are.
+	/// </summary>
+	/// <param name="file">
+	/// The stats file, which must stay open for as long as the counters are
+	/// used.
+	/// </param>
+	/// <param name="table">
+	/// The index of the table, as returned by the file.
+	/// </param>
+	/// <param name="targets">
+	/// The target of each row.
+	/// </param>
+	/// <returns>
+	/// True if the columns were moved into the file, false otherwise.
+	/// </returns>
+	bool attach(StatsFile &file, uint32_t table,
+		const std::vector<Target> &targets);
+
+	/// <summary>
+	/// Returns a reference to the specified counter of the specified row.
+	/// </summary>
+	/// <param name="row">
+	/// The index of the row.
+	/// </param>
+	/// <param name="column">
+	/// The index of the column.
+	/// </param>
+	/// <returns>
+	/// The reference to the counter.
+	/// </returns>
+	uint64_t& get(uint32_t row, uint32_t column);
+
+	/// <summary>
+	/// Returns a constant reference to the specified counter of the specified
+	/// row.
+	/// </summary>
+	/// <param name="row">
+	/// The index of the row.
+	/// </param>
+	/// <param name="column">
+	/// The index of the column.
+	/// </param>
+	/// <returns>
+	/// The constant reference to the counter.
+	/// </returns>
+	const uint64_t& get(uint32_t row, uint32_t column) const;
+
+	/// <summary>
+	/// Assignment of Counter Columns instances is forbidden.
+	/// </summary>
+	CounterColumns& operator=(const CounterColumns&) = delete;
+protected:
+	/// <summary>
+	/// Moves the columns to new arrays with room for the specified number of
+	/// rows, in the stats file if they are attached to one, or on the heap.
+	/// </summary>
+	void grow(size_t capacity);
+
+	/// <summary>
+	/// Writes the columns which describe the target of the specified row.
+	/// </summary>
+	void describe(uint32_t row, const Target &target);
+
+	uint32_t columns;                          // # of Columns
+	size_t rows;                               // # of Rows
+	size_t capacity;                           // # of Rows with Room
+	uint64_t *data;                            // { Column, Row -> Counter }
+	std::vector<uint64_t> heap;                // Columns, if not Attached
+
+	StatsFile *file;                           // Stats File, if Attached
+	uint32_t table;                            // Table in the Stats File
+};
+
+/// <summary>
+/// Class which stores a set of targets and maps each target to its index in
+/// the set. The statistics of the targets are stored by the derived classes
+/// in contiguous arrays (one array per statistic), indexed by the index of the
+/// target, so updating a counter of a target touches a single array element.
+/// The sources and the sinks keep their arrays in <see cref="CounterColumns"/>
+/// so that they can be moved into a <see cref="StatsFile"/>.
+/// </summary>
+class TargetStatistics {
+public:
+	/// <summary>
+	/// Copying of Target Statistics instances is forbidden.
+	/// </summary>
+	TargetStatistics(const TargetStatistics&) = delete;
+
+	/// <summary>
+	/// Returns the index of the specified target in this set.
+	/// </summary>
+	/// <param name="target">
+	/// The target whose index is to be fetched.
+	/// </param>
+	/// <returns>
+	/// The index of the target, or <see cref="NO_INDEX"/> if the target is not
+	/// in this set.
+	/// </returns>
+	uint32_t find(const Target &target) const;
+
+	/// <summary>
+	/// Returns a constant reference to the target at the specified index.
+	/// </summary>
+	/// <param name="index">
+	/// The index of the target.
+	/// </param>
+	/// <returns>
+	/// The constant reference to the target.
+	/// </returns>
+	const Target& getTarget(uint32_t index) const;
+
+	/// <summary>
+	/// Returns the number of targets in this set.
+	/// </summary>
+	/// <returns>
+	/// The number of targets.
+	/// </returns>
+	size_t size() const;
+
+	/// <summary>
+	/// Assignment of Target Statistics instances is forbidden.
+	/// </summary>
+	TargetStatistics& operator=(const TargetStatistics&) = delete;
+protected:
+	/// <summary>
+	/// Creates a new, empty set of targets.
+	/// </summary>
+	TargetStatistics() = default;
+
+	/// <summary>
+	/// Adds the specified target to this set, if it is not already in it.
+	/// </summary>
+	/// <param name="target">
+	/// The target to be added.
+	/// </param>
+	/// <returns>
+	/// The index of the target, and whether it was newly added.
+	/// </returns>
+	std::pair<uint32_t, bool> insert(const Target &target);
+
+	std::vector<Target> targets;               // { Index -> Target }
+	std::vector<uint32_t> indices;             // { Target ID -> Index }
+};
+
+/// <summary>
+/// Class which stores the statistics of all of the source targets, and the
+/// taint label with which the data of each source is labeled.
+/// </summary>
+class TargetSources : public TargetStatistics {
+public:
+	/// <summary>
+	/// Creates a new, empty set of source targets.
+	/// </summary>
+	TargetSources();
+
+	/// <summary>
+	/// Adds the specified target to the sources, with all of its statistics
+	/// set to zero. If the target already is a source, nothing is changed.
+	/// </summary>
+	/// <param name="target">
+	/// The target to be added.
+	/// </param>
+	/// <param name="label">
+	/// The taint label with which the data of the source is to be labeled.
+	/// </param>
+	/// <returns>
+	/// The index of the source.
+	/// </returns>
+	uint32_t add(const Target &target, uint32_t label);
+
+	/// <summary>
+	/// Moves the label and the statistics of the sources into a new table of
+	/// the specified stats file.
+	/// </summary>
+	/// <param name="file">
+	/// The stats file.
+	/// </param>
+	/// <param name="configuration">
+	/// The index of the configuration of the sources.
+	/// </param>
+	/// <param name="name">
+	/// The name of the configuration of the sources.
+	/// </param>
+	/// <returns>
+	/// True if the sources were moved into the file, false otherwise.
+	/// </returns>
+	bool attach(StatsFile &file, uint32_t configuration, 
+		const std::string &name);
+
+	/// <summary>
+	/// Returns the taint label of the source at the specified index.
+	/// </summary>
+	/// <param name="index">
+	/// The index of the source.
+	/// </param>
+	/// <returns>
+	/// The label.
+	/// </returns>
+	uint32_t getLabel(uint32_t index) const;
+
+	/// <summary>
+	/// Returns a reference to the number of labeled bytes of the source at
+	/// the specified index. This should be set when any data of the source
+	/// target is labeled.
+	/// </summary>
+	/// <param name="index">
+	/// The index of the source.
+	/// </param>
+	/// <returns>
+	/// A reference to the value.
+	/// </returns>
+	uint64_t& getLabeledBytes(uint32_t index);
+
+	/// <summary>
+	/// Returns a constant reference to the number of labeled bytes of the
+	/// source at the specified index.
+	/// </summary>
+	/// <param name="index">
+	/// The index of the source.
+	/// </param>
+	/// <returns>
+	/// A constant reference to the value.
+	/// </returns>
+	const uint64_t& getLabeledBytes(uint32_t index) const;
+
+	/// <summary>
+	/// Returns a reference to the number of bytes of the source at the 
+	/// specified index which were labeled in the memory of a process which
+	/// mapped the source. These bytes are not counted as read.
+	/// </summary>
+	/// <param name="index">
+	/// The index of the source.
+	/// </param>
+	/// <returns>
+	/// A reference to the value.
+	/// </returns>
+	uint64_t& getMappedBytes(uint32_t index);
+
+	/// <summary>
+	/// Returns a constant reference to the number of bytes of the source at
+	/// the specified index which were labeled in the memory of a process which
+	/// mapped the source.
+	/// </summary>
+	/// <param name="index">
+	/// The index of the source.
+	/// </param>
+	/// <returns>
+	/// A constant reference to the value.
+	/// </returns>
+	const uint64_t& getMappedBytes(uint32_t index) const;
+
+	/// <summary>
+	/// Returns a reference to the number of bytes read from the source at the
+	/// specified index.
+	/// </summary>
+	/// <param name="index">
+	/// The index of the source.
+	/// </param>
+	/// <returns>
+	/// The reference to the number of bytes.
+	/// </returns>
+	uint64_t& getTotalBytes(uint32_t index);
+
+	/// <summary>
+	/// Returns a constant reference to the number of bytes read from the
+	/// source at the specified index.
+	/// </summary>
+	/// <param name="index">
+	/// The index of the source.
+	/// </param>
+	/// <returns>
+	/// The constant reference to the number of bytes.
+	/// </returns>
+	const uint64_t& getTotalBytes(uint32_t index) const;
+
+	/// <summary>
+	/// Returns a reference to the number of times the source at the specified
+	/// index was read from.
+	/// </summary>
+	/// <param name="index">
+	/// The index of the source.
+	/// </param>
+	/// <returns>
+	/// The reference to the number of times.
+	/// </returns>
+	uint64_t& getTotalReads(uint32_t index);
+
+	/// <summary>
+	/// Returns a constant reference to the number of times the source at the
+	/// specified index was read from.
+	/// </summary>
+	/// <param name="index">
+	/// The index of the source.
+	/// </param>
+	/// <returns>
+	/// The constant reference to the number of times.
+	/// </returns>
+	const uint64_t& getTotalReads(uint32_t index) const;
+
+	/// <summary>
+	/// Returns a reference to the number of times the source at the specified
+	/// index was read from with a vectored read (readv, preadv). These reads
+	/// are also counted in the total number of reads.
+	/// </summary>
+	/// <param name="index">
+	/// The index of the source.
+	/// </param>
+	/// <returns>
+	/// The reference to the number of times.
+	/// </returns>
+	uint64_t& getVectoredReads(uint32_t index);
+
+	/// <summary>
+	/// Returns a constant reference to the number of times the source at the
+	/// specified index was read from with a vectored read.
+	/// </summary>
+	/// <param name="index">
+	/// The index of the source.
+	/// </param>
+	/// <returns>
+	/// The constant reference to the number of times.
+	/// </returns>
+	const uint64_t& getVectoredReads(uint32_t index) const;
+protected:
+	// The taint label of each source, the number of tainted bytes read from
+	// it, of tainted bytes mapped, of bytes read from it, of times it was
+	// read from and of vectored reads, in this order
+	CounterColumns counters;
+};
+
+/// <summary>
+/// Class which stores the statistics of all of the sink targets. The flows of
+/// each source into each sink are stored in a <see cref="FlowMatrix"/>.
+/// </summary>
+class TargetSinks : public TargetStatistics {
+public:
+	/// <summary>
+	/// Creates a new, empty set of sink targets.
+	/// </summary>
+	TargetSinks();
+
+	/// <summary>
+	/// Adds the specified target to the sinks, with all of its statistics set
+	/// to zero. If the target already is a sink, nothing is changed.
+	/// </summary>
+	/// <param name="target">
+	/// The target to be added.
+	/// </param>
+	/// <returns>
+	/// The index of the sink.
+	/// </returns>
+	uint32_t add(const Target &target);
+
+	/// <summary>
+	/// Moves the statistics of the sinks into a new table of the specified 
+	/// stats file.
+	/// </summary>
+	/// <param name="file">
+	/// The stats file.
+	/// </param>
+	/// <param name="configuration">
+	/// The index of the configuration of the sinks.
+	/// </param>
+	/// <param name="name">
+	/// The name of the configuration of the sinks.
+	/// </param>
+	/// <returns>
+	/// True if the sinks were moved into the file, false otherwise.
+	/// </returns>
+	bool attach(StatsFile &file, uint32_t configuration, 
+		const std::string &name);
+
+	/// <summary>
+	/// Returns a reference to the number of bytes written to the sink at the
+	/// specified index.
+	/// </summary>
+	/// <param name="index">
+	/// The index of the sink.
+	/// </param>
+	/// <returns>
+	/// The reference to the number of bytes.
+	/// </returns>
+	uint64_t& getTotalBytes(uint32_t index);
+
+	/// <summary>
+	/// Returns a constant reference to the number of bytes written to the
+	/// sink at the specified index.
+	/// </summary>
+	/// <param name="index">
+	/// The index of the sink.
+	/// </param>
+	/// <returns>
+	/// The constant reference to the number of bytes.
+	/// </returns>
+	const uint64_t& getTotalBytes(uint32_t index) const;
+
+	/// <summary>
+	/// Returns a reference to the number of tainted bytes written to the sink
+	/// at the specified index.
+	/// </summary>
+	/// <param name="index">
+	/// The index of the sink.
+	/// </param>
+	/// <returns>
+	/// The reference to the number of tainted bytes.
+	/// </returns>
+	uint64_t& getTotalTaintBytes(uint32_t index);
+
+	/// <summary>
+	/// Returns a constant reference to the number of tainted bytes written to
+	/// the sink at the specified index.
+	/// </summary>
+	/// <param name="index">
+	/// The index of the sink.
+	/// </param>
+	/// <returns>
+	/// The constant reference to the number of tainted bytes.
+	/// </returns>
+	const uint64_t& getTotalTaintBytes(uint32_t index) const;
+
+	/// <summary>
+	/// Returns a reference to the number of times the sink at the specified
+	/// index was written to.
+	/// </summary>
+	/// <param name="index">
+	/// The index of the sink.
+	/// </param>
+	/// <returns>
+	/// The reference to the number of times.
+	/// </returns>
+	uint64_t& getTotalWrites(uint32_t index);
+
+	/// <summary>
+	/// Returns a constant reference to the number of times the sink at the
+	/// specified index was written to.
+	/// </summary>
+	/// <param name="index">
+	/// The index of the sink.
+	/// </param>
+	/// <returns>
+	/// The constant reference to the number of times.
+	/// </returns>
+	const uint64_t& getTotalWrites(uint32_t index) const;
+
+	/// <summary>
+	/// Returns a reference to the number of times the sink at the specified
+	/// index was written to with a vectored write (writev, pwritev). These
+	/// writes are also counted in the total number of writes.
+	/// </summary>
+	/// <param name="index">
+	/// The index of the sink.
+	/// </param>
+	/// <returns>
+	/// The reference to the number of times.
+	/// </returns>
+	uint64_t& getVectoredWrites(uint32_t index);
+
+	/// <summary>
+	/// Returns a constant reference to the number of times the sink at the
+	/// specified index was written to with a vectored write.
+	/// </summary>
+	/// <param name="index">
+	/// The index of the sink.
+	/// </param>
+	/// <returns>
+	/// The constant reference to the number of times.
+	/// </returns>
+	const uint64_t& getVectoredWrites(uint32_t index) const;
+protected:
+	// The number of bytes written to each sink, of tainted bytes written to
+	// it, of times it was written to and of vectored writes, in this order
+	CounterColumns counters;
+};
+
+/// <summary>
+/// Class which stores the statistics of all of the IPC channels (pipes, 
+/// socketpairs and UNIX sockets) which were read from or written to, whether
+/// or not they are sources or sinks.
+/// </summary>
+class TargetChannels : public TargetStatistics {
+public:
+	/// <summary>
+	/// Creates a new, empty set of channels.
+	/// </summary>
+	TargetChannels() = default;
+
+	/// <summary>
+	/// Adds the specified target to the channels, with all of its statistics
+	/// set to zero. If the target already is a channel, nothing is changed.
+	/// </summary>
+	/// <param name="target">
+	/// The target to be added.
+	/// </param>
+	/// <returns>
+	/// The index of the channel.
+	/// </returns>
+	uint32_t add(const Target &target);
+
+	/// <summary>
+	/// Returns a reference to the number of bytes read from the channel at the
+	/// specified index.
+	/// </summary>
+	/// <param name="index">
+	/// The index of the channel.
+	/// </param>
+	/// <returns>
+	/// The reference to the number of bytes.
+	/// </returns>
+	uint64_t& getBytesRead(uint32_t index);
+
+	/// <summary>
+	/// Returns a constant reference to the number of bytes read from the 
+	/// channel at the specified index.
+	/// </summary>
+	/// <param name="index">
+	/// The index of the channel.
+	/// </param>
+	/// <returns>
+	/// The constant reference to the number of bytes.
+	/// </returns>
+	const uint64_t& getBytesRead(uint32_t index) const;
+
+	/// <summary>
+	/// Returns a reference to the number of bytes written to the channel at
+	/// the specified index.
+	/// </summary>
+	/// <param name="index">
+	/// The index of the channel.
+	/// </param>
+	/// <returns>
+	/// The reference to the number of bytes.
+	/// </returns>
+	uint64_t& getBytesWritten(uint32_t index);
+
+	/// <summary>
+	/// Returns a constant reference to the number of bytes written to the 
+	/// channel at the specified index.
+	/// </summary>
+	/// <param name="index">
+	/// The index of the channel.
+	/// </param>
+	/// <returns>
+	/// The constant reference to the number of bytes.
+	/// </returns>
+	const uint64_t& getBytesWritten(uint32_t index) const;
+
+	/// <summary>
+	/// Returns a reference to the number of times data was read from the 
+	/// channel at the specified index.
+	/// </summary>
+	/// <param name="index">
+	/// The index of the channel.
+	/// </param>
+	/// <returns>
+	/// The reference to the number of times.
+	/// </returns>
+	uint64_t& getReads(uint32_t index);
+
+	/// <summary>
+	/// Returns a constant reference to the number of times data was read from
+	/// the channel at the specified index.
+	/// </summary>
+	/// <param name="index">
+	/// The index of the channel.
+	/// </param>
+	/// <returns>
+	/// The constant reference to the number of times.
+	/// </returns>
+	const uint64_t& getReads(uint32_t index) const;
+
+	/// <summary>
+	/// Returns a reference to the number of times data was written to the 
+	/// channel at the specified index.
+	/// </summary>
+	/// <param name="index">
+	/// The index of the channel.
+	/// </param>
+	/// <returns>
+	/// The reference to the number of times.
+	/// </returns>
+	uint64_t& getWrites(uint32_t index);
+
+	/// <summary>
+	/// Returns a constant reference to the number of times data was written to
+	/// the channel at the specified index.
+	/// </summary>
+	/// <param name="index">
+	/// The index of the channel.
+	/// </param>
+	/// <returns>
+	/// The constant reference to the number of times.
+	/// </returns>
+	const uint64_t& getWrites(uint32_t index) const;
+protected:
+	std::vector<uint64_t> bytesRead;           // # of bytes read from
+	std::vector<uint64_t> bytesWritten;        // # of bytes written to
+	std::vector<uint64_t> reads;               // # of times read from
+	std::vector<uint64_t> writes;              // # of times written to
+};
+
+/// <summary>
+/// Enumeration of the types of the tables of a <see cref="StatsFile"/>.
+/// </summary>
+enum class StatsTable : uint32_t {
+	Sources = 1,                               // Columns of TargetSources
+	Sinks = 2                                  // Columns of TargetSinks
+};
+
+/// <summary>
+/// Class which keeps the counters of the sources and sinks in a memory mapped
+/// file while the replay runs, so that other tools can read the progress of
+/// the replay, and so that the latest counts are left on disk even if the
+/// replay is killed. Counters are updated in place in the mapping, and the
+/// address space of the mapping is reserved up front, so growing the file
+/// never moves the counters.
+///
+/// The file starts with a fixed header of 64 bytes: the magic string 
+/// "FDTSTATS", the 32 bit format version, the 32 bit number of tables, the 64
+/// bit instruction count which the replay reached, the 64 bit number of bytes
+/// used, the 64 bit generation of the directory and 24 reserved bytes. A
+/// directory of 64 byte entries follows, one per table: the 32 bit
+/// <see cref="StatsTable"/> type, the 32 bit number of columns, the 32 bit
+/// index of the configuration, the 32 bit length of its name, the 64 bit
+/// offset of its name, the 64 bit number of rows, the 64 bit number of rows
+/// with room, the 64 bit offset of the columns and 16 reserved bytes. Every
+/// value is in the byte order of the host.
+///
+/// The columns of a table are arrays of 64 bit counters, one per column, each
+/// as long as the number of rows with room. The first column holds the offset
+/// of the name of the target of each row, and the second its kind in the upper
+/// 32 bits and the length of its name in the lower 32 bits. Names are not
+/// null terminated. When a table runs out of room, its columns are copied to
+/// larger arrays at the end of the file, and its entry is pointed to them.
+/// The generation is odd while an entry is pointed elsewhere, so readers 
+/// should read again if the generation was odd or changed while they read.
+/// </summary>
+class StatsFile {
+public:
+	/// <summary>
+	/// Creates a new Stats File, which is not open.
+	/// </summary>
+	StatsFile();
+
+	/// <summary>
+	/// Copying of Stats File instances is forbidden.
+	/// </summary>
+	StatsFile(const StatsFile&) = delete;
+
+	/// <summary>
+	/// Unmaps and closes the stats file, if it is open.
+	/// </summary>
+	~StatsFile();
+
+	/// <summary>
+	/// Adds a table of the specified type to the directory, with no rows.
+	/// </summary>
+	/// <param name="type">
+	/// The type of the table.
+	/// </param>
+	/// <param name="configuration">
+	/// The index of the configuration of the table.
+	/// </param>
+	/// <param name="name">
+	/// The name of the configuration of the table.
+	/// </param>
+	/// <param name="columns">
+	/// The number of columns of the table.
+	/// </param>
+	/// <returns>
+	/// The index of the table, or <see cref="NO_INDEX"/> if the directory is
+	/// full or the name could not be stored.
+	/// </returns>
+	uint32_t addTable(StatsTable type, uint32_t configuration, 
+		const std::string &name, uint32_t columns);
+
+	/// <summary>
+	/// Allocates zeroed space for the specified number of counters at the end
+	/// of the file.
+	/// </summary>
+	/// <param name="counters">
+	/// The number of counters.
+	/// </param>
+	/// <returns>
+	/// The pointer to the counters in the mapping, or null if the file could
+	/// not be grown.
+	/// </returns>
+	uint64_t* allocate(size_t counters);
+
+	/// <summary>
+	/// Flushes the mapping to the file, unmaps it and closes the file. The 
+	/// counters of the tables must not be used afterwards.
+	/// </summary>
+	/// <returns>
+	/// True if the file was flushed and closed successfully, false otherwise.
+	/// </returns>
+	bool close();
+
+	/// <summary>
+	/// Stores the name of the specified target in the file, and returns the
+	/// values of the columns which describe it.
+	/// </summary>
+	/// <param name="target">
+	/// The target.
+	/// </param>
+	/// <param name="name">
+	/// The value to which the offset of the name is written, or zero if the
+	/// name could not be stored.
+	/// </param>
+	/// <param name="kind">
+	/// The value to which the kind and the length of the name are written.
+	/// </param>
+	void describe(const Target &target, uint64_t &name, uint64_t &kind);
+
+	/// <summary>
+	/// Checks if the stats file is open.
+	/// </summary>
+	/// <returns>
+	/// True if the file is open, false otherwise.
+	/// </returns>
+	bool isOpen() const;
+
+	/// <summary>
+	/// Points the entry of the specified table to the specified columns, once
+	/// they hold every row, and advances the generation.
+	/// </summary>
+	/// <param name="table">
+	/// The index of the table.
+	/// </param>
+	/// <param name="data">
+	/// The columns, which were returned by <see cref="allocate"/>.
+	/// </param>
+	/// <param name="capacity">
+	/// The number of rows with room in the columns.
+	/// </param>
+	void moveTable(uint32_t table, const uint64_t *data, size_t capacity);
+
+	/// <summary>
+	/// Creates the specified stats file, reserves the address space of its
+	/// mapping and writes its header.
+	/// </summary>
+	/// <param name="file">
+	/// The name of the stats file.
+	/// </param>
+	/// <param name="targets">
+	/// The table from which the names of targets are fetched, which must 
+	/// outlive the file.
+	/// </param>
+	/// <param name="tables">
+	/// The number of entries of the directory.
+	/// </param>
+	/// <returns>
+	/// True if the file was opened, false otherwise.
+	/// </returns>
+	bool open(const std::string &file, const TargetTable &targets, 
+		uint32_t tables);
+
+	/// <summary>
+	/// Sets the instruction count of the last update of the counters.
+	/// </summary>
+	/// <param name="instruction">
+	/// The instruction count.
+	/// </param>
+	void setInstruction(uint64_t instruction);
+
+	/// <summary>
+	/// Sets the number of rows of the specified table, once they are written.
+	/// </summary>
+	/// <param name="table">
+	/// The index of the table.
+	/// </param>
+	/// <param name="rows">
+	/// The number of rows.
+	/// </param>
+	void setRows(uint32_t table, size_t rows);
+
+	/// <summary>
+	/// Assignment of Stats File instances is forbidden.
+	/// </summary>
+	StatsFile& operator=(const StatsFile&) = delete;
+protected:
+	/// <summary>
+	/// Allocates the specified number of bytes at the end of the file, 
+	/// aligned to eight bytes, growing the file if needed.
+	/// </summary>
+	/// <returns>
+	/// The offset of the bytes, or zero if the file could not be grown.
+	/// </returns>
+	uint64_t reserve(size_t bytes);
+
+	/// <summary>
+	/// Returns a pointer to the 64 bit field at the specified offset of the
+	/// entry of the specified table.
+	/// </summary>
+	uint64_t* getEntry(uint32_t table, size_t offset);
+
+	/// <summary>
+	/// Releases the mapping and the file descriptor of the file.
+	/// </summary>
+	void release();
+
+	static const size_t HEADER_SIZE = 64;      // Size of the File Header
+	static const size_t ENTRY_SIZE = 64;       // Size of a Directory Entry
+
+	int fd;                                    // Stats File Descriptor
+	uint8_t *data;                             // Mapping of the File
+	size_t reserved;                           // Size of the Mapping
+	size_t size;                               // Size of the File
+	size_t position;                           // Next Byte to be Allocated
+	uint32_t tables;                           // # of Directory Entries
+	uint32_t usedTables;                       // # of Tables Added
+	const TargetTable *targets;                // Names of the Targets
+};
+
+#endif
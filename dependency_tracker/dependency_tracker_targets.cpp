@@ -1,178 +1,167 @@
 #include "dependency_tracker_targets.h"
 
-#include <typeinfo>
+#include <algorithm>
+#include <functional>
+#include <stdio.h>
+#include <string.h>
 
-/********************************** TARGET **********************************/
-bool Target::operator==(const Target &rhs) const {
-	return typeid(*this) == typeid(rhs);
-}
+// Size of the buffer in which network target names are formatted. This fits
+// the longest IPv6 address string, the "::" separator and a 16 bit port.
+static const size_t INET6_NAME_SIZE = 64;
 
-bool Target::operator!=(const Target &rhs) const {
-	return typeid(*this) != typeid(rhs);
-}
-
-std::ostream& operator<<(std::ostream &stream, const Target &target) {
-	return stream << target.toString();
-}
 /********************************** TARGET **********************************/
+Target::Target() : Target(TargetKind::None, 0) {
 
-/******************************* TARGET  SINK *******************************/
-TargetSink::TargetSink(std::unique_ptr<Target> target, const size_t &index) {
-	this->target = std::move(target);
-	this->index = index;
-	
-	this->totalBytes = 0;
-	this->totalTaintBytes = 0;
-	this->totalWrites = 0;
 }
 
-const size_t& TargetSink::getIndex() const {
-	return this->index;
+Target::Target(TargetKind kind, uint32_t id) {
+	this->kind = kind;
+	this->id = id;
 }
 
-std::map<uint32_t, uint32_t>& TargetSink::getLabeledBytes() {
-	return this->labeledBytes;
+Target::operator bool() const {
+	return this->kind != TargetKind::None;
 }
 
-const std::map<uint32_t, uint32_t>& TargetSink::getLabeledBytes() const {
-	return this->labeledBytes;
+bool Target::operator==(const Target &rhs) const {
+	return this->kind == rhs.kind && this->id == rhs.id;
 }
 
-const Target& TargetSink::getTarget() const {
-	return *this->target;
+bool Target::operator!=(const Target &rhs) const {
+	return !(this->operator==(rhs));
 }
 
-uint32_t& TargetSink::getTotalBytes() {
-	return this->totalBytes;
+size_t TargetHash::operator()(const Target &target) const {
+	// Hash the kind and identifier as a single 64 bit value, since shifting
+	// the kind past the width of a 32 bit size_t would be undefined
+	uint64_t key = (static_cast<uint64_t>(target.kind) << 32) | target.id;
+	return std::hash<uint64_t>()(key);
 }
+/********************************** TARGET **********************************/
 
-const uint32_t& TargetSink::getTotalBytes() const {
-	return this->totalBytes;
+/******************************* TARGET TABLE *******************************/
+TargetTable::TargetTable() {
+	// Start with a small power of two number of slots, all of them empty
+	this->slots.assign(64, 0);
 }
 
-uint32_t& TargetSink::getTotalTaintBytes() {
-	return this->totalTaintBytes;
+Target TargetTable::find(TargetKind kind, const char *name, 
+		size_t length) const {
+	uint32_t h = TargetTable::hash(kind, name, length);
+	uint32_t slot = this->slots[this->findSlot(kind, name, length, h)];
+	
+	// Zero indicates an empty slot, otherwise the slot holds the ID plus one
+	if (slot == 0) return Target();
+	return Target(kind, slot - 1);
 }
 
-const uint32_t& TargetSink::getTotalTaintBytes() const {
-	return this->totalTaintBytes;
+Target TargetTable::findNetwork(const char *ip, unsigned short port) const {
+	// Format the name the same way as internNetwork does, on the stack
+	char name[INET6_NAME_SIZE];
+	int length = snprintf(name, sizeof(name), "%s::%u", ip, port);
+	if (length < 0) return Target();
+	
+	return this->find(TargetKind::Network, name, 
+		std::min<size_t>(length, sizeof(name) - 1));
 }
 
-uint32_t& TargetSink::getTotalWrites() {
-	return this->totalWrites;
+std::string TargetTable::getName(const Target &target) const {
+	std::lock_guard<std::mutex> guard(this->nameLock);
+	if (!target || target.id >= this->entries.size()) return "";
+	
+	const Entry &entry = this->entries[target.id];
+	return std::string(&this->arena[entry.offset], entry.length);
 }
 
-const uint32_t& TargetSink::getTotalWrites() const {
-	return this->totalWrites;
+Target TargetTable::getTarget(uint32_t id) const {
+	return Target(this->entries[id].kind, id);
 }
 
-/******************************* TARGET  SINK *******************************/
-
-/****************************** TARGET  SOURCE ******************************/
-TargetSource::TargetSource(std::unique_ptr<Target> target, 
-		const size_t &index) {
-	this->target = std::move(target);
-	this->index = index;
+Target TargetTable::intern(TargetKind kind, const char *name, size_t length) {
+	uint32_t h = TargetTable::hash(kind, name, length);
+	size_t index = this->findSlot(kind, name, length, h);
+	if (this->slots[index] != 0) 
+		return Target(kind, this->slots[index] - 1);
 	
-	this->labeledBytes = 0;
+	// The name was not interned yet, copy it to the arena and create a new
+	// entry for it. Either may reallocate, so names must not be read by
+	// another thread meanwhile.
+	Entry entry;
+	entry.offset = this->arena.size();
+	entry.length = length;
+	entry.hash = h;
+	entry.kind = kind;
 	
-	this->totalBytes = 0;
-	this->totalReads = 0;
-}
-
-const size_t& TargetSource::getIndex() const {
-	return this->index;
-}
-
-uint32_t& TargetSource::getLabeledBytes() {
-	return this->labeledBytes;
-}
-
-const uint32_t& TargetSource::getLabeledBytes() const {
-	return this->labeledBytes;
-}
-
-const Target& TargetSource::getTarget() const {
-	return *this->target;
-}
-
-uint32_t& TargetSource::getTotalBytes() {
-	return this->totalBytes;
-}
-
-const uint32_t& TargetSource::getTotalBytes() const {
-	return this->totalBytes;
-}
-
-uint32_t& TargetSource::getTotalReads() {
-	return this->totalReads;
-}
-
-const uint32_t& TargetSource::getTotalReads() const {
-	return this->totalReads;
-}
-
-/****************************** TARGET  SOURCE ******************************/
-
-/******************************* TARGET  FILE *******************************/
-
-TargetFile::TargetFile() : TargetFile("") {
-
-}
-
-TargetFile::TargetFile(const std::string &name) {
-	this->fileName = name;
-}
-
-std::string TargetFile::toString() const {
-	return this->fileName;
-}
-
-TargetFile::operator bool() const {
-	return !this->fileName.empty();
-}
-
-bool TargetFile::operator==(const Target &rhs) const {
-	if (Target::operator!=(rhs)) return false;
-
-	auto rhsTF = static_cast<const TargetFile&>(rhs);
-	return this->fileName == rhsTF.fileName;
-}
-
-bool TargetFile::operator!=(const Target &rhs) const {
-	return !(this->operator==(rhs));
-}
-
-/******************************* TARGET  FILE *******************************/
-
-/****************************** TARGET NETWORK ******************************/
-
-TargetNetwork::TargetNetwork() : TargetNetwork("", 0) {
-
-}
-
-TargetNetwork::TargetNetwork(const std::string &ip, const unsigned int &port) {
-	this->ip = ip;
-	this->port = port;
-}
-
-std::string TargetNetwork::toString() const {
-	return (this->ip + "::" + std::to_string(this->port));
+	std::unique_lock<std::mutex> guard(this->nameLock);
+	this->arena.insert(this->arena.end(), name, name + length);
+	this->entries.push_back(entry);
+	guard.unlock();
+	
+	uint32_t id = this->entries.size() - 1;
+	this->slots[index] = id + 1;
+	
+	// Keep the load factor at or below one half, so probe chains stay short
+	if (this->entries.size() * 2 > this->slots.size()) this->grow();
+	return Target(kind, id);
 }
 
-TargetNetwork::operator bool() const {
-	return !this->ip.empty();
+Target TargetTable::intern(TargetKind kind, const std::string &name) {
+	return this->intern(kind, name.c_str(), name.size());
 }
 
-bool TargetNetwork::operator==(const Target &rhs) const {
-	if (Target::operator!=(rhs)) return false;
-
-	auto rhsTN = static_cast<const TargetNetwork&>(rhs);
-	return this->ip == rhsTN.ip && this->port == rhsTN.port;
+Target TargetTable::internNetwork(const char *ip, unsigned short port) {
+	char name[INET6_NAME_SIZE];
+	int length = snprintf(name, sizeof(name), "%s::%u", ip, port);
+	if (length < 0) return Target();
+	
+	return this->intern(TargetKind::Network, name, 
+		std::min<size_t>(length, sizeof(name) - 1));
 }
 
-bool TargetNetwork::operator!=(const Target &rhs) const {
-	return !(this->operator==(rhs));
+size_t TargetTable::size() const {
+	return this->entries.size();
 }
 
-/****************************** TARGET NETWORK ******************************/
+uint32_t TargetTable::hash(TargetKind kind, const char *name, size_t length) {
+	// 32 bit FNV-1a hash of the kind followed by the name
+	uint32_t h = 2166136261u;
+	h = (h ^ static_cast<uint8_t>(kind)) * 16777619u;
+	for (size_t i = 0; i < length; ++i) {
+		h = (h ^ static_cast<uint8_t>(name[i])) * 16777619u;
+	}
+	
+	return h;
+}
+
+size_t TargetTable::findSlot(TargetKind kind, const char *name, 
+		size_t length, uint32_t hash) const {
+	// Linear probing. The number of slots is always a power of two, so the
+	// mask wraps the index around the slots vector.
+	size_t mask = this->slots.size() - 1;
+	for (size_t index = hash & mask; ; index = (index + 1) & mask) {
+		uint32_t slot = this->slots[index];
+		if (slot == 0) return index;
+		
+		const Entry &entry = this->entries[slot - 1];
+		if (entry.hash == hash && entry.kind == kind && 
+				entry.length == length &&
+				memcmp(&this->arena[entry.offset], name, length) == 0) {
+			return index;
+		}
+	}
+}
+
+void TargetTable::grow() {
+	this->slots.assign(this->slots.size() * 2, 0);
+	
+	// Re-insert each entry by its stored hash. All names are distinct, so an
+	// empty slot is simply searched for.
+	size_t mask = this->slots.size() - 1;
+	for (size_t id = 0; id < this->entries.size(); ++id) {
+		size_t index = this->entries[id].hash & mask;
+		while (this->slots[index] != 0) index = (index + 1) & mask;
+		
+		this->slots[index] = id + 1;
+	}
+}
+/******************************* TARGET TABLE *******************************/
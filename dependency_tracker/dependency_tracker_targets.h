@@ -1,33 +1,54 @@
 #ifndef DEPENDENCY_TRACKER_TARGETS
 #define DEPENDENCY_TRACKER_TARGETS
 
-#include <ostream>
-#include <map>
-#include <memory>
+#include <mutex>
+#include <stdint.h>
 #include <string>
+#include <vector>
 
 /// <summary>
-/// Structure which represents a trackable target.
+/// Enumeration of the kinds of trackable targets.
 /// </summary>
-class Target {
-public:
+enum class TargetKind : uint8_t {
+	None = 0,                                  // Invalid Target
+	File,                                      // File, identified by name
+	Network,                                   // Network, by IP and port
+	Channel                                    // Pipe or Socket, by inode
+};
+
+/// <summary>
+/// Structure which represents a trackable target. A target is a small value
+/// handle into a <see cref="TargetTable"/>: the kind of the target and the
+/// identifier of its interned name. Two targets are equivalent if and only if
+/// they have the same kind and identifier, so comparing and hashing targets
+/// never touches the name strings.
+/// </summary>
+struct Target {
 	/// <summary>
-	/// Simple method which returns a string representation of this Target.
+	/// Creates a new, invalid Target.
 	/// </summary>
-	/// <returns>
-	/// The string in format: "base".
-	/// </returns>
-	virtual std::string toString() const = 0;
-	
+	Target();
+
+	/// <summary>
+	/// Creates a new Target of the specified kind and interned identifier.
+	/// </summary>
+	/// <param name="kind">
+	/// The kind of the target.
+	/// </param>
+	/// <param name="id">
+	/// The identifier of the target's name in its <see cref="TargetTable"/>.
+	/// </param>
+	Target(TargetKind kind, uint32_t id);
+
 	/// <summary>
-	/// Returns true if this Target is valid. The concept of validity is left
-	/// up to interpretation for the derived type.
+	/// Returns true if this Target is valid. A target is valid if its kind is
+	/// not <see cref="TargetKind::None"/>.
 	/// </summary>
 	/// <returns>
 	/// True if the Target is valid, false otherwise.
 	/// </returns>
-	virtual explicit operator bool() const = 0;
-	
+	explicit operator bool() const;
+
 	/// <summary>
 	/// Compares the specified Target instance for equality to this.
 	/// </summary>
@@ -38,7 +59,7 @@ public:
 	/// <returns>
 	/// True if the instances are equivalent, false otherwise.
 	/// </returns>
-	virtual bool operator==(const Target &rhs) const;
+	bool operator==(const Target &rhs) const;
 
 	/// <summary>
 	/// Compares the specified Target instance for inequality to this.
@@ -50,385 +71,203 @@ public:
 	/// <returns>
 	/// True if the instances are inequivalent, false otherwise.
 	/// </returns>
-	virtual bool operator!=(const Target &rhs) const;
-protected:
-	/// <summary>
-	/// Creates a new target.
-	/// </summary>
-	Target() = default;
+	bool operator!=(const Target &rhs) const;
+	TargetKind kind;                           // The kind of this target
+	uint32_t id;                               // ID of the interned name
 };
 
 /// <summary>
-/// Appends the toString() return value of the specified target, to the 
-/// specified output stream and returns it.
+/// Hash functor for Targets, so they may be used as keys of unordered
+/// containers.
 /// </summary>
-/// <param name="stream">
-/// The stream to which the target's toString() contents are to be appended.
-/// </param>
-/// <param name="target">
-/// The target whose string value is to be appended to the stream.
-/// </param>
-/// <returns>
-/// The string stream after target has been appended to it.
-/// </returns>
-std::ostream& operator<<(std::ostream &stream, const Target &target);
-
-/// <summary>
-/// Class which represents a sink target.
-/// </summary>
-class TargetSink {
-public:
+struct TargetHash {
 	/// <summary>
-	/// Constructs a Target Sink with the specified target. The index should
-	/// be equivalent to the index of the Target in its sinks vector.
+	/// Returns the hash of the specified target.
 	/// </summary>
 	/// <param name="target">
-	/// The unique pointer to the target.
-	/// </param>
-	/// <param name="index">
-	/// The index of this Target in the sinks vector.
+	/// The target to be hashed.
 	/// </param>
-	TargetSink(std::unique_ptr<Target> target, const size_t &index);
-
-	/// <summary>
-	/// Copying of Target Source instances is forbidden.
-	/// </summary>
-	TargetSink(const TargetSink&) = delete;
-
-	/// <summary>
-	/// Returns a reference to the index of this target in the sinks vector.
-	/// This is expected to never change since targets are not added nor
-	/// removed after the plugin is initialized.
-	/// </summary>
-	const size_t& getIndex() const;
-
-	/// <summary>
-	/// Returns a reference to the map which maps the source target index to
-	/// how many tainted bytes from said source were written to this sink
-	/// target.
-	/// </summary>
-	/// <returns>
-	/// A reference to the value.
-	/// </returns>
-	std::map<uint32_t, uint32_t>& getLabeledBytes();
-	
-	/// <summary>
-	/// Returns a constant reference to the map which maps the source target 
-	/// index to how many tainted bytes from said source were written to this 
-	/// sink target.
-	/// </summary>
-	/// <returns>
-	/// A constant reference to the value.
-	/// </returns>
-	const std::map<uint32_t, uint32_t>& getLabeledBytes() const;
-
-	/// <summary>
-	/// Gets a constant reference to the target attached to this sink.
-	/// </summary>
-	/// <returns>
-	/// The constant reference to the target.
-	/// </returns>
-	const Target& getTarget() const;
-	
-	/// <summary>
-	/// Returns a reference to the number of bytes written to this sink.
-	/// </summary>
 	/// <returns>
-	/// The reference to the number of bytes.
+	/// The hash value of the target.
 	/// </returns>
-	uint32_t& getTotalBytes();
-	
-	/// <summary>
-	/// Returns a constant reference to the number bytes written to this sink.
-	/// </summary>
-	/// <returns>
-	/// The constant reference to the number of bytes.
-	/// </returns>
-	const uint32_t& getTotalBytes() const;
-	
-	/// <summary>
-	/// Returns a reference to the number of tainted bytes written to this 
-	/// sink.
-	/// </summary>
-	/// <returns>
-	/// The reference to the number of tainted bytes.
-	/// </returns>
-	uint32_t& getTotalTaintBytes();
-	
-	/// <summary>
-	/// Returns a constant reference to the number of tainted bytes written to 
-	/// this sink.
-	/// </summary>
-	/// <returns>
-	/// The constant reference to the number of tainted bytes.
-	/// </returns>
-	const uint32_t& getTotalTaintBytes() const;
-	
-	/// <summary>
-	/// Returns a reference to the number of times this sink was written to.
-	/// </summary>
-	/// <returns>
-	/// The reference to the number of times.
-	/// </returns>
-	uint32_t& getTotalWrites();
-	
-	/// <summary>
-	/// Returns a constant reference to the number of times this sink was 
-	/// written to.
-	/// </summary>
-	/// <returns>
-	/// The constant reference to the number of times.
-	/// </returns>
-	const uint32_t& getTotalWrites() const;
-
-	/// <summary>
-	/// Assignment of Target Source instances is forbidden.
-	/// </summary>
-	TargetSink& operator=(const TargetSink&) = delete;
-protected:
-	std::unique_ptr<Target> target;            // Target attached to this sink
-	size_t index;                              // Index of this in sources list
-
-	std::map<uint32_t, uint32_t> labeledBytes; // Map of source target index to
-	                                           // tainted bytes of said source
-	                                           // written to this.
-	
-	uint32_t totalBytes;                       // # of bytes written to
-	uint32_t totalTaintBytes;                  // # of tainted bytes written to
-	uint32_t totalWrites;                      // # of times written to
+	size_t operator()(const Target &target) const;
 };
 
 /// <summary>
-/// Class which represents a source target.
+/// Class which interns the names of targets (file paths and network
+/// addresses). Each distinct (kind, name) pair is stored once and assigned a
+/// dense identifier, starting at zero. Lookups of names which were already
+/// interned do not allocate any memory.
 /// </summary>
-class TargetSource {
+class TargetTable {
 public:
 	/// <summary>
-	/// Constructs a Target Source with the specified target. The index should
-	/// be equivalent to the index of the Target in its sources vector.
+	/// Creates a new, empty Target Table.
 	/// </summary>
-	/// <param name="target">
-	/// The unique pointer to the target.
-	/// </param>
-	/// <param name="index">
-	/// The index of this Target in the sources vector.
-	/// </param>
-	TargetSource(std::unique_ptr<Target> target, const size_t &index);
+	TargetTable();
 
 	/// <summary>
-	/// Copying of Target Source instances is forbidden.
+	/// Copying of Target Table instances is forbidden.
 	/// </summary>
-	TargetSource(const TargetSource&) = delete;
+	TargetTable(const TargetTable&) = delete;
 
 	/// <summary>
-	/// Returns a reference to the index of this target in the sources vector.
-	/// This is expected to never change since targets are not added nor
-	/// removed after the plugin is initialized.
-	/// </summary>
-	const size_t& getIndex() const;
-
-	/// <summary>
-	/// Returns a reference to the number of labeled bytes of this target.
-	/// This should be set when any data of this source target is labeled.
-	/// </summary>
-	/// <returns>
-	/// A reference to the value.
-	/// </returns>
-	uint32_t& getLabeledBytes();
-	
-	/// <summary>
-	/// Returns a constant reference to the number of labeled bytes of this 
-	/// target. This should be set when any data of this source target is 
-	/// labeled.
+	/// Finds the target with the specified kind and name, without interning
+	/// it if it does not exist.
 	/// </summary>
+	/// <param name="kind">
+	/// The kind of the target.
+	/// </param>
+	/// <param name="name">
+	/// The pointer to the name of the target.
+	/// </param>
+	/// <param name="length">
+	/// The length of the name, in characters.
+	/// </param>
 	/// <returns>
-	/// A constant reference to the value.
+	/// The target, or an invalid target if no such target was interned.
 	/// </returns>
-	const uint32_t& getLabeledBytes() const;
+	Target find(TargetKind kind, const char *name, size_t length) const;
 
 	/// <summary>
-	/// Gets a constant reference to the target attached to this sink.
-	/// </summary>
-	/// <returns>
-	/// The constant reference to the target.
-	/// </returns>
-	const Target& getTarget() const;
-	
-	/// <summary>
-	/// Returns a reference to the number of bytes read from this source.
-	/// </summary>
-	/// <returns>
-	/// The reference to the number of bytes.
-	/// </returns>
-	uint32_t& getTotalBytes();
-	
-	/// <summary>
-	/// Returns a constant reference to the number bytes read from this 
-	/// source.
+	/// Finds the network target with the specified IP address and port,
+	/// without interning it if it does not exist.
 	/// </summary>
+	/// <param name="ip">
+	/// The null terminated IP address string.
+	/// </param>
+	/// <param name="port">
+	/// The port of the network target.
+	/// </param>
 	/// <returns>
-	/// The constant reference to the number of bytes.
+	/// The target, or an invalid target if no such target was interned.
 	/// </returns>
-	const uint32_t& getTotalBytes() const;
-	
+	Target findNetwork(const char *ip, unsigned short port) const;
+
 	/// <summary>
-	/// Returns a reference to the number of times this source was read from.
+	/// Returns the name of the specified target. Unlike the other functions of
+	/// this table, this may be called from a thread other than the one which
+	/// interns targets, such as the logging thread.
 	/// </summary>
+	/// <param name="target">
+	/// The target whose name is to be fetched. Must have been returned by this
+	/// table.
+	/// </param>
 	/// <returns>
-	/// The reference to the number of times.
+	/// The name of the target. For files this is the file name, for networks
+	/// the string in format: "$ip$::$port$". Invalid targets have an empty
+	/// name.
 	/// </returns>
-	uint32_t& getTotalReads();
-	
+	std::string getName(const Target &target) const;
+
 	/// <summary>
-	/// Returns a constant reference to the number of times this source was 
-	/// read from.
+	/// Returns the target with the specified identifier.
 	/// </summary>
+	/// <param name="id">
+	/// The identifier of the target, which must be less than the number of
+	/// targets interned.
+	/// </param>
 	/// <returns>
-	/// The constant reference to the number of times.
+	/// The target.
 	/// </returns>
-	const uint32_t& getTotalReads() const;
-
-	/// <summary>
-	/// Assignment of Target Source instances is forbidden.
-	/// </summary>
-	TargetSource& operator=(const TargetSource&) = delete;
-protected:
-	std::unique_ptr<Target> target;        // The target attached to this src
-	size_t index;                          // Index of this in sources vector
-
-	uint32_t labeledBytes;                 // # of tainted bytes read from
-	
-	uint32_t totalBytes;                   // # of bytes read from
-	uint32_t totalReads;                   // # of times read from
-};
-
-/// <summary>
-/// Structure which represents a trackable file target.
-/// </summary>
-class TargetFile : public Target {
-public:
-	/// <summary>
-	/// Creates a new, invalid TargetFile.
-	/// </summary>
-	TargetFile();
+	Target getTarget(uint32_t id) const;
 
 	/// <summary>
-	/// Creates a new trackable file target with the specified name.
+	/// Interns the target with the specified kind and name, and returns it. If
+	/// the target was already interned, the existing target is returned.
 	/// </summary>
+	/// <param name="kind">
+	/// The kind of the target.
+	/// </param>
 	/// <param name="name">
-	/// The directory and name of the file target.
+	/// The pointer to the name of the target.
 	/// </param>
-	TargetFile(const std::string &name);
-
-	/// <summary>
-	/// Simple method which returns the file name string of this File Target.
-	/// </summary>
-	/// <returns>
-	/// The file name of this File Target.
-	/// </returns>
-	virtual std::string toString() const override;
-	
-	/// <summary>
-	/// Checks if this File Target is valid. A file target is considered valid
-	/// if the file name is non-empty.
-	/// </summary>
-	/// <returns>
-	/// True if the file name of this File Target is non-empty.
-	/// </returns>
-	virtual explicit operator bool() const override;
-	
-	/// <summary>
-	/// Compares the specified Target instance for equality to this.
-	/// </summary>
-	/// <param name="rhs">
-	/// The right hand side of the operator to which this instance is to be
-	/// compared to.
+	/// <param name="length">
+	/// The length of the name, in characters.
 	/// </param>
 	/// <returns>
-	/// True if the instances are equivalent, false otherwise.
+	/// The interned target.
 	/// </returns>
-	virtual bool operator==(const Target &rhs) const override;
+	Target intern(TargetKind kind, const char *name, size_t length);
 
 	/// <summary>
-	/// Compares the specified Target instance for inequality to this.
+	/// Interns the target with the specified kind and name, and returns it. If
+	/// the target was already interned, the existing target is returned.
 	/// </summary>
-	/// <param name="rhs">
-	/// The right hand side of the operator to which this instance is to be
-	/// compared to.
+	/// <param name="kind">
+	/// The kind of the target.
+	/// </param>
+	/// <param name="name">
+	/// The name of the target.
 	/// </param>
 	/// <returns>
-	/// True if the instances are inequivalent, false otherwise.
+	/// The interned target.
 	/// </returns>
-	virtual bool operator!=(const Target &rhs) const override;
-protected:
-	std::string fileName;                      // The File Name of the Target
-};
-
-/// <summary>
-/// Structure which represents a trackable network target.
-/// </summary>
-class TargetNetwork : public Target {
-public:
-	/// <summary>
-	/// Creates a new, invalid TargetNetwork.
-	/// </summary>
-	TargetNetwork();
+	Target intern(TargetKind kind, const std::string &name);
 
 	/// <summary>
-	/// Creates a new trackable network target with the specified name.
+	/// Interns the network target with the specified IP address and port, and
+	/// returns it. The name is formatted on the stack, so this does not
+	/// allocate if the network target was already interned.
 	/// </summary>
 	/// <param name="ip">
-	/// The IP address of the network target.
+	/// The null terminated IP address string.
 	/// </param>
 	/// <param name="port">
 	/// The port of the network target.
 	/// </param>
-	TargetNetwork(const std::string &ip, const unsigned int &port);
+	/// <returns>
+	/// The interned target.
+	/// </returns>
+	Target internNetwork(const char *ip, unsigned short port);
 
 	/// <summary>
-	/// Simple method which returns a string representation of this Network 
-	/// Target.
+	/// Returns the number of targets interned in this table. Target
+	/// identifiers are always less than this value.
 	/// </summary>
 	/// <returns>
-	/// The string in format: "$ip$::$port$".
+	/// The number of targets.
 	/// </returns>
-	virtual std::string toString() const override;
-	
+	size_t size() const;
+
 	/// <summary>
-	/// Checks if this Network Target is valid. A network target is considered
-	/// valid if the IP address string is non-empty.
+	/// Assignment of Target Table instances is forbidden.
 	/// </summary>
-	/// <returns>
-	/// True if the IP address of this Network Target is non-empty.
-	/// </returns>
-	virtual explicit operator bool() const override;
+	TargetTable& operator=(const TargetTable&) = delete;
+protected:
+	/// <summary>
+	/// Structure which stores where an interned name is located in the arena.
+	/// </summary>
+	struct Entry {
+		uint32_t offset;                       // Offset of name in arena
+		uint32_t length;                       // Length of the name
+		uint32_t hash;                         // Hash of the kind and name
+		TargetKind kind;                       // Kind of the target
+	};
 
 	/// <summary>
-	/// Compares the specified Target instance for equality to this.
+	/// Returns the hash of the specified kind and name.
 	/// </summary>
-	/// <param name="rhs">
-	/// The right hand side of the operator to which this instance is to be
-	/// compared to.
-	/// </param>
-	/// <returns>
-	/// True if the instances are equivalent, false otherwise.
-	/// </returns>
-	virtual bool operator==(const Target &rhs) const override;
+	static uint32_t hash(TargetKind kind, const char *name, size_t length);
 
 	/// <summary>
-	/// Compares the specified Target instance for inequality to this.
+	/// Returns the index of the slot which holds the specified kind and name,
+	/// or the index of the empty slot where it should be inserted.
 	/// </summary>
-	/// <param name="rhs">
-	/// The right hand side of the operator to which this instance is to be
-	/// compared to.
-	/// </param>
-	/// <returns>
-	/// True if the instances are inequivalent, false otherwise.
-	/// </returns>
-	virtual bool operator!=(const Target &rhs) const override;
-protected:
-	std::string ip;                            // The IP Address of the Target
-	unsigned short port;                       // The Port of the Target
+	size_t findSlot(TargetKind kind, const char *name, size_t length,
+		uint32_t hash) const;
+
+	/// <summary>
+	/// Doubles the number of slots and re-inserts all of the entries.
+	/// </summary>
+	void grow();
+
+	std::vector<char> arena;                   // Storage of all of the names
+	std::vector<Entry> entries;                // { Target ID -> Entry }
+	std::vector<uint32_t> slots;               // Hash slots of (Target ID+1)
+	                                           // or zero if the slot is empty
+	mutable std::mutex nameLock;               // Guards arena and entries
+	                                           // against concurrent getName
 };
 
 #endif
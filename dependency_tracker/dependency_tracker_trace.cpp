@@ -0,0 +1,245 @@
+#include "dependency_tracker_trace.h"
+
+#include <algorithm>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// Size which the trace file is pre-allocated to, and grown by at least
+static const size_t TRACE_CHUNK_SIZE = 16 << 20;
+
+/******************************* EVENT  TRACE *******************************/
+EventTrace::EventTrace() {
+	this->fd = -1;
+	this->data = nullptr;
+	this->capacity = 0;
+	this->position = 0;
+	this->failed = false;
+	this->records = 0;
+	this->lastInstruction = 0;
+	this->lastAsid = 0;
+}
+
+EventTrace::~EventTrace() {
+	this->release();
+}
+
+void EventTrace::addSource(uint64_t instruction, uint64_t asid, uint32_t fd,
+		const Target &target, uint64_t length, uint64_t tainted,
+		uint32_t label) {
+	if (!this->reserve(8 * MAX_VARINT)) return;
+
+	this->addHeader(TraceRecord::Source, instruction, asid, fd, target,
+		length, tainted);
+	this->put(label);
+	this->updateHeader();
+}
+
+void EventTrace::addSink(uint64_t instruction, uint64_t asid, uint32_t fd,
+		const Target &target, uint64_t length,
+		const LabelHistogram &histogram) {
+	this->addHistogram(TraceRecord::Sink, instruction, asid, fd, target,
+		length, histogram);
+}
+
+void EventTrace::addWrite(uint64_t instruction, uint64_t asid, uint32_t fd,
+		const Target &target, uint64_t length,
+		const LabelHistogram &histogram) {
+	this->addHistogram(TraceRecord::Write, instruction, asid, fd, target,
+		length, histogram);
+}
+
+bool EventTrace::close(const TargetTable &targets,
+		const std::vector<std::pair<uint32_t, Target>> &labels) {
+	if (!this->isOpen()) {
+		this->release();
+		return false;
+	}
+	uint64_t tableOffset = this->position;
+
+	// Append the names of the targets and the owners of the labels, so the
+	// trace can be read without the lists it was recorded with.
+	bool written = this->reserve(MAX_VARINT);
+	if (written) this->put(targets.size());
+	for (uint32_t id = 0; written && id < targets.size(); ++id) {
+		Target target = targets.getTarget(id);
+		std::string name = targets.getName(target);
+
+		written = this->reserve(2 * MAX_VARINT + name.size());
+		if (!written) break;
+
+		this->put(static_cast<uint8_t>(target.kind));
+		this->put(name.size());
+		memcpy(this->data + this->position, name.data(), name.size());
+		this->position += name.size();
+	}
+
+	if (written) written = this->reserve(MAX_VARINT);
+	if (written) this->put(labels.size());
+	for (size_t i = 0; written && i < labels.size(); ++i) {
+		written = this->reserve(2 * MAX_VARINT);
+		if (!written) break;
+
+		const Target &source = labels[i].second;
+		this->put(labels[i].first);
+		this->put((static_cast<uint64_t>(source.id) << 2) |
+			static_cast<uint8_t>(source.kind));
+	}
+
+	// Fill in the offset of the table last, so that a trace which was cut
+	// short is never mistaken for a complete one.
+	if (written) {
+		memcpy(this->data + 32, &tableOffset, sizeof(tableOffset));
+		written = msync(this->data, this->position, MS_SYNC) == 0;
+	}
+
+	// Drop the pre-allocated bytes which were never used
+	size_t size = this->position;
+	int file = this->fd;
+	munmap(this->data, this->capacity);
+	this->data = nullptr;
+	this->fd = -1;
+
+	if (ftruncate(file, size) != 0) written = false;
+	if (::close(file) != 0) written = false;
+	return written;
+}
+
+uint64_t EventTrace::getBytes() const {
+	return (this->position > HEADER_SIZE) ? this->position - HEADER_SIZE : 0;
+}
+
+uint64_t EventTrace::getRecords() const {
+	return this->records;
+}
+
+bool EventTrace::isOpen() const {
+	return this->data != nullptr;
+}
+
+bool EventTrace::open(const std::string &file) {
+	this->release();
+
+	this->fd = ::open(file.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (this->fd < 0) return false;
+
+	this->failed = false;
+	this->records = 0;
+	this->lastInstruction = 0;
+	this->lastAsid = 0;
+
+	this->position = HEADER_SIZE;
+	if (!this->reserve(TRACE_CHUNK_SIZE - HEADER_SIZE)) {
+		this->release();
+		return false;
+	}
+
+	// Write the header up front, with no records and no table yet
+	const uint32_t version = 1;
+	const uint32_t reserved = 0;
+	memcpy(this->data, "FDTTRACE", 8);
+	memcpy(this->data + 8, &version, sizeof(version));
+	memcpy(this->data + 12, &reserved, sizeof(reserved));
+	this->updateHeader();
+	return true;
+}
+
+void EventTrace::addHeader(TraceRecord type, uint64_t instruction,
+		uint64_t asid, uint32_t fd, const Target &target, uint64_t length,
+		uint64_t tainted) {
+	// The ASID may go either way, so its delta is zigzag encoded
+	int64_t asidDelta = static_cast<int64_t>(asid - this->lastAsid);
+
+	this->put(static_cast<uint8_t>(type));
+	this->put(instruction - this->lastInstruction);
+	this->put((static_cast<uint64_t>(asidDelta) << 1) ^
+		static_cast<uint64_t>(asidDelta >> 63));
+	this->put(fd);
+	this->put((static_cast<uint64_t>(target.id) << 2) |
+		static_cast<uint8_t>(target.kind));
+	this->put(length);
+	this->put(tainted);
+
+	this->lastInstruction = instruction;
+	this->lastAsid = asid;
+	++this->records;
+}
+
+void EventTrace::addHistogram(TraceRecord type, uint64_t instruction,
+		uint64_t asid, uint32_t fd, const Target &target, uint64_t length,
+		const LabelHistogram &histogram) {
+	auto &labels = histogram.getLabels();
+	if (!this->reserve((8 + 2 * labels.size()) * MAX_VARINT)) return;
+
+	uint64_t tainted = 0;
+	for (auto label : labels) tainted += histogram.getCount(label);
+
+	this->addHeader(type, instruction, asid, fd, target, length, tainted);
+	this->put(labels.size());
+	for (auto label : labels) {
+		this->put(label);
+		this->put(histogram.getCount(label));
+	}
+	this->updateHeader();
+}
+
+void EventTrace::put(uint64_t value) {
+	uint8_t *out = this->data + this->position;
+	while (value >= 0x80) {
+		*out++ = static_cast<uint8_t>(value) | 0x80;
+		value >>= 7;
+	}
+	*out++ = static_cast<uint8_t>(value);
+
+	this->position = out - this->data;
+}
+
+bool EventTrace::reserve(size_t bytes) {
+	if (this->fd < 0 || this->failed) return false;
+	if (this->position + bytes <= this->capacity) return true;
+
+	// Grow the file by doubling, and by at least a chunk, then map it again
+	size_t capacity = std::max(this->capacity * 2,
+		this->capacity + TRACE_CHUNK_SIZE);
+	while (capacity < this->position + bytes) capacity *= 2;
+
+	if (this->data) munmap(this->data, this->capacity);
+	this->data = nullptr;
+
+	void *data = MAP_FAILED;
+	if (ftruncate(this->fd, capacity) == 0) {
+		data = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED,
+			this->fd, 0);
+	}
+
+	// Stop recording if the file could not be grown. The records written so
+	// far stay in the file, and are counted by the header, but the table is
+	// never written.
+	if (data == MAP_FAILED) {
+		this->failed = true;
+		this->capacity = 0;
+		return false;
+	}
+
+	this->data = static_cast<uint8_t*>(data);
+	this->capacity = capacity;
+	return true;
+}
+
+void EventTrace::release() {
+	if (this->data) munmap(this->data, this->capacity);
+	if (this->fd >= 0) ::close(this->fd);
+
+	this->data = nullptr;
+	this->fd = -1;
+	this->capacity = 0;
+	this->position = 0;
+}
+
+void EventTrace::updateHeader() {
+	uint64_t recordBytes = this->position - HEADER_SIZE;
+	memcpy(this->data + 16, &this->records, sizeof(this->records));
+	memcpy(this->data + 24, &recordBytes, sizeof(recordBytes));
+}
+/******************************* EVENT  TRACE *******************************/
@@ -0,0 +1,258 @@
+#ifndef DEPENDENCY_TRACKER_TRACE
+#define DEPENDENCY_TRACKER_TRACE
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "dependency_tracker_flows.h"
+#include "dependency_tracker_targets.h"
+
+/// <summary>
+/// Enumeration of the types of the records of an <see cref="EventTrace"/>.
+/// </summary>
+enum class TraceRecord : uint8_t {
+	Source = 0,                                // Source was Labeled
+	Sink = 1,                                  // Sink was Queried
+	Write = 2                                  // Other Target was Written
+};
+
+/// <summary>
+/// Class which records every labeling of a source and every query of a sink
+/// to a binary trace file. The file is pre-allocated and memory mapped, and
+/// is grown by doubling, so that appending a record is a few stores into the
+/// mapping rather than a write through a stream.
+///
+/// The file starts with a fixed header of six little endian fields: the magic
+/// string "FDTTRACE", the 32 bit format version, 32 reserved bits, the 64 bit
+/// number of records, the 64 bit length of the records, in bytes, and the 64
+/// bit offset of the table which follows them. The header is written when the
+/// trace is opened, and its counts are kept up to date as records are
+/// appended, but the offset of the table stays zero until the trace is
+/// closed, so that the records of a trace which was never closed can still
+/// be read.
+///
+/// The records follow the header. Every field of a record is an unsigned
+/// LEB128 varint, and signed fields are zigzag encoded. A record holds its
+/// <see cref="TraceRecord"/> type, the instruction count as a delta from the
+/// previous record, the ASID as a signed delta from the previous record, the
+/// file descriptor, the target packed as its ID shifted left by two bits and
+/// or'ed with its kind, the length of the I/O and the number of tainted
+/// bytes. A source record then holds the label applied. A sink or a write
+/// record then holds its histogram: the number of labels found, followed by
+/// each label and the number of bytes it tainted.
+///
+/// The table holds the number of targets, followed by the kind, the length
+/// and the characters of the name of each target, by ID. It then holds the
+/// number of labels, followed by the configuration index and the packed
+/// source target which own each label, by label.
+/// </summary>
+class EventTrace {
+public:
+	/// <summary>
+	/// Creates a new Event Trace, which is not open.
+	/// </summary>
+	EventTrace();
+
+	/// <summary>
+	/// Copying of Event Trace instances is forbidden.
+	/// </summary>
+	EventTrace(const EventTrace&) = delete;
+
+	/// <summary>
+	/// Unmaps and closes the trace file, if it is open, without writing its
+	/// table.
+	/// </summary>
+	~EventTrace();
+
+	/// <summary>
+	/// Appends a record of a labeling of a source.
+	/// </summary>
+	/// <param name="instruction">
+	/// The instruction count at which the source was read.
+	/// </param>
+	/// <param name="asid">
+	/// The ASID of the process which read the source.
+	/// </param>
+	/// <param name="fd">
+	/// The file descriptor from which the source was read.
+	/// </param>
+	/// <param name="target">
+	/// The target of the source.
+	/// </param>
+	/// <param name="length">
+	/// The number of bytes read.
+	/// </param>
+	/// <param name="tainted">
+	/// The number of bytes labeled.
+	/// </param>
+	/// <param name="label">
+	/// The label applied.
+	/// </param>
+	void addSource(uint64_t instruction, uint64_t asid, uint32_t fd,
+		const Target &target, uint64_t length, uint64_t tainted,
+		uint32_t label);
+
+	/// <summary>
+	/// Appends a record of a query of a sink, with the labels found.
+	/// </summary>
+	/// <param name="instruction">
+	/// The instruction count at which the sink was written.
+	/// </param>
+	/// <param name="asid">
+	/// The ASID of the process which wrote the sink.
+	/// </param>
+	/// <param name="fd">
+	/// The file descriptor to which the sink was written.
+	/// </param>
+	/// <param name="target">
+	/// The target of the sink.
+	/// </param>
+	/// <param name="length">
+	/// The number of bytes written.
+	/// </param>
+	/// <param name="histogram">
+	/// The histogram of the labels found in the bytes written.
+	/// </param>
+	void addSink(uint64_t instruction, uint64_t asid, uint32_t fd,
+		const Target &target, uint64_t length,
+		const LabelHistogram &histogram);
+
+	/// <summary>
+	/// Appends a record of a write to a target which is not a sink, with the
+	/// labels found, so that the target can be analyzed as a sink offline.
+	/// </summary>
+	/// <param name="instruction">
+	/// The instruction count at which the target was written.
+	/// </param>
+	/// <param name="asid">
+	/// The ASID of the process which wrote the target.
+	/// </param>
+	/// <param name="fd">
+	/// The file descriptor to which the target was written.
+	/// </param>
+	/// <param name="target">
+	/// The target.
+	/// </param>
+	/// <param name="length">
+	/// The number of bytes written.
+	/// </param>
+	/// <param name="histogram">
+	/// The histogram of the labels found in the bytes written.
+	/// </param>
+	void addWrite(uint64_t instruction, uint64_t asid, uint32_t fd,
+		const Target &target, uint64_t length,
+		const LabelHistogram &histogram);
+
+	/// <summary>
+	/// Writes the table of the trace and its offset in the header, truncates
+	/// the file to the bytes used and closes it.
+	/// </summary>
+	/// <param name="targets">
+	/// The table of the targets referenced by the records.
+	/// </param>
+	/// <param name="labels">
+	/// The configuration index and the source target which own each label,
+	/// by label.
+	/// </param>
+	/// <returns>
+	/// True if the trace was written successfully, false otherwise.
+	/// </returns>
+	bool close(const TargetTable &targets,
+		const std::vector<std::pair<uint32_t, Target>> &labels);
+
+	/// <summary>
+	/// Returns the number of bytes appended, including the table once the
+	/// trace is closed.
+	/// </summary>
+	/// <returns>
+	/// The number of bytes.
+	/// </returns>
+	uint64_t getBytes() const;
+
+	/// <summary>
+	/// Returns the number of records appended.
+	/// </summary>
+	/// <returns>
+	/// The number of records.
+	/// </returns>
+	uint64_t getRecords() const;
+
+	/// <summary>
+	/// Checks if the trace file is open.
+	/// </summary>
+	/// <returns>
+	/// True if the trace is open, false otherwise.
+	/// </returns>
+	bool isOpen() const;
+
+	/// <summary>
+	/// Creates the specified trace file, pre-allocates and maps it.
+	/// </summary>
+	/// <param name="file">
+	/// The name of the trace file.
+	/// </param>
+	/// <returns>
+	/// True if the trace was opened, false otherwise.
+	/// </returns>
+	bool open(const std::string &file);
+
+	/// <summary>
+	/// Assignment of Event Trace instances is forbidden.
+	/// </summary>
+	EventTrace& operator=(const EventTrace&) = delete;
+protected:
+	/// <summary>
+	/// Appends the header fields which all records share.
+	/// </summary>
+	void addHeader(TraceRecord type, uint64_t instruction, uint64_t asid,
+		uint32_t fd, const Target &target, uint64_t length,
+		uint64_t tainted);
+
+	/// <summary>
+	/// Appends a record of the specified type which ends with a histogram.
+	/// </summary>
+	void addHistogram(TraceRecord type, uint64_t instruction, uint64_t asid,
+		uint32_t fd, const Target &target, uint64_t length,
+		const LabelHistogram &histogram);
+
+	/// <summary>
+	/// Appends the specified value as an unsigned LEB128 varint. The space
+	/// must have been reserved.
+	/// </summary>
+	void put(uint64_t value);
+
+	/// <summary>
+	/// Ensures that the specified number of bytes can be appended, growing
+	/// and remapping the file if needed.
+	/// </summary>
+	bool reserve(size_t bytes);
+
+	/// <summary>
+	/// Releases the mapping and the file descriptor of the trace.
+	/// </summary>
+	void release();
+
+	/// <summary>
+	/// Stores the number and the length of the records appended in the
+	/// header.
+	/// </summary>
+	void updateHeader();
+
+	static const size_t HEADER_SIZE = 40;      // Size of the File Header
+	static const size_t MAX_VARINT = 10;       // Longest 64 bit Varint
+
+	int fd;                                    // Trace File Descriptor
+	uint8_t *data;                             // Mapping of the File
+	size_t capacity;                           // Size of the Mapping
+	size_t position;                           // Next Byte to be Written
+	bool failed;                               // Was a Record Lost?
+
+	uint64_t records;                          // # of Records Appended
+	uint64_t lastInstruction;                  // Instruction of Last Record
+	uint64_t lastAsid;                         // ASID of Last Record
+};
+
+#endif